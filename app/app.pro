@@ -1,4 +1,4 @@
-QT       += core gui multimedia
+QT       += core gui multimedia concurrent
 
 CONFIG += c++17
 
@@ -12,20 +12,68 @@ DEFINES += QT_DEPRECATED_WARNINGS
 SOURCES += \
         main.cpp \
         narrativedirector.cpp \
+        teleprompterview.cpp \
         utilities/paragraphretriever.cpp \
     preferences.cpp \
-    utilities/recordedpartstracker.cpp
+    utilities/recordedpartstracker.cpp \
+    utilities/takebuffer.cpp \
+    utilities/partprober.cpp \
+    utilities/waveheader.cpp \
+    utilities/narrationstats.cpp \
+    utilities/partspack.cpp \
+    utilities/partcompressor.cpp \
+    utilities/recordingsplitter.cpp \
+    utilities/projectfile.cpp \
+    utilities/paragraphcounter.cpp \
+    utilities/partslist.cpp \
+    utilities/chapterlist.cpp \
+    utilities/projectjournal.cpp \
+    utilities/paragraphclaims.cpp \
+    utilities/paragraphreader.cpp \
+    utilities/tracer.cpp \
+    utilities/diagnosticsreport.cpp \
+    utilities/stallmonitor.cpp \
+    utilities/audiocapabilities.cpp \
+    utilities/importedtext.cpp \
+    utilities/markupstripper.cpp \
+    utilities/ziparchive.cpp
 
 HEADERS += \
         narrativedirector.h \
+        teleprompterview.h \
         utilities/paragraphretriever.h \
     preferences.h \
-    utilities/recordedpartstracker.h
+    utilities/recordedpartstracker.h \
+    utilities/takebuffer.h \
+    utilities/partprober.h \
+    utilities/waveheader.h \
+    utilities/narrationstats.h \
+    utilities/partspack.h \
+    utilities/partcompressor.h \
+    utilities/recordingsplitter.h \
+    utilities/projectfile.h \
+    utilities/paragraphcounter.h \
+    utilities/partslist.h \
+    utilities/chapterlist.h \
+    utilities/projectjournal.h \
+    utilities/paragraphclaims.h \
+    utilities/paragraphreader.h \
+    utilities/tracer.h \
+    utilities/diagnosticsreport.h \
+    utilities/stallmonitor.h \
+    utilities/audiocapabilities.h \
+    utilities/importedtext.h \
+    utilities/markupstripper.h \
+    utilities/ziparchive.h
 
 FORMS += \
         narrativedirector.ui \
     preferences.ui
 
+# EPUB chapters are inflated with zlib, which Qt bundles on Windows.
+unix: LIBS += -lz
+win32: INCLUDEPATH += $$[QT_INSTALL_HEADERS]/QtZlib
+
 DESTDIR = $$PWD/../build
 
 INCLUDEPATH += \
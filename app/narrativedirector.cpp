@@ -1,7 +1,16 @@
 #include "narrativedirector.h"
 #include "ui_narrativedirector.h"
 
+#include <QApplication>
+#include <QDialog>
+#include <QDialogButtonBox>
+#include <QFontDatabase>
 #include <QInputDialog>
+#include <QPlainTextEdit>
+#include <QPushButton>
+#include <QStatusBar>
+#include <QVBoxLayout>
+#include <QtConcurrent>
 
 NarrativeDirector::NarrativeDirector(QWidget *parent)
     : QMainWindow(parent), ui(new Ui::NarrativeDirector) {
@@ -11,8 +20,68 @@ NarrativeDirector::NarrativeDirector(QWidget *parent)
     audioPlayer = new QMediaPlayer(this);
     preferences = new Preferences(this, audioRecorder);
 
+    audioProbe = new QAudioProbe(this);
+    if (audioProbe->setSource(audioRecorder)) {
+        connect(audioProbe, &QAudioProbe::audioBufferProbed, this,
+                &NarrativeDirector::onAudioBufferProbed);
+    }
+
+    partsWatcher = new QFileSystemWatcher(this);
+    partsScanTimer = new QTimer(this);
+    partsScanTimer->setSingleShot(true);
+    partsScanTimer->setInterval(500);
+
+    connect(partsWatcher, &QFileSystemWatcher::directoryChanged,
+            partsScanTimer, QOverload<>::of(&QTimer::start));
+    connect(partsScanTimer, &QTimer::timeout, this,
+            &NarrativeDirector::onRecordingDirectoryChanged);
+
+    partProber = new PartProber(this);
+    connect(partProber, &PartProber::partProbed, this,
+            &NarrativeDirector::onPartProbed);
+    connect(&wordCountWatcher,
+            &QFutureWatcher<ParagraphCounter::Counts>::finished, this,
+            &NarrativeDirector::onWordCountsFinished);
+
+    statsLbl = new QLabel(this);
+    statusBar()->addPermanentWidget(statsLbl);
+
+    partCompressor = new PartCompressor(this);
+    connect(&unifyWatcher, &QFutureWatcher<bool>::finished, this,
+            &NarrativeDirector::onPartsUnified);
+    idleTimer = new QTimer(this);
+    idleTimer->setSingleShot(true);
+    idleTimer->setInterval(60 * 1000);
+    connect(idleTimer, &QTimer::timeout, this, &NarrativeDirector::onIdle);
+
+    stallMonitor = new StallMonitor(this);
+    stallMonitor->start();
+
+    // The heartbeat beats on its own thread, so that the other sessions do
+    // not take this one for stale while the GUI is busy.
+    claimsTimer = new QTimer;
+    claimsTimer->setInterval(ParagraphClaims::heartbeatIntervalMs);
+    claimsTimer->moveToThread(&claimsThread);
+    connect(claimsTimer, &QTimer::timeout, claimsTimer,
+            [this]() { paragraphClaims.heartbeat(); });
+    connect(&claimsThread, &QThread::finished, claimsTimer,
+            &QObject::deleteLater);
+    claimsThread.start();
+
+    teleprompter = new TeleprompterView(this);
+    teleprompter->setParagraphSource(
+        [this](int prgIndex) { return getTeleprompterParagraph(prgIndex); });
+    teleprompter->hide();
+    ui->gridLayout->addWidget(teleprompter, 1, 0, 1, 3);
+
+    findPrgsTimer = new QTimer(this);
+    connect(findPrgsTimer, &QTimer::timeout, this,
+            &NarrativeDirector::findParagraphsAhead);
+
     connect(audioRecorder, &QAudioRecorder::stateChanged, this,
             &NarrativeDirector::onARStateChanged);
+    connect(audioRecorder, &QAudioRecorder::statusChanged, this,
+            &NarrativeDirector::onARStatusChanged);
     connect(audioRecorder, &QAudioRecorder::durationChanged, this,
             &NarrativeDirector::updateAEnd);
 
@@ -32,6 +101,10 @@ NarrativeDirector::~NarrativeDirector() {
     if (narrativeFile.isOpen())
         narrativeFile.close();
 
+    claimsThread.quit();
+    claimsThread.wait();
+
+    delete audioProbe;
     delete audioRecorder;
     delete audioPlayer;
     delete ui;
@@ -48,28 +121,46 @@ void NarrativeDirector::on_actionOpen_triggered() {
         saveToProjectFile();
     }
 
-    QString fileName = QFileDialog::getOpenFileName(this, tr("Open Text File"),
-                                                    QDir::currentPath(),
-                                                    tr("Text files (*.txt)"));
+    QString fileName = QFileDialog::getOpenFileName(
+        this, tr("Open Text File"), QDir::currentPath(),
+        tr("Texts (*.txt *.epub *.html *.htm *.xhtml *.md *.markdown)"));
 
     if (fileName.isNull())
         return;
+
+    TraceScope traceScope("open text");
     if (narrativeFile.isOpen())
         narrativeFile.close();
 
-    narrativeFile.setFileName(fileName);
-    if (!narrativeFile.open(QIODevice::ReadOnly | QIODevice::Text))
+    if (ImportedText::openTextDevice(fileName, narrativeFile, importedText) ==
+        nullptr) {
+        if (ImportedText::isImported(fileName))
+            showErrorMsg("Could not import " + fileName + ": " +
+                         importedText.errorString());
         return;
+    }
 
-    QString fileNameNoExt = QFileInfo(narrativeFile).fileName();
-    fileNameNoExt = fileNameNoExt.left(fileNameNoExt.lastIndexOf("."));
-
-    QFileInfo checkProjectFile(getRecordingPath() + "/" + fileNameNoExt +
-                               ".ndp");
+    audioPlayer->setMedia(nullptr);
+    recentTake.clear();
+    isFinishingTake = false;
+    partProber->cancel();
+    partCompressor->stop();
+    partsPack.close();
+    pendingPackPart = -1;
+    projectJournal.close();
+    stopClaimsHeartbeat();
+    paragraphClaims.close();
+    findPrgsTimer->stop();
+    teleprompterTarget = -1;
+    teleprompter->refresh();
+
+    QFileInfo checkProjectFile(ProjectFile::getProjectFilePath(fileName));
     if (checkProjectFile.exists() && checkProjectFile.isFile()) {
         cleanPrgs();
 
         loadFromProjectFile(checkProjectFile.filePath());
+        watchRecordingPath();
+        joinClaims();
         updatePlayerInfo();
 
         ui->recordBtn->setEnabled(true);
@@ -79,11 +170,16 @@ void NarrativeDirector::on_actionOpen_triggered() {
     prgNum = 0;
     filePos = 0;
 
-    narrativeInput.setDevice(&narrativeFile);
+    narrativeInput.setDevice(getTextDevice());
     narrativeInput.setCodec("UTF-8");
 
     cleanPrgs();
     prgNumTotal = getNumPrgs();
+    recordedParts.clear();
+    isPackStorage = false;
+    ui->actionStore_Parts_In_Pack_File->setChecked(false);
+    watchRecordingPath();
+    joinClaims();
     updatePlayerInfo();
 
     ui->recordBtn->setEnabled(true);
@@ -107,40 +203,444 @@ void NarrativeDirector::on_actionExport_Parts_File_triggered() {
         return;
     }
 
-    QFile partsFile(recordingPath + "/" + "parts-list.txt");
-    if (!partsFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
+    int firstUnrecorded =
+        recordedParts.getFirstUnrecorded(static_cast<uint>(paragraphs.length()));
+    if (firstUnrecorded != -1) {
+        auto answer = QMessageBox::warning(
+            this, "Missing Parts",
+            QString("Paragraph %1 has not been recorded yet. Export anyway?")
+                .arg(firstUnrecorded + 1),
+            QMessageBox::Yes | QMessageBox::No);
+
+        if (answer != QMessageBox::Yes)
+            return;
+    }
+
+    // Packed parts are listed as byte ranges of the pack, so compacting
+    // first keeps the list valid for as long as possible.
+    if (isPackStorage) {
+        partProber->cancel();
+        partsPack.compactIfNeeded();
+        refreshPartStats();
+    }
+
+    // Parts being compressed are listed once that is done.
+    if (!isPackStorage && unifyPartFormats(paragraphs.length()))
+        return;
+
+    writeExportLists();
+}
+
+void NarrativeDirector::writeExportLists() {
+    const QString recordingPath = getRecordingPath();
+    if (!isPackStorage &&
+        PartCompressor::hasMixedFormats(recordedParts,
+                                        static_cast<uint>(paragraphs.length())))
+        showErrorMsg("Some parts could not be converted to the format of the "
+                     "others, so ffmpeg may not be able to join them.");
+
+    const QString listPath = PartsList::getListPath(recordingPath);
+    bool isListWritten = false;
+    if (isPackStorage) {
+        isListWritten = PartsList::writePacked(
+            listPath, partsPack, 0, static_cast<uint>(paragraphs.length()));
+    } else {
+        QStringList partPaths;
+        for (int i = 0; i < paragraphs.length(); i++)
+            partPaths.append(getPartPath(static_cast<uint>(i)));
+
+        isListWritten = PartsList::writeFiles(listPath, partPaths);
+    }
+
+    if (!isListWritten) {
         showErrorMsg("File error for parts-list.txt creation");
         return;
     }
 
-    QTextStream fileOutput(&partsFile);
-    for (int i = 0; i < paragraphs.length(); i++) {
-        QString recordingFileName =
-            "part" + QString::number(i) + audioExtension;
+    QString message = "parts-list.txt created successfully.";
+    if (!chapters.isEmpty()) {
+        if (!writeChapterLists(static_cast<uint>(paragraphs.length()))) {
+            showErrorMsg("File error for chapter parts list creation");
+            return;
+        }
+
+        message += QString(" Each of the %1 chapters got a parts list of its "
+                           "own, and chapters.txt marks where they start for "
+                           "ffmpeg's -map_chapters.")
+                       .arg(chapters.length());
+    }
+
+    if (isPackStorage)
+        message += " The parts are read out of the pack file, so ffmpeg "
+                   "needs -safe 0 -protocol_whitelist file,subfile.";
+
+    QMessageBox::information(this, "Success", message);
+}
+
+// Lists the parts of each chapter, and writes the metadata that marks where
+// each one starts in the joined book.
+bool NarrativeDirector::writeChapterLists(uint numPrgs) {
+    const QString recordingPath = getRecordingPath();
+
+    for (int chapter = 0; chapter < chapters.length(); chapter++) {
+        const QString listPath =
+            PartsList::getChapterListPath(recordingPath, chapter);
+        const uint firstPrg = chapters[chapter].firstPrg;
+        const uint endPrg = ChapterList::getEndPrg(chapters, chapter, numPrgs);
+
+        bool isListWritten = false;
+        if (isPackStorage) {
+            isListWritten =
+                PartsList::writePacked(listPath, partsPack, firstPrg, endPrg);
+        } else {
+            QStringList partPaths;
+            for (uint part = firstPrg; part < endPrg; part++)
+                partPaths.append(getPartPath(part));
+
+            isListWritten = PartsList::writeFiles(listPath, partPaths);
+        }
+
+        if (!isListWritten)
+            return false;
+    }
+
+    return ChapterList::writeMetadata(
+        ChapterList::getMetadataPath(recordingPath),
+        ProjectFile::getBookName(narrativeFile.fileName()), chapters,
+        recordedParts.getDurationsMs(numPrgs));
+}
+
+// Splits a chapter recorded in one take into parts for the paragraphs it
+// covers, starting with the current one.
+void NarrativeDirector::on_actionImport_Long_Recording_triggered() {
+    if (paragraphs.length() == 0 ||
+        audioRecorder->state() != QAudioRecorder::StoppedState ||
+        pendingPackPart != -1)
+        return;
+
+    QString longRecordingPath = QFileDialog::getOpenFileName(
+        this, "Import Long Recording", QDir::homePath(), "WAV Files (*.wav)");
+    if (longRecordingPath.isEmpty())
+        return;
+
+    bool isNumChosen = false;
+    int maxParts = qMin(static_cast<int>(prgNumTotal) - prgNum,
+                        RecordingSplitter::maxParts);
+    int numParts = QInputDialog::getInt(
+        this, "Import Long Recording",
+        QString("Paragraphs in the recording, starting at paragraph %1:")
+            .arg(prgNum + 1),
+        maxParts, 1, maxParts, 1, &isNumChosen);
+    if (!isNumChosen)
+        return;
+
+    RecordingSplitter splitter(longRecordingPath);
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    bool isAnalyzed = splitter.open() && splitter.detectSilences();
+    QApplication::restoreOverrideCursor();
+
+    if (!isAnalyzed) {
+        showErrorMsg(splitter.getErrorString());
+        return;
+    }
+
+    // Paragraphs that were not counted yet are split evenly instead.
+    QVector<quint32> wordCounts =
+        narrationStats.getWordCounts().mid(prgNum, numParts);
+    if (wordCounts.size() != numParts)
+        wordCounts.fill(0, numParts);
+
+    QVector<qint64> splitFrames = splitter.proposeSplits(wordCounts);
+    if (numParts > 1 && splitFrames.isEmpty() &&
+        splitter.getSilences().size() < numParts - 1) {
+        showErrorMsg(QString("Only %1 pauses were found in the recording, but "
+                             "%2 paragraphs need %3.")
+                         .arg(splitter.getSilences().size())
+                         .arg(numParts)
+                         .arg(numParts - 1));
+        return;
+    }
+    if (numParts > 1 && splitFrames.isEmpty()) {
+        showErrorMsg(QString("The recording has too many pauses to split it "
+                             "into %1 paragraphs at once. Import fewer "
+                             "paragraphs from it at a time.")
+                         .arg(numParts));
+        return;
+    }
+
+    auto answer = QMessageBox::question(
+        this, "Import Long Recording",
+        QString("Split the %1 long recording into paragraphs %2 to %3? "
+                "Their recorded parts will be replaced.")
+            .arg(QTime(0, 0, 0)
+                     .addMSecs(static_cast<int>(splitter.getDurationMs()))
+                     .toString())
+            .arg(prgNum + 1)
+            .arg(prgNum + numParts));
+    if (answer != QMessageBox::Yes)
+        return;
+
+    audioPlayer->setMedia(nullptr);
+    recentTake.clear();
+    partCompressor->stop();
+
+    // Parts are written under names the tracker ignores, and only take the
+    // place of the old ones once all of them were written. They are kept in
+    // the format the narrator records in, so that an export does not mix
+    // them with the others.
+    const QString recordingPath = getRecordingPath();
+    const QString partExtension =
+        audioExtension.startsWith('.') ? audioExtension : ".wav";
+    QStringList splitPaths;
+    QStringList importPaths;
+    for (int i = 0; i < numParts; i++) {
+        const QString importPath =
+            recordingPath + "/part" + QString::number(prgNum + i) + ".import";
+        splitPaths.append(importPath + ".wav");
+        importPaths.append(importPath + partExtension);
+    }
+
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    const bool isSplit = splitter.writeParts(splitFrames, splitPaths);
+    const bool isConverted =
+        isSplit && convertImportedParts(splitPaths, importPaths);
+    const bool isCommitted =
+        isConverted && commitImportedParts(static_cast<uint>(prgNum),
+                                           importPaths, partExtension);
+    QApplication::restoreOverrideCursor();
+
+    if (!isSplit) {
+        showErrorMsg(splitter.getErrorString());
+        return;
+    }
+
+    if (!isConverted) {
+        showErrorMsg(QString("Could not convert the parts of paragraphs %1 "
+                             "to %2 to the %3 format the others are in.")
+                         .arg(prgNum + 1)
+                         .arg(prgNum + numParts)
+                         .arg(partExtension));
+        return;
+    }
+
+    if (isPackStorage)
+        recordedParts.scanPack(partsPack.getParts());
+    else
+        recordedParts.scanDirectory(recordingPath);
+    refreshPartStats();
+
+    if (!isCommitted) {
+        showErrorMsg(QString("Could not replace the parts of paragraphs %1 "
+                             "to %2, so they were left as they were.")
+                         .arg(prgNum + 1)
+                         .arg(prgNum + numParts));
+        return;
+    }
+
+    hasChanged = true;
+    updatePlayerInfo();
+}
+
+// Converts the parts split out of a recording to the paths given, when
+// those name another format. The split parts are removed either way, and
+// the converted ones too unless all of them were converted.
+bool NarrativeDirector::convertImportedParts(const QStringList &splitPaths,
+                                             const QStringList &importPaths) {
+    bool isConverted = true;
+    for (int i = 0; isConverted && i < splitPaths.size(); i++) {
+        if (splitPaths[i] != importPaths[i])
+            isConverted =
+                PartCompressor::convertFile(splitPaths[i], importPaths[i]);
+    }
+
+    for (int i = 0; i < splitPaths.size(); i++) {
+        if (splitPaths[i] != importPaths[i])
+            QFile::remove(splitPaths[i]);
+        if (!isConverted)
+            QFile::remove(importPaths[i]);
+    }
+
+    return isConverted;
+}
+
+// Puts imported parts in the place of the old ones, either all of them or
+// none. Old parts are only removed once every new one is in place, and are
+// put back otherwise. The imported files are removed either way.
+bool NarrativeDirector::commitImportedParts(uint firstPart,
+                                            const QStringList &importPaths,
+                                            const QString &partExtension) {
+    bool isCommitted = true;
+
+    if (isPackStorage) {
+        // Replaced takes stay in the pack until it is compacted.
+        QVector<std::pair<qint64, qint64>> previousTakes;
+        for (int i = 0; isCommitted && i < importPaths.size(); i++) {
+            const uint part = firstPart + static_cast<uint>(i);
+            previousTakes.append(std::make_pair(partsPack.getPartOffset(part),
+                                                partsPack.getPartSize(part)));
+
+            QFile importFile(importPaths[i]);
+            isCommitted = importFile.open(QIODevice::ReadOnly) &&
+                          partsPack.appendPart(part, importFile.readAll());
+        }
+
+        for (int i = 0; !isCommitted && i < previousTakes.size(); i++)
+            partsPack.restorePart(firstPart + static_cast<uint>(i),
+                                  previousTakes[i].first,
+                                  previousTakes[i].second);
+    } else {
+        // Old parts are set aside under names the tracker ignores.
+        const QString recordingPath = getRecordingPath();
+        QStringList setAsidePaths;
+        QStringList placedPaths;
+        for (int i = 0; isCommitted && i < importPaths.size(); i++) {
+            const uint part = firstPart + static_cast<uint>(i);
+            const QString partPath =
+                recordingPath + "/part" + QString::number(part) + partExtension;
+
+            QStringList oldPaths = {partPath};
+            if (recordedParts.isRecorded(part) &&
+                getPartPath(part) != partPath)
+                oldPaths.append(getPartPath(part));
+
+            for (const QString &oldPath : oldPaths) {
+                if (!isCommitted || !QFile::exists(oldPath))
+                    continue;
+
+                QFile::remove(oldPath + ".replaced");
+                isCommitted = QFile::rename(oldPath, oldPath + ".replaced");
+                if (isCommitted)
+                    setAsidePaths.append(oldPath);
+            }
+
+            if (isCommitted)
+                isCommitted = QFile::rename(importPaths[i], partPath);
+            if (isCommitted)
+                placedPaths.append(partPath);
+        }
+
+        for (const QString &placedPath : placedPaths) {
+            if (!isCommitted)
+                QFile::remove(placedPath);
+        }
+        for (const QString &oldPath : setAsidePaths) {
+            if (isCommitted)
+                QFile::remove(oldPath + ".replaced");
+            else
+                QFile::rename(oldPath + ".replaced", oldPath);
+        }
+    }
+
+    for (const QString &importPath : importPaths)
+        QFile::remove(importPath);
+
+    return isCommitted;
+}
+
+void NarrativeDirector::on_actionStore_Parts_In_Pack_File_triggered(
+    bool checked) {
+    if (paragraphs.length() == 0 || checked == isPackStorage ||
+        audioRecorder->state() != QAudioRecorder::StoppedState ||
+        pendingPackPart != -1) {
+        ui->actionStore_Parts_In_Pack_File->setChecked(isPackStorage);
+        return;
+    }
+
+    if (paragraphClaims.getNumSessions() > 1) {
+        showErrorMsg("The parts cannot be moved while this text is being "
+                     "narrated in other sessions.");
+        ui->actionStore_Parts_In_Pack_File->setChecked(isPackStorage);
+        return;
+    }
 
-        fileOutput << "file " << recordingPath << "/" << recordingFileName
-                   << '\n'
-                   << flush;
+    audioPlayer->setMedia(nullptr);
+    recentTake.clear();
+    partProber->cancel();
+
+    bool isMoved = checked ? movePartsIntoPack() : movePartsOutOfPack();
+    if (!isMoved) {
+        showErrorMsg(checked
+                         ? "Could not move the parts into a pack file."
+                         : "Could not move the parts out of the pack file.");
+        ui->actionStore_Parts_In_Pack_File->setChecked(isPackStorage);
+        watchRecordingPath();
+        updatePlayerLocation();
+        return;
     }
 
-    partsFile.close();
+    isPackStorage = checked;
+    hasChanged = true;
 
-    QMessageBox::information(this, "Success",
-                             "parts-list.txt created successfully.");
+    watchRecordingPath();
+    updatePlayerLocation();
 }
 
 // Format context menus
 void NarrativeDirector::on_actionSimplify_triggered() {
+    teleprompter->refresh();
     if (paragraphs.length() == 0)
         return;
     changeParagraphLbl(prgNum);
 }
 
+void NarrativeDirector::on_actionTeleprompter_triggered(bool isTeleprompter) {
+    ui->prgText->setVisible(!isTeleprompter);
+    teleprompter->setVisible(isTeleprompter);
+
+    if (isTeleprompter) {
+        teleprompter->setNumParagraphs(static_cast<int>(prgNumTotal));
+        teleprompter->setCurrentParagraph(prgNum);
+    }
+}
+
 // Edit context menus
 void NarrativeDirector::on_actionPreferences_triggered() {
     preferences->show();
 }
 
+void NarrativeDirector::on_actionRecord_Trace_triggered(bool isRecording) {
+    Tracer::setEnabled(isRecording);
+}
+
+void NarrativeDirector::on_actionExport_Trace_triggered() {
+    QString tracePath = QFileDialog::getSaveFileName(
+        this, tr("Export Trace"), QDir::currentPath(),
+        tr("Chrome trace files (*.json)"));
+    if (tracePath.isEmpty())
+        return;
+
+    if (!Tracer::writeChromeTrace(tracePath))
+        showErrorMsg("Could not write the trace to " + tracePath);
+}
+
+void NarrativeDirector::on_actionDiagnostics_triggered() {
+    QDialog diagnosticsDialog(this);
+    diagnosticsDialog.setWindowTitle(tr("Diagnostics"));
+
+    auto *reportText = new QPlainTextEdit(&diagnosticsDialog);
+    reportText->setReadOnly(true);
+    reportText->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    reportText->setPlainText(getDiagnostics().toText());
+
+    auto *buttons =
+        new QDialogButtonBox(QDialogButtonBox::Close, &diagnosticsDialog);
+    QPushButton *refreshBtn =
+        buttons->addButton(tr("Refresh"), QDialogButtonBox::ActionRole);
+    connect(refreshBtn, &QPushButton::clicked, reportText,
+            [this, reportText]() {
+                reportText->setPlainText(getDiagnostics().toText());
+            });
+    connect(buttons, &QDialogButtonBox::rejected, &diagnosticsDialog,
+            &QDialog::reject);
+
+    auto *dialogLayout = new QVBoxLayout(&diagnosticsDialog);
+    dialogLayout->addWidget(reportText);
+    dialogLayout->addWidget(buttons);
+
+    diagnosticsDialog.resize(480, 480);
+    diagnosticsDialog.exec();
+}
+
 // About context menus
 void NarrativeDirector::on_actionAbout_Narrative_Director_triggered() {
     const QString aboutText =
@@ -154,6 +654,16 @@ void NarrativeDirector::on_actionAbout_Narrative_Director_triggered() {
 
 // States
 // Audio Recorder
+void NarrativeDirector::onARStatusChanged(QMediaRecorder::Status status) {
+    // Only once the recorder is done with the file can it be packed.
+    if (status != QMediaRecorder::LoadedStatus || pendingPackPart == -1)
+        return;
+
+    uint part = static_cast<uint>(pendingPackPart);
+    pendingPackPart = -1;
+    packRecordedPart(part, audioRecorder->actualLocation());
+}
+
 void NarrativeDirector::onARStateChanged(QAudioRecorder::State state) {
     switch (state) {
     case QAudioRecorder::RecordingState:
@@ -172,11 +682,20 @@ void NarrativeDirector::onARStateChanged(QAudioRecorder::State state) {
         ui->playBtn->setEnabled(false);
         break;
     case QAudioRecorder::StoppedState:
+        recordStartNs = -1;
         ui->recordBtn->setEnabled(true);
         ui->backBtn->setEnabled(true);
         ui->nextBtn->setEnabled(true);
         ui->playbackSldr->setEnabled(true);
         ui->playBtn->setText(tr("Play"));
+
+        // The probe hands over buffers until the recorder has stopped, so
+        // the take is only finished, and played from, once it has.
+        if (isFinishingTake) {
+            isFinishingTake = false;
+            recentTake.finish();
+            updatePlayerLocation();
+        }
         break;
     }
 }
@@ -192,6 +711,11 @@ void NarrativeDirector::updateAEnd(int duration) {
     updateRecorderTimeLbl();
 }
 
+void NarrativeDirector::onAudioBufferProbed(const QAudioBuffer &buffer) {
+    Tracer::end("start recording", recordStartNs);
+    recentTake.append(buffer);
+}
+
 // Media Player
 void NarrativeDirector::onMPStateChanged(QMediaPlayer::State state) {
     switch (state) {
@@ -217,6 +741,7 @@ void NarrativeDirector::onMPMediaStatusChanged(
     QMediaPlayer::MediaStatus mediaStatus) {
     switch (mediaStatus) {
     case QMediaPlayer::LoadedMedia:
+        Tracer::end("load media", mediaLoadStartNs);
         ui->playBtn->setEnabled(true);
         ui->stopBtn->setEnabled(true);
         ui->playbackSldr->setRange(0, audioPlayer->duration() / 1000);
@@ -225,6 +750,8 @@ void NarrativeDirector::onMPMediaStatusChanged(
     case QMediaPlayer::InvalidMedia:
     case QMediaPlayer::UnknownMediaStatus:
     case QMediaPlayer::NoMedia:
+        if (mediaStatus == QMediaPlayer::InvalidMedia)
+            Tracer::end("load media", mediaLoadStartNs);
         if (audioRecorder->state() == QAudioRecorder::RecordingState)
             return;
         ui->playBtn->setEnabled(false);
@@ -239,28 +766,64 @@ void NarrativeDirector::onMPMediaStatusChanged(
 
 // Buttons
 void NarrativeDirector::on_recordBtn_clicked() {
-#ifdef _WIN32
-    auto filePath = recordingLocation.toLocalFile().toStdString().c_str();
-    auto fileAttributes = GetFileAttributesA(filePath);
+    restartIdleTimer();
 
-    if (fileAttributes != INVALID_FILE_ATTRIBUTES) {
-        DeleteFileA(filePath);
-        audioPlayer->setMedia(nullptr);
+    // Takes are appended to the pack, which only one session can do safely.
+    if (isPackStorage && paragraphClaims.getNumSessions() > 1) {
+        showErrorMsg("This text is being narrated in other sessions, which "
+                     "cannot share a pack file. Store the parts as separate "
+                     "files to record in several sessions at once.");
+        return;
     }
+
+    if (!claimParagraph(prgNum))
+        return;
+
+    if (recordedParts.isRecorded(static_cast<uint>(prgNum))) {
+        if (isPackStorage) {
+            audioPlayer->setMedia(nullptr);
+            if (!partsPack.removePart(static_cast<uint>(prgNum))) {
+                showErrorMsg("Could not remove the previous take from the "
+                             "pack file, so it was kept.");
+                updatePlayerLocation();
+                return;
+            }
+        } else {
+#ifdef _WIN32
+            auto filePath = recordingLocation.toLocalFile().toStdString();
+
+            audioPlayer->setMedia(nullptr);
+            DeleteFileA(filePath.c_str());
 #else
-    if (QFileInfo::exists(recordingLocation.path())) {
-        QFile recordingFile(recordingLocation.toLocalFile());
+            QFile recordingFile(recordingLocation.toLocalFile());
 
-        recordingFile.remove();
-    }
+            recordingFile.remove();
 #endif
+            // The part may have been compressed since it was recorded.
+            const QString partPath = getPartPath(static_cast<uint>(prgNum));
+            if (partPath != recordingLocation.toLocalFile())
+                QFile::remove(partPath);
+        }
+        narrationStats.removePart(
+            static_cast<uint>(prgNum),
+            recordedParts.getPartInfo(static_cast<uint>(prgNum)).durationMs);
+        recordedParts.markUnrecorded(static_cast<uint>(prgNum));
+    }
     updateRecordingLocation();
 
+    // The player may still be reading the previous take from memory.
+    audioPlayer->setMedia(nullptr);
+    recentTake.start(recordingLocation);
+
+    // Until its first audio arrives, the recorder misses what is said.
+    recordStartNs = Tracer::begin();
     audioRecorder->setOutputLocation(recordingLocation);
     audioRecorder->record();
 }
 
 void NarrativeDirector::on_playBtn_clicked() {
+    restartIdleTimer();
+
     // Audio player checks
     if (audioPlayer->state() == QMediaPlayer::PausedState ||
         audioPlayer->state() == QMediaPlayer::StoppedState) {
@@ -276,13 +839,27 @@ void NarrativeDirector::on_playBtn_clicked() {
 }
 
 void NarrativeDirector::on_stopBtn_clicked() {
+    restartIdleTimer();
+
     if (audioRecorder->state() == QAudioRecorder::RecordingState) {
+        TraceScope traceScope("stop recording");
+        qint64 takeDuration = audioRecorder->duration();
+        recordedParts.markRecorded(static_cast<uint>(prgNum), 0, takeDuration);
+        narrationStats.addPart(static_cast<uint>(prgNum), takeDuration);
+        updateStatsLbl();
+        if (isPackStorage)
+            pendingPackPart = prgNum;
+
+        // Some backends stop at once, others only later.
+        isFinishingTake = true;
         audioRecorder->stop();
 
         auto outputLocation = audioRecorder->outputLocation();
-        audioPlayer->setMedia(outputLocation);
         if (outputLocation.fileName().lastIndexOf(".") != -1)
             audioExtension = outputLocation.fileName().right(4);
+
+        projectJournal.appendTake(static_cast<uint>(prgNum), audioExtension);
+        journalProgress();
         return;
     }
 
@@ -335,9 +912,38 @@ void NarrativeDirector::cleanPrgs() {
 }
 
 void NarrativeDirector::updatePlayerInfo() {
+    restartIdleTimer();
     changeParagraphLbl(prgNum);
     updateRecordingLocation();
     updatePlayerLocation();
+    journalProgress();
+}
+
+// Appends the paragraphs found since the last record, and where the narrator
+// is now, to the project's journal. The project is saved in full instead
+// when it has no journal open yet, or once the journal has grown long.
+void NarrativeDirector::journalProgress() {
+    if (!narrativeFile.isOpen())
+        return;
+
+    if (!projectJournal.isOpen()) {
+        checkpointProject();
+        return;
+    }
+
+    bool isJournaled = true;
+    while (isJournaled && numJournaledPrgs < paragraphs.length()) {
+        isJournaled = projectJournal.appendParagraphStart(
+            numJournaledPrgs, paragraphs[numJournaledPrgs].first);
+        numJournaledPrgs++;
+    }
+
+    if (isJournaled)
+        isJournaled = projectJournal.appendPosition(prgNum);
+
+    if (!isJournaled ||
+        projectJournal.getNumRecords() >= ProjectJournal::checkpointInterval)
+        checkpointProject();
 }
 
 void NarrativeDirector::displayErrorMessage() {
@@ -361,86 +967,64 @@ void NarrativeDirector::updateRecorderTimeLbl() {
 }
 
 void NarrativeDirector::changeParagraphLbl(int prgIndex) {
-    std::stringstream prgStream;
+    TraceScope traceScope("changeParagraphLbl");
     QString paragraph = getParagraph(prgIndex);
     if (ui->actionSimplify->isChecked())
         paragraph = paragraph.simplified();
 
-    prgStream << "Paragraph " << prgIndex + 1 << "/" << prgNumTotal;
     ui->prgText->setPlainText(paragraph);
-    ui->prgLbl->setText(QString::fromStdString(prgStream.str()));
-}
-
-QString NarrativeDirector::getParagraphFromFile(qint64 location) {
-    QString myParagraph = "";
-
-    for (int i = 0; i < 4; i++) {
-        QString sentence = getSentenceFromFile(location);
+    updateParagraphLbl(prgIndex);
 
-        if (sentence.isEmpty())
-            break;
-        myParagraph += sentence;
+    if (teleprompter->isVisible()) {
+        teleprompter->setNumParagraphs(static_cast<int>(prgNumTotal));
+        teleprompter->setCurrentParagraph(prgIndex);
     }
-    filePos = location;
-
-    return myParagraph.trimmed();
 }
 
-QString NarrativeDirector::getSentenceFromFile(qint64 &location) {
-    QString sentence = "";
-
-    narrativeInput.seek(location);
-    while (!narrativeInput.atEnd()) {
-        QChar currentLetter = narrativeInput.read(1).front();
-
-        sentence.append(currentLetter);
-
-        if (isEndOfSentence(currentLetter)) {
-            appendUntilNextSentence(sentence);
-            break;
-        }
-    }
-    location = narrativeInput.pos();
+void NarrativeDirector::updateParagraphLbl(int prgIndex) {
+    std::stringstream prgStream;
+    prgStream << "Paragraph " << prgIndex + 1 << "/" << prgNumTotal << " ("
+              << recordedParts.getProgressPercentage(prgNumTotal)
+              << "% recorded)";
+    if (paragraphClaims.isClaimedByOther(static_cast<uint>(prgIndex)))
+        prgStream << " - claimed by another session";
 
-    return sentence;
+    ui->prgLbl->setText(QString::fromStdString(prgStream.str()));
 }
 
-bool NarrativeDirector::isEndOfSentence(const QChar &letter) {
-    return letter == "!" || letter == "?" || letter == ".";
-}
+QString NarrativeDirector::getParagraphFromFile(qint64 location) {
+    QString paragraph = paragraphReader.readParagraph(location);
+    filePos = location;
 
-bool NarrativeDirector::isEndOfQuote(const QChar &letter) {
-    return letter == "\"" || letter == "'" || letter == "”" || letter == "`";
+    return paragraph;
 }
 
-void NarrativeDirector::appendUntilNextSentence(QString &sentence) {
-    while (!narrativeInput.atEnd()) {
-        QChar currentLetter = narrativeInput.read(1).front();
-
-        if (isEndOfQuote(currentLetter) || !isEndOfSentence(currentLetter)) {
-            sentence.append(currentLetter);
-            break;
-        }
-
-        sentence.append(currentLetter);
-    }
+QString NarrativeDirector::getSentenceFromFile(qint64 &location) {
+    return paragraphReader.readSentence(location);
 }
 
 QString NarrativeDirector::getParagraph(int paragraphNum) {
+    TraceScope traceScope("getParagraph");
     std::pair<qint64, QString> prgEntry;
 
     if (paragraphNum < paragraphs.length()) {
         prgEntry = paragraphs[paragraphNum];
 
-        if (!prgEntry.second.isNull())
+        if (!prgEntry.second.isNull()) {
+            numParagraphHits++;
             return prgEntry.second;
+        }
 
+        numParagraphMisses++;
         return getParagraphFromFile(prgEntry.first);
     }
 
+    // The teleprompter may have read elsewhere in the text since.
+    narrativeInput.seek(filePos);
     if (narrativeInput.atEnd())
         throw std::string("File at end.");
 
+    numParagraphMisses++;
     prgEntry.first = filePos;
     QString paragraph = getParagraphFromFile(filePos);
     prgEntry.second = paragraph;
@@ -451,60 +1035,110 @@ QString NarrativeDirector::getParagraph(int paragraphNum) {
 }
 
 void NarrativeDirector::saveToProjectFile() {
-    QFile outputProjFile(getRecordingPath() + "/" + getNonExtensionFileName() +
-                         ".ndp");
-    if (!outputProjFile.open(QIODevice::WriteOnly | QIODevice::Text))
+    if (!checkpointProject())
         return;
 
-    QTextStream fileOutput(&outputProjFile);
-    fileOutput << prgNumTotal << '\n' << flush;
+    // Other sessions save the tracker of the same parts too, so what they
+    // saved is merged in rather than written over.
+    if (!isPackStorage && paragraphClaims.getNumSessions() > 1) {
+        RecordedPartsTracker savedParts;
+        if (savedParts.loadFromFile(getTrackerFilePath()))
+            recordedParts.merge(savedParts);
+        recordedParts.scanDirectory(getRecordingPath());
+        refreshPartStats();
+    }
+
+    recordedParts.saveToFile(getTrackerFilePath());
+
+    if (isPackStorage && partsPack.isOpen()) {
+        partProber->cancel();
+        partsPack.compactIfNeeded();
+        refreshPartStats();
+    }
+}
+
+// Saves the project in full, which the journals no longer need to replay.
+// While other sessions narrate the text, the project is theirs to read as
+// well, so it is left as it is and this session only keeps its journal.
+bool NarrativeDirector::checkpointProject() {
+    const QString journalPath = ProjectFile::getJournalPath(
+        narrativeFile.fileName(), paragraphClaims.getToken());
+    if (paragraphClaims.getNumSessions() > 1)
+        return projectJournal.isOpen() || projectJournal.open(journalPath);
+
+    ProjectFile project;
+    project.prgNumTotal = prgNumTotal;
     for (auto &prgPair : paragraphs)
-        fileOutput << prgPair.first << ",";
-    fileOutput << '\n' << flush;
-    fileOutput << prgNum << '\n' << flush;
-    fileOutput << narrativeFile.fileName() << '\n' << flush;
-    fileOutput << audioExtension << '\n' << flush;
+        project.prgStarts.append(prgPair.first);
+    project.prgNum = prgNum;
+    project.textFilePath = narrativeFile.fileName();
+    project.audioExtension = audioExtension;
+    project.wordCounts = narrationStats.getWordCounts();
+    project.isPackStorage = isPackStorage;
+    project.chapters = chapters;
+    project.chapterPatternsKey = chapterPatternsKey;
+
+    if (!project.save(ProjectFile::getProjectFilePath(project.textFilePath)))
+        return false;
+
+    // The journals of sessions that have closed since were replayed or
+    // are superseded by this session's, which is the only one left.
+    for (const QString &otherJournalPath :
+         ProjectFile::getJournalPaths(project.textFilePath)) {
+        if (otherJournalPath != journalPath)
+            QFile::remove(otherJournalPath);
+    }
 
-    outputProjFile.close();
+    numJournaledPrgs = paragraphs.length();
+    projectJournal.restart(journalPath);
+    return true;
 }
 
 void NarrativeDirector::loadFromProjectFile(const QString &filePath) {
-    QFile openedProjectFile(filePath);
-    if (!openedProjectFile.open(QIODevice::ReadOnly | QIODevice::Text))
+    TraceScope traceScope("load project");
+    ProjectFile project;
+    if (!project.load(filePath))
         return;
 
-    QTextStream prjInput(&openedProjectFile);
-
-    // Number of paragraphs total.
-    prgNumTotal = prjInput.readLine().toUInt();
-    // paragraphs.reserve(prjInput.readLine().toInt());
+    // What changed after the project was last saved in full is only in the
+    // journals when the program stopped before it could save again, or when
+    // other sessions are narrating it. The project is saved with them the
+    // first time the narrator's place is.
+    for (const QString &journalPath :
+         ProjectFile::getJournalPaths(narrativeFile.fileName()))
+        ProjectJournal::replay(journalPath, project);
+    projectJournal.close();
+
+    prgNumTotal = project.prgNumTotal;
+    for (qint64 prgStart : project.prgStarts)
+        paragraphs.push_back(std::make_pair(prgStart, QString()));
+    prgNum = project.prgNum;
+    numJournaledPrgs = paragraphs.length();
+
+    // The text file that was opened wins over the one the project names.
+    this->narrativeInput.setDevice(getTextDevice());
+    this->narrativeInput.setCodec("UTF-8");
 
-    // Known paragraph locations
-    QString prgStarts = prjInput.readLine();
-    std::istringstream prgStream(prgStarts.toStdString());
-    std::string foundPrgLoc;
-    while (std::getline(prgStream, foundPrgLoc, ',')) {
-        std::pair<int, QString> prgEntry;
-        prgEntry.first = QString::fromStdString(foundPrgLoc).toInt();
+    audioExtension = project.audioExtension;
 
-        paragraphs.push_back(prgEntry);
-    }
+    narrationStats.setWordCounts(project.wordCounts);
+    chapters = project.chapters;
+    chapterPatternsKey = project.chapterPatternsKey;
 
-    // Paragraph user was last on.
-    prgNum = prjInput.readLine().toInt();
+    // Older projects were saved before words and chapters were counted, and
+    // chapters found with patterns that have since changed are found again.
+    if (project.wordCounts.isEmpty() ||
+        chapterPatternsKey !=
+            ChapterList::getPatternsKey(ChapterList::getPatterns()))
+        countWordsInBackground();
 
-    // Text file being read for narration.
-    prjInput.readLine();
-    this->narrativeInput.setDevice(&narrativeFile);
-    this->narrativeInput.setCodec("UTF-8");
+    isPackStorage = project.isPackStorage;
+    ui->actionStore_Parts_In_Pack_File->setChecked(isPackStorage);
 
-    // Audio extension for parts
-    audioExtension = prjInput.readLine();
-
-    // Last, but not least, the project file.
     currentProjectFile = filePath;
 
-    openedProjectFile.close();
+    // Which paragraphs already have parts, along with their sizes.
+    recordedParts.loadFromFile(getTrackerFilePath());
 }
 
 void NarrativeDirector::closeEvent(QCloseEvent *event) {
@@ -530,65 +1164,505 @@ void NarrativeDirector::updateRecordingLocation() {
 }
 
 void NarrativeDirector::updatePlayerLocation() {
-#ifdef _WIN32
-    auto recordingPath = recordingLocation.toLocalFile();
-#else
-    auto recordingPath = recordingLocation.path();
-#endif
-
-    if (QFileInfo::exists(recordingPath)) {
-        audioPlayer->setMedia(recordingLocation);
+    if (recentTake.isAvailableFor(recordingLocation)) {
+        setPlayerToRecentTake();
+    } else if (isPackStorage && partsPack.contains(static_cast<uint>(prgNum))) {
+        setPlayerToPackedPart();
+    } else if (recordedParts.isRecorded(static_cast<uint>(prgNum))) {
+        mediaLoadStartNs = Tracer::begin();
+        audioPlayer->setMedia(
+            QUrl::fromLocalFile(getPartPath(static_cast<uint>(prgNum))));
     } else {
         audioPlayer->setMedia(nullptr);
     }
 }
 
-QString NarrativeDirector::getNonExtensionFileName() {
-    QString recordingFileDirName =
-        QFileInfo(narrativeFile.fileName()).fileName();
+void NarrativeDirector::setPlayerToRecentTake() {
+    // The URL only hints the container to the backend; the audio itself
+    // comes from the in-memory take.
+    mediaLoadStartNs = Tracer::begin();
+    audioPlayer->setMedia(QUrl(QStringLiteral("recent-take.wav")),
+                          recentTake.device());
+}
+
+void NarrativeDirector::setPlayerToPackedPart() {
+    audioPlayer->setMedia(nullptr);
+    mediaLoadStartNs = Tracer::begin();
+
+    packedTakeDevice.close();
+    packedTake = partsPack.readPart(static_cast<uint>(prgNum));
+    packedTakeDevice.setBuffer(&packedTake);
+    packedTakeDevice.open(QIODevice::ReadOnly);
 
-    auto extensionPosition = recordingFileDirName.lastIndexOf(".");
-    return extensionPosition != -1
-               ? recordingFileDirName.left(extensionPosition)
-               : "";
+    const QString partName = "part" + QString::number(prgNum) + audioExtension;
+    audioPlayer->setMedia(QUrl(partName), &packedTakeDevice);
 }
 
-QString NarrativeDirector::getRecordingPath() {
-    QString recordingFileDirName = getNonExtensionFileName();
+QString NarrativeDirector::getTrackerFilePath() {
+    return ProjectFile::getTrackerFilePath(narrativeFile.fileName());
+}
 
-    QString recordingPath =
-        QStandardPaths::writableLocation(QStandardPaths::MusicLocation) + "/" +
-        recordingFileDirName;
+QString NarrativeDirector::getPackFilePath() {
+    return ProjectFile::getPackFilePath(narrativeFile.fileName());
+}
 
-    return recordingPath;
+QString NarrativeDirector::getPartPath(uint part) {
+    return ProjectFile::getPartPath(getRecordingPath(), part,
+                                    recordedParts.getPartInfo(part).fileName,
+                                    audioExtension);
 }
 
-uint NarrativeDirector::getNumPrgs() {
-    uint numPrgs = 1;
-    uint numSents = 1;
-    narrativeInput.seek(0);
-    bool seenEndOfSentence = false;
+// Once some parts are compressed, the rest are compressed too before they
+// are listed together. That happens on the compressor's worker, and returns
+// whether it was started.
+bool NarrativeDirector::unifyPartFormats(int numParts) {
+    QStringList partPaths;
+    for (uint part : PartCompressor::getPartsToUnify(
+             recordedParts, static_cast<uint>(numParts)))
+        partPaths.append(getPartPath(part));
+
+    if (partPaths.isEmpty())
+        return false;
+
+    ui->actionExport_Parts_File->setEnabled(false);
+    QApplication::setOverrideCursor(Qt::BusyCursor);
+    unifyWatcher.setFuture(partCompressor->unify(partPaths));
+
+    return true;
+}
+
+void NarrativeDirector::onPartsUnified() {
+    QApplication::restoreOverrideCursor();
+    ui->actionExport_Parts_File->setEnabled(true);
+
+    // The export was given up on when another text was opened meanwhile.
+    if (!unifyWatcher.result())
+        return;
+
+    recordedParts.scanDirectory(getRecordingPath());
+    refreshPartStats();
+    writeExportLists();
+}
 
-    while (!narrativeInput.atEnd()) {
-        QChar currentChar = narrativeInput.read(1).front();
-        if (!isEndOfSentence(currentChar)) {
-            seenEndOfSentence = false;
+void NarrativeDirector::restartIdleTimer() {
+    partCompressor->pause();
+    idleTimer->start();
+}
+
+// Compresses finished parts while the narrator is not using the program.
+void NarrativeDirector::onIdle() {
+    // Packed parts already live in one file and are kept as recorded.
+    if (isPackStorage || paragraphs.length() == 0 ||
+        audioRecorder->state() != QAudioRecorder::StoppedState ||
+        audioPlayer->state() == QMediaPlayer::PlayingState)
+        return;
+
+    const QString recordingPath = getRecordingPath();
+    const auto &partInfos = recordedParts.getPartInfos();
+    for (auto info = partInfos.constBegin(); info != partInfos.constEnd();
+         ++info) {
+        // The current part is the one most likely to be recorded again, as
+        // are those other sessions are recording.
+        if (info.key() == static_cast<uint>(prgNum) ||
+            paragraphClaims.isClaimedByOther(info.key()) ||
+            !PartCompressor::canCompress(*info))
             continue;
-        }
 
-        if (isEndOfSentence(currentChar) && seenEndOfSentence) {
+        partCompressor->compress(info.key(),
+                                 recordingPath + "/" + info->fileName);
+    }
+}
+
+// Lets the other sessions narrating the same text, in other windows or on
+// other input devices, know which paragraphs this one records, so that no
+// two of them record the same paragraph. Each sees the others' parts as
+// they are written to the recording directory.
+void NarrativeDirector::joinClaims() {
+    if (!paragraphClaims.open(
+            ParagraphClaims::getClaimsPath(getRecordingPath()), prgNumTotal)) {
+        showErrorMsg("Could not join the other sessions narrating this text, "
+                     "so its paragraphs cannot be claimed.");
+        return;
+    }
+
+    QMetaObject::invokeMethod(claimsTimer, "start");
+}
+
+// Waits for a heartbeat under way, so the claims can be closed after.
+void NarrativeDirector::stopClaimsHeartbeat() {
+    QMetaObject::invokeMethod(claimsTimer, "stop",
+                              Qt::BlockingQueuedConnection);
+}
+
+// Recording a paragraph claims it, unless another session has already.
+bool NarrativeDirector::claimParagraph(int prgIndex) {
+    if (!paragraphClaims.isOpen() ||
+        paragraphClaims.claim(static_cast<uint>(prgIndex),
+                              static_cast<uint>(prgIndex) + 1))
+        return true;
+
+    showErrorMsg(QString("Paragraph %1 is being narrated in another session.")
+                     .arg(prgIndex + 1));
+    return false;
+}
+
+void NarrativeDirector::watchRecordingPath() {
+    const QString recordingPath = getRecordingPath();
+
+    if (!QDir(recordingPath).exists())
+        QDir().mkdir(recordingPath);
+
+    if (!partsWatcher->directories().isEmpty())
+        partsWatcher->removePaths(partsWatcher->directories());
+
+    // Takes only pass through the directory on their way into the pack.
+    if (isPackStorage) {
+        if (!partsPack.isOpen() && !partsPack.open(getPackFilePath()))
+            showErrorMsg("Could not open the parts pack file.");
+
+        recordedParts.scanPack(partsPack.getParts());
+        refreshPartStats();
+        return;
+    }
+
+    partsPack.close();
+    partsWatcher->addPath(recordingPath);
+
+    // Catch up on anything that changed while the project was closed.
+    recordedParts.scanDirectory(recordingPath);
+    refreshPartStats();
+}
+
+void NarrativeDirector::onRecordingDirectoryChanged() {
+    if (isPackStorage)
+        return;
+
+    recordedParts.scanDirectory(getRecordingPath());
+    refreshPartStats();
+
+    if (paragraphs.length() != 0)
+        updateParagraphLbl(prgNum);
+}
+
+void NarrativeDirector::refreshPartStats() {
+    const QString recordingPath = getRecordingPath();
+    for (uint part : recordedParts.getUnprobedParts()) {
+        if (isPackStorage) {
+            if (partsPack.contains(part))
+                partProber->enqueue(part, partsPack.getPackPath(),
+                                    partsPack.getPartOffset(part),
+                                    partsPack.getPartSize(part));
             continue;
         }
 
-        if (++numSents % 4 == 0)
-            numPrgs++;
-        seenEndOfSentence = true;
+        partProber->enqueue(part, recordingPath + "/" +
+                                      recordedParts.getPartInfo(part).fileName);
     }
 
+    narrationStats.recompute(recordedParts);
+    updateStatsLbl();
+}
+
+void NarrativeDirector::packRecordedPart(uint part, const QUrl &location) {
+    QFile takeFile(location.toLocalFile());
+    if (!takeFile.open(QIODevice::ReadOnly)) {
+        showErrorMsg("Could not read the take to store it in the pack file.");
+        return;
+    }
+
+    QByteArray take = takeFile.readAll();
+    takeFile.close();
+
+    if (!partsPack.appendPart(part, take)) {
+        showErrorMsg("Could not store the take in the pack file.");
+        return;
+    }
+
+    // Without the take in memory, the player is still using the file.
+    bool isPlayerOnFile = static_cast<int>(part) == prgNum &&
+                          !recentTake.isAvailableFor(recordingLocation);
+    if (isPlayerOnFile)
+        audioPlayer->setMedia(nullptr);
+
+    takeFile.remove();
+    if (isPlayerOnFile)
+        updatePlayerLocation();
+
+    auto info = recordedParts.getPartInfo(part);
+    info.fileName.clear();
+    info.byteSize = take.size();
+    if (recordedParts.setPartInfo(part, info))
+        partProber->enqueue(part, partsPack.getPackPath(),
+                            partsPack.getPartOffset(part),
+                            partsPack.getPartSize(part));
+}
+
+// Copies every part file into the pack, and only removes the files once
+// all of them made it in.
+bool NarrativeDirector::movePartsIntoPack() {
+    const QString recordingPath = getRecordingPath();
+    if (!partsPack.open(getPackFilePath()))
+        return false;
+
+    const auto partInfos = recordedParts.getPartInfos();
+    for (auto info = partInfos.constBegin(); info != partInfos.constEnd();
+         ++info) {
+        QFile partFile(recordingPath + "/" + info->fileName);
+        if (info->fileName.isEmpty() || !partFile.open(QIODevice::ReadOnly) ||
+            !partsPack.appendPart(info.key(), partFile.readAll())) {
+            removePackFiles();
+            return false;
+        }
+    }
+
+    for (auto info = partInfos.constBegin(); info != partInfos.constEnd();
+         ++info)
+        QFile::remove(recordingPath + "/" + info->fileName);
+
+    return true;
+}
+
+// Writes every packed part back out as its own file, and only removes the
+// pack once all of them were written.
+bool NarrativeDirector::movePartsOutOfPack() {
+    const QString recordingPath = getRecordingPath();
+    QStringList writtenPaths;
+
+    for (auto &packedPart : partsPack.getParts()) {
+        const QString partPath = recordingPath + "/part" +
+                                 QString::number(packedPart.first) +
+                                 audioExtension;
+
+        QFile partFile(partPath);
+        bool isWritten =
+            partFile.open(QIODevice::WriteOnly) &&
+            partFile.write(partsPack.readPart(packedPart.first)) ==
+                packedPart.second;
+        partFile.close();
+        writtenPaths.append(partPath);
+
+        if (!isWritten) {
+            for (auto &writtenPath : writtenPaths)
+                QFile::remove(writtenPath);
+            return false;
+        }
+    }
+
+    removePackFiles();
+    return true;
+}
+
+void NarrativeDirector::removePackFiles() {
+    partsPack.close();
+
+    QFile::remove(getPackFilePath());
+    QFile::remove(getPackFilePath() + ".idx");
+}
+
+void NarrativeDirector::onPartProbed(
+    uint part, const RecordedPartsTracker::PartInfo &probedInfo) {
+    auto previousInfo = recordedParts.getPartInfo(part);
+
+    // The part was re-recorded while it was being probed.
+    if (!recordedParts.isRecorded(part) ||
+        previousInfo.fileName != probedInfo.fileName ||
+        previousInfo.byteSize != probedInfo.byteSize)
+        return;
+
+    auto info = probedInfo;
+    if (info.durationMs == 0)
+        info.durationMs = previousInfo.durationMs;
+
+    recordedParts.setPartInfo(part, info);
+    narrationStats.removePart(part, previousInfo.durationMs);
+    narrationStats.addPart(part, info.durationMs);
+    updateStatsLbl();
+}
+
+void NarrativeDirector::countWordsInBackground() {
+    wordCountTextPath = narrativeFile.fileName();
+
+    const QString textPath = wordCountTextPath;
+    const QStringList patterns = ChapterList::getPatterns();
+    wordCountPatternsKey = ChapterList::getPatternsKey(patterns);
+    const auto headingPatterns = ChapterList::compilePatterns(patterns);
+    wordCountWatcher.setFuture(QtConcurrent::run([textPath,
+                                                  headingPatterns]() {
+        TraceScope traceScope("index text");
+        ParagraphCounter::Counts counts;
+
+        QFile textFile;
+        ImportedText importedText;
+        QIODevice *textDevice =
+            ImportedText::openTextDevice(textPath, textFile, importedText);
+        if (textDevice != nullptr) {
+            QTextStream textInput(textDevice);
+            textInput.setCodec("UTF-8");
+            counts = ParagraphCounter::countText(textInput, headingPatterns);
+        }
+
+        return counts;
+    }));
+}
+
+void NarrativeDirector::onWordCountsFinished() {
+    if (wordCountTextPath != narrativeFile.fileName())
+        return;
+
+    const ParagraphCounter::Counts counts = wordCountWatcher.result();
+    narrationStats.setWordCounts(counts.wordCounts);
+    chapters = counts.chapters;
+    chapterPatternsKey = wordCountPatternsKey;
+    narrationStats.recompute(recordedParts);
+    updateStatsLbl();
+}
+
+void NarrativeDirector::updateStatsLbl() {
+    auto toTimeStamp = [](qint64 milliseconds) {
+        qint64 seconds = milliseconds / 1000;
+        return QString("%1:%2:%3")
+            .arg(seconds / 3600)
+            .arg((seconds / 60) % 60, 2, 10, QChar('0'))
+            .arg(seconds % 60, 2, 10, QChar('0'));
+    };
+
+    QString stats = QString("Recorded %1 | %2 wpm")
+                        .arg(toTimeStamp(narrationStats.getRecordedMs()))
+                        .arg(narrationStats.getWordsPerMinute());
+    if (narrationStats.getRemainingMs() > 0)
+        stats += QString(" | %1 remaining")
+                     .arg(toTimeStamp(narrationStats.getRemainingMs()));
+
+    statsLbl->setText(stats);
+}
+
+// What the session holds in memory and how it has been doing, for the
+// diagnostics dialog. The text itself is read from its file as it is needed,
+// so only the paragraphs already read are held.
+DiagnosticsReport NarrativeDirector::getDiagnostics() {
+    DiagnosticsReport report;
+
+    qint64 paragraphBytes = DiagnosticsReport::getVectorBytes(paragraphs);
+    int numHeldPrgs = 0;
+    for (auto &paragraph : paragraphs) {
+        paragraphBytes += DiagnosticsReport::getStringBytes(paragraph.second);
+        if (!paragraph.second.isNull())
+            numHeldPrgs++;
+    }
+
+    qint64 chapterBytes = DiagnosticsReport::getVectorBytes(chapters);
+    for (auto &chapter : chapters)
+        chapterBytes += DiagnosticsReport::getStringBytes(chapter.title);
+
+    report.addBytes("Paragraphs", paragraphBytes);
+    report.addBytes("Word counts", DiagnosticsReport::getVectorBytes(
+                                       narrationStats.getWordCounts()));
+    report.addBytes("Chapters", chapterBytes);
+    report.addBytes("Recorded parts", recordedParts.getMemoryUsage());
+    report.addBytes("Recent take", recentTake.getMemoryUsage());
+    report.addBytes("Packed take", packedTake.capacity());
+    report.addBytes("Pack offset table (mapped)", partsPack.getMappedBytes());
+    report.addProcessMemory();
+
+    report.addCount("Index", "Paragraphs in text", prgNumTotal);
+    report.addCount("Index", "Paragraphs found", paragraphs.length());
+    report.addCount("Index", "Paragraphs held as text", numHeldPrgs);
+    report.addCount("Index", "Chapters", chapters.length());
+    report.addCount("Index", "Recorded parts", recordedParts.getNumRecorded());
+
+    report.addRatio("Caches", "Paragraph text", numParagraphHits,
+                    numParagraphMisses);
+
+    report.addCount("Sessions", "Narrating this text",
+                    paragraphClaims.getNumSessions());
+    report.addCount("Sessions", "Paragraphs claimed",
+                    paragraphClaims.getNumClaimed());
+
+    report.addHistogram("Event loop stalls", StallMonitor::getBucketNames(),
+                        stallMonitor->getHistogram());
+    report.addCount("Event loop stalls", "Longest (ms)",
+                    stallMonitor->getLongestStallMs());
+
+    return report;
+}
+
+// The paragraphs the teleprompter shows are read from the text without being
+// kept. Those past the ones found so far are given once they are found, a few
+// at a time between events so the window stays responsive.
+QString NarrativeDirector::getTeleprompterParagraph(int prgIndex) {
+    if (prgIndex >= paragraphs.length()) {
+        teleprompterTarget = qMax(teleprompterTarget, prgIndex);
+        if (!findPrgsTimer->isActive())
+            findPrgsTimer->start();
+        return QString();
+    }
+
+    QString paragraph = paragraphs[prgIndex].second;
+    if (paragraph.isNull()) {
+        qint64 location = paragraphs[prgIndex].first;
+        paragraph = paragraphReader.readParagraph(location);
+    }
+
+    if (ui->actionSimplify->isChecked())
+        paragraph = paragraph.simplified();
+    return paragraph;
+}
+
+// Finds where the paragraphs up to the one the teleprompter waits on start,
+// as stepping through them one by one would.
+void NarrativeDirector::findParagraphsAhead() {
+    if (!narrativeFile.isOpen() || paragraphs.isEmpty()) {
+        findPrgsTimer->stop();
+        return;
+    }
+
+    qint64 location = paragraphs.last().first;
+    paragraphReader.readParagraph(location);
+
+    for (int i = 0; i < prgsFoundPerEvent; i++) {
+        narrativeInput.seek(location);
+        if (paragraphs.length() > teleprompterTarget ||
+            narrativeInput.atEnd()) {
+            teleprompterTarget = -1;
+            findPrgsTimer->stop();
+            break;
+        }
+
+        paragraphs.push_back(std::make_pair(location, QString()));
+        paragraphReader.readParagraph(location);
+    }
+
+    filePos = location;
+    teleprompter->viewport()->update();
+}
+
+// Books are read through the importer, which turns them into plain text.
+QIODevice *NarrativeDirector::getTextDevice() {
+    if (importedText.isOpen())
+        return &importedText;
+
+    return &narrativeFile;
+}
+
+QString NarrativeDirector::getRecordingPath() {
+    return ProjectFile::getRecordingPath(narrativeFile.fileName());
+}
+
+uint NarrativeDirector::getNumPrgs() {
+    TraceScope traceScope("index text");
+    narrativeInput.seek(0);
+
+    const QStringList patterns = ChapterList::getPatterns();
+    const ParagraphCounter::Counts counts = ParagraphCounter::countText(
+        narrativeInput, ChapterList::compilePatterns(patterns));
+    narrationStats.setWordCounts(counts.wordCounts);
+    chapters = counts.chapters;
+    chapterPatternsKey = ChapterList::getPatternsKey(patterns);
+
     narrativeInput.seek(0);
     filePos = narrativeInput.pos();
 
-    return numPrgs;
+    return counts.numPrgs;
 }
 
 void NarrativeDirector::on_actionGo_To_triggered() {
@@ -612,6 +1686,64 @@ void NarrativeDirector::on_actionGo_To_triggered() {
     }
 }
 
+void NarrativeDirector::on_actionGo_To_Next_Unrecorded_triggered() {
+    if (paragraphs.length() == 0)
+        return;
+
+    // Paragraphs other sessions have claimed are theirs to record.
+    int nextUnrecorded = recordedParts.getNextUnrecorded(
+        static_cast<uint>(prgNum + 1), prgNumTotal);
+    while (nextUnrecorded != -1 &&
+           paragraphClaims.isClaimedByOther(static_cast<uint>(nextUnrecorded)))
+        nextUnrecorded = recordedParts.getNextUnrecorded(
+            static_cast<uint>(nextUnrecorded + 1), prgNumTotal);
+
+    if (nextUnrecorded == -1) {
+        QMessageBox::information(this, "Go To Next Unrecorded",
+                                 "Every paragraph after this one is recorded, "
+                                 "or claimed by another session.");
+        return;
+    }
+
+    int oldPrgNum = prgNum;
+    try {
+        // Paragraphs are only discovered in order, so read up to the target.
+        while (paragraphs.length() < nextUnrecorded)
+            getParagraph(paragraphs.length());
+
+        prgNum = nextUnrecorded;
+        updatePlayerInfo();
+    } catch (std::string &myError) {
+        prgNum = oldPrgNum;
+        qDebug() << QString::fromStdString(myError);
+    }
+}
+
+// Claims the paragraphs from the current one through the one asked for, such
+// as a character's lines in a scene, before this session records them.
+void NarrativeDirector::on_actionClaim_Paragraphs_triggered() {
+    if (paragraphs.length() == 0 || !paragraphClaims.isOpen())
+        return;
+
+    bool isOkay = false;
+    int lastPrg = QInputDialog::getInt(
+        this, tr("Claim Paragraphs"),
+        tr("Claim from paragraph %1 through:").arg(prgNum + 1), prgNum + 1,
+        prgNum + 1, static_cast<int>(prgNumTotal), 1, &isOkay);
+
+    if (!isOkay)
+        return;
+
+    if (!paragraphClaims.claim(static_cast<uint>(prgNum),
+                               static_cast<uint>(lastPrg))) {
+        showErrorMsg("Some of those paragraphs are being narrated in another "
+                     "session, so none of them were claimed.");
+        return;
+    }
+
+    updateParagraphLbl(prgNum);
+}
+
 void NarrativeDirector::on_playbackSldr_sliderPressed() {
     audioPlayer->pause();
 }
@@ -1,17 +1,43 @@
 #ifndef NARRATIVEDIRECTOR_H
 #define NARRATIVEDIRECTOR_H
 
+#include "chapterlist.h"
+#include "diagnosticsreport.h"
+#include "importedtext.h"
+#include "narrationstats.h"
+#include "paragraphclaims.h"
+#include "paragraphcounter.h"
+#include "paragraphreader.h"
+#include "partcompressor.h"
+#include "partprober.h"
+#include "partslist.h"
+#include "partspack.h"
 #include "preferences.h"
+#include "projectfile.h"
+#include "projectjournal.h"
+#include "recordedpartstracker.h"
+#include "recordingsplitter.h"
+#include "stallmonitor.h"
+#include "takebuffer.h"
+#include "teleprompterview.h"
+#include "tracer.h"
+#include <QAudioProbe>
 #include <QAudioRecorder>
+#include <QBuffer>
 #include <QDateTime>
 #include <QDebug>
 #include <QFileDialog>
 #include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QFutureWatcher>
+#include <QLabel>
 #include <QMainWindow>
 #include <QMediaPlayer>
 #include <QMessageBox>
 #include <QStandardPaths>
+#include <QThread>
 #include <QTime>
+#include <QTimer>
 #include <QVector>
 #include <sstream>
 #include <utility>
@@ -32,6 +58,7 @@ public:
     explicit NarrativeDirector(QWidget *parent = nullptr);
 
     void changeParagraphLbl(int);
+    void updateParagraphLbl(int);
     uint getNumPrgs();
     QString getParagraphFromFile(qint64);
     QString getParagraph(int);
@@ -51,13 +78,21 @@ private slots:
     void on_actionOpen_triggered();
     void on_actionSave_triggered();
     void on_actionExport_Parts_File_triggered();
+    void on_actionImport_Long_Recording_triggered();
+    void on_actionStore_Parts_In_Pack_File_triggered(bool);
     void on_actionPreferences_triggered();
     void on_actionSimplify_triggered();
+    void on_actionTeleprompter_triggered(bool);
+    void on_actionRecord_Trace_triggered(bool);
+    void on_actionExport_Trace_triggered();
+    void on_actionDiagnostics_triggered();
     void on_actionAbout_Narrative_Director_triggered();
 
     void onARStateChanged(QAudioRecorder::State);
+    void onARStatusChanged(QMediaRecorder::Status);
     void updateAProgress(int);
     void updateAEnd(int);
+    void onAudioBufferProbed(const QAudioBuffer &);
 
     void onMPStateChanged(QMediaPlayer::State);
     void onMPMediaStatusChanged(QMediaPlayer::MediaStatus);
@@ -71,6 +106,15 @@ private slots:
     void displayErrorMessage();
 
     void on_actionGo_To_triggered();
+    void on_actionGo_To_Next_Unrecorded_triggered();
+    void on_actionClaim_Paragraphs_triggered();
+
+    void onRecordingDirectoryChanged();
+    void onPartProbed(uint, const RecordedPartsTracker::PartInfo &);
+    void onWordCountsFinished();
+    void onIdle();
+    void onPartsUnified();
+    void findParagraphsAhead();
 
     void on_playbackSldr_sliderPressed();
 
@@ -81,28 +125,92 @@ private:
     Preferences *preferences;
     QAudioRecorder *audioRecorder = nullptr;
     QMediaPlayer *audioPlayer = nullptr;
+    QAudioProbe *audioProbe = nullptr;
+    TakeBuffer recentTake;
+    bool isFinishingTake = false;
+    RecordedPartsTracker recordedParts;
+    QFileSystemWatcher *partsWatcher = nullptr;
+    QTimer *partsScanTimer = nullptr;
+    PartProber *partProber = nullptr;
+    NarrationStats narrationStats;
+    QFutureWatcher<ParagraphCounter::Counts> wordCountWatcher;
+    QString wordCountTextPath;
+    QString wordCountPatternsKey;
+    QLabel *statsLbl = nullptr;
+
+    PartsPack partsPack;
+    bool isPackStorage = false;
+    int pendingPackPart = -1;
+    QByteArray packedTake;
+    QBuffer packedTakeDevice;
+
+    PartCompressor *partCompressor = nullptr;
+    QFutureWatcher<bool> unifyWatcher;
+    QTimer *idleTimer = nullptr;
+    StallMonitor *stallMonitor = nullptr;
+    ParagraphClaims paragraphClaims;
+    QThread claimsThread;
+    QTimer *claimsTimer = nullptr;
+
+    // How many paragraphs ahead are found between events.
+    static const int prgsFoundPerEvent = 64;
+    TeleprompterView *teleprompter = nullptr;
+    QTimer *findPrgsTimer = nullptr;
+    int teleprompterTarget = -1;
     QUrl recordingLocation;
-
-    QVector<std::pair<int, QString>> paragraphs;
+    qint64 recordStartNs = -1;
+    qint64 mediaLoadStartNs = -1;
+
+    QVector<std::pair<qint64, QString>> paragraphs;
+    QVector<ChapterList::Chapter> chapters;
+    QString chapterPatternsKey;
+    qint64 numParagraphHits = 0;
+    qint64 numParagraphMisses = 0;
     int prgNum = 0;
     uint prgNumTotal = 0;
 
     QFile narrativeFile;
+    ImportedText importedText;
     QTextStream narrativeInput;
+    ParagraphReader paragraphReader{narrativeInput};
     qint64 filePos = 0;
     QString currentProjectFile;
     bool hasChanged = false;
+    ProjectJournal projectJournal;
+    int numJournaledPrgs = 0;
     QString audioExtension;
 
     void updatePlayerInfo();
+    void journalProgress();
+    bool checkpointProject();
+    void setPlayerToRecentTake();
+    void setPlayerToPackedPart();
     void cleanPrgs();
 
+    QIODevice *getTextDevice();
     QString getRecordingPath();
-    QString getNonExtensionFileName();
-
-    bool isEndOfSentence(const QChar &);
-    bool isEndOfQuote(const QChar &);
-    void appendUntilNextSentence(QString &);
+    QString getTrackerFilePath();
+    QString getPackFilePath();
+    QString getPartPath(uint);
+    bool unifyPartFormats(int);
+    void writeExportLists();
+    bool writeChapterLists(uint);
+    void restartIdleTimer();
+    void joinClaims();
+    bool claimParagraph(int);
+    void stopClaimsHeartbeat();
+    void packRecordedPart(uint, const QUrl &);
+    bool convertImportedParts(const QStringList &, const QStringList &);
+    bool commitImportedParts(uint, const QStringList &, const QString &);
+    bool movePartsIntoPack();
+    bool movePartsOutOfPack();
+    void removePackFiles();
+    void watchRecordingPath();
+    void refreshPartStats();
+    void countWordsInBackground();
+    void updateStatsLbl();
+    DiagnosticsReport getDiagnostics();
+    QString getTeleprompterParagraph(int);
 
     void closeEvent(QCloseEvent *event) override;
     void showErrorMsg(const QString &);
@@ -1,6 +1,10 @@
 #include "preferences.h"
+#include "chapterlist.h"
+#include "tracer.h"
 #include "ui_preferences.h"
 
+#include <QTimer>
+
 Preferences::Preferences(QWidget *parent, QAudioRecorder *recorder)
     : QDialog(parent), ui(new Ui::Preferences) {
     this->recorder = recorder;
@@ -9,40 +13,112 @@ Preferences::Preferences(QWidget *parent, QAudioRecorder *recorder)
 
     populateFromGlobals();
 
-    // audio devices
-    ui->audioDeviceBox->addItem(tr("Default"), QVariant(QString()));
-    for (auto &device : recorder->audioInputs()) {
-        ui->audioDeviceBox->addItem(device, QVariant(device));
-    }
-
-    // audio codecs
-    ui->audioCodecBox->addItem(tr("Default"), QVariant(QString()));
-    for (auto &codecName : recorder->supportedAudioCodecs()) {
-        ui->audioCodecBox->addItem(codecName, QVariant(codecName));
-    }
-
-    // containers
-    ui->containerBox->addItem(tr("Default"), QVariant(QString()));
-    for (auto &containerName : recorder->supportedContainers()) {
-        ui->containerBox->addItem(containerName, QVariant(containerName));
-    }
-
-    // sample rate
-    ui->sampleRateBox->addItem(tr("Default"), QVariant(0));
-    for (int sampleRate : recorder->supportedAudioSampleRates()) {
-        ui->sampleRateBox->addItem(QString::number(sampleRate),
-                                   QVariant(sampleRate));
-    }
+    // Asking the backend what it supports can stall for seconds, so the
+    // boxes start out with what it said last time. The backend only works
+    // on the main thread, so it is asked there, once the dialog is shown
+    // and whenever the inputs change.
+    const bool isCached =
+        AudioCapabilities::load(AudioCapabilities::getCachePath(),
+                                capabilities) &&
+        capabilities.fingerprint == AudioCapabilities::getFingerprint();
+    if (!isCached)
+        capabilities = AudioCapabilities();
+    showCapabilities();
+
+    if (recorder != nullptr)
+        connect(recorder, &QAudioRecorder::availableAudioInputsChanged, this,
+                &Preferences::refreshCapabilities);
 
     // channels
     ui->channelsBox->addItem(tr("Default"), QVariant(-1));
     ui->channelsBox->addItem(QStringLiteral("1"), QVariant(1));
     ui->channelsBox->addItem(QStringLiteral("2"), QVariant(2));
     ui->channelsBox->addItem(QStringLiteral("4"), QVariant(4));
+
+    // chapter headings
+    ui->chapterPatternsEdit->setPlainText(
+        ChapterList::getPatterns().join('\n'));
 }
 
 Preferences::~Preferences() { delete ui; }
 
+// Asks the recorder being recorded with, since a recorder may only be used
+// on the thread it belongs to.
+AudioCapabilities Preferences::probeCapabilities() const {
+    TraceScope trace("probe audio");
+
+    AudioCapabilities probed;
+    probed.fingerprint = AudioCapabilities::getFingerprint();
+    probed.inputs = recorder->audioInputs();
+    probed.codecs = recorder->supportedAudioCodecs();
+    probed.containers = recorder->supportedContainers();
+    probed.sampleRates = recorder->supportedAudioSampleRates().toVector();
+
+    return probed;
+}
+
+// Devices may have come or gone since the backend was last asked, which is
+// checked once the dialog is first on screen rather than before it is.
+void Preferences::showEvent(QShowEvent *event) {
+    QDialog::showEvent(event);
+    if (!isProbed)
+        QTimer::singleShot(0, this, &Preferences::refreshCapabilities);
+}
+
+void Preferences::refreshCapabilities() {
+    if (recorder == nullptr)
+        return;
+
+    isProbed = true;
+    const AudioCapabilities probed = probeCapabilities();
+    if (probed == capabilities)
+        return;
+
+    capabilities = probed;
+    capabilities.save(AudioCapabilities::getCachePath());
+    showCapabilities();
+}
+
+static void setBoxItems(QComboBox *box, const QVariant &defaultValue,
+                        const QStringList &names,
+                        const QVariantList &values) {
+    const QVariant selected = box->currentData();
+
+    box->clear();
+    box->addItem(QObject::tr("Default"), defaultValue);
+    for (int item = 0; item < names.size(); item++)
+        box->addItem(names[item], values[item]);
+
+    box->setCurrentIndex(qMax(0, box->findData(selected)));
+}
+
+static QVariantList toVariants(const QStringList &names) {
+    QVariantList values;
+    for (const QString &name : names)
+        values.append(QVariant(name));
+
+    return values;
+}
+
+// Keeps whatever was picked in each box, as long as it is still offered.
+void Preferences::showCapabilities() {
+    setBoxItems(ui->audioDeviceBox, QVariant(QString()), capabilities.inputs,
+                toVariants(capabilities.inputs));
+    setBoxItems(ui->audioCodecBox, QVariant(QString()), capabilities.codecs,
+                toVariants(capabilities.codecs));
+    setBoxItems(ui->containerBox, QVariant(QString()),
+                capabilities.containers, toVariants(capabilities.containers));
+
+    QStringList sampleRateNames;
+    QVariantList sampleRateValues;
+    for (int sampleRate : capabilities.sampleRates) {
+        sampleRateNames.append(QString::number(sampleRate));
+        sampleRateValues.append(QVariant(sampleRate));
+    }
+    setBoxItems(ui->sampleRateBox, QVariant(0), sampleRateNames,
+                sampleRateValues);
+}
+
 static QVariant boxValue(const QComboBox *box) {
     int idx = box->currentIndex();
     if (idx == -1)
@@ -71,6 +147,10 @@ void Preferences::on_buttonBox_accepted() {
 
     recorder->setEncodingSettings(settings, QVideoEncoderSettings(),
                                   selectedContainer);
+
+    // Texts are searched for chapters again the next time they are counted.
+    ChapterList::setPatterns(ui->chapterPatternsEdit->toPlainText().split(
+        '\n', QString::SkipEmptyParts));
 }
 
 void Preferences::populateFromGlobals() {
@@ -1,6 +1,8 @@
 #ifndef PREFERENCES_H
 #define PREFERENCES_H
 
+#include "audiocapabilities.h"
+
 #include <QAudioRecorder>
 #include <QDialog>
 #include <QMultimedia>
@@ -18,15 +20,25 @@ public:
                          QAudioRecorder *recorder = nullptr);
     ~Preferences();
 
+    AudioCapabilities probeCapabilities() const;
+
+protected:
+    void showEvent(QShowEvent *) override;
+
 private slots:
     void on_buttonBox_accepted();
+    void refreshCapabilities();
 
 private:
     Ui::Preferences *ui;
     QAudioRecorder *recorder;
     QSettings globalSettings;
 
+    AudioCapabilities capabilities;
+    bool isProbed = false;
+
     void populateFromGlobals();
+    void showCapabilities();
 };
 
 #endif // PREFERENCES_H
@@ -0,0 +1,170 @@
+#include "teleprompterview.h"
+
+#include <QPainter>
+#include <QScrollBar>
+#include <QTextOption>
+
+TeleprompterView::TeleprompterView(QWidget *parent)
+    : QAbstractScrollArea(parent), layouts(maxCachedLayouts) {
+    QFont teleprompterFont = font();
+    if (teleprompterFont.pointSizeF() > 0)
+        teleprompterFont.setPointSizeF(teleprompterFont.pointSizeF() * 1.5);
+    else
+        teleprompterFont.setPixelSize(teleprompterFont.pixelSize() * 3 / 2);
+    setFont(teleprompterFont);
+
+    setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    verticalScrollBar()->setSingleStep(stepsPerParagraph / 4);
+    verticalScrollBar()->setPageStep(stepsPerParagraph);
+    viewport()->setBackgroundRole(QPalette::Base);
+}
+
+void TeleprompterView::setParagraphSource(const ParagraphSource &source) {
+    paragraphSource = source;
+    refresh();
+}
+
+void TeleprompterView::setNumParagraphs(int numParagraphs) {
+    if (numParagraphs == numPrgs)
+        return;
+
+    numPrgs = numParagraphs;
+    updateScrollRange();
+    viewport()->update();
+}
+
+// Scrolls the paragraph to the top unless all of it can already be read.
+void TeleprompterView::setCurrentParagraph(int prg) {
+    currentPrg = prg;
+
+    if (!isFullyVisible(prg))
+        verticalScrollBar()->setValue(prg * stepsPerParagraph);
+    viewport()->update();
+}
+
+int TeleprompterView::getCurrentParagraph() const { return currentPrg; }
+
+// Lays out every paragraph again, such as when the text was changed.
+void TeleprompterView::refresh() {
+    layouts.clear();
+    placeholderLayout.reset();
+    viewport()->update();
+}
+
+void TeleprompterView::paintEvent(QPaintEvent *) {
+    QPainter painter(viewport());
+
+    const int viewHeight = viewport()->height();
+    int prg = verticalScrollBar()->value() / stepsPerParagraph;
+    qreal top = getFirstTop();
+
+    QColor highlightColor = palette().color(QPalette::Highlight);
+    highlightColor.setAlpha(60);
+    QColor readAheadColor = palette().color(QPalette::Text);
+    readAheadColor.setAlpha(160);
+
+    for (; prg < numPrgs && top < viewHeight; prg++) {
+        QTextLayout *layout = getLayout(prg);
+        const qreal height = layout->boundingRect().height();
+
+        if (prg == currentPrg) {
+            painter.fillRect(QRectF(0, top - getSpacing() / 2.0,
+                                    viewport()->width(), height + getSpacing()),
+                             highlightColor);
+            painter.setPen(palette().color(QPalette::Text));
+        } else {
+            painter.setPen(readAheadColor);
+        }
+
+        layout->draw(&painter, QPointF(getMargin(), top));
+        top += height + getSpacing();
+    }
+}
+
+void TeleprompterView::resizeEvent(QResizeEvent *event) {
+    layouts.clear();
+    placeholderLayout.reset();
+    QAbstractScrollArea::resizeEvent(event);
+}
+
+void TeleprompterView::scrollContentsBy(int, int) { viewport()->update(); }
+
+int TeleprompterView::getMargin() const { return fontMetrics().height() / 2; }
+
+int TeleprompterView::getSpacing() const {
+    return fontMetrics().lineSpacing();
+}
+
+qreal TeleprompterView::getHeight(int prg) {
+    return getLayout(prg)->boundingRect().height();
+}
+
+// Where the first paragraph on screen starts, which is above the top of the
+// view once the scroll bar is part of the way through it.
+qreal TeleprompterView::getFirstTop() {
+    const int value = verticalScrollBar()->value();
+    const int firstPrg = value / stepsPerParagraph;
+    if (firstPrg >= numPrgs)
+        return 0;
+
+    return -getHeight(firstPrg) * (value % stepsPerParagraph) /
+           stepsPerParagraph;
+}
+
+// The layout is only good until the next one is asked for, since that may
+// push it out of the cache.
+QTextLayout *TeleprompterView::getLayout(int prg) {
+    QTextLayout *layout = layouts.object(prg);
+    if (layout != nullptr)
+        return layout;
+
+    const QString paragraph =
+        paragraphSource ? paragraphSource(prg) : QString();
+    layout = new QTextLayout(paragraph.isNull() ? QString("...") : paragraph,
+                             font());
+
+    QTextOption textOption;
+    textOption.setWrapMode(QTextOption::WrapAtWordBoundaryOrAnywhere);
+    layout->setTextOption(textOption);
+    layout->setCacheEnabled(true);
+
+    const qreal lineWidth = qMax(1, viewport()->width() - 2 * getMargin());
+    qreal height = 0;
+    layout->beginLayout();
+    for (QTextLine line = layout->createLine(); line.isValid();
+         line = layout->createLine()) {
+        line.setLineWidth(lineWidth);
+        line.setPosition(QPointF(0, height));
+        height += line.height();
+    }
+    layout->endLayout();
+
+    // Placeholders are laid out again until their paragraph can be read.
+    if (paragraph.isNull()) {
+        placeholderLayout.reset(layout);
+        return layout;
+    }
+
+    layouts.insert(prg, layout);
+    return layout;
+}
+
+bool TeleprompterView::isFullyVisible(int prg) {
+    int visiblePrg = verticalScrollBar()->value() / stepsPerParagraph;
+    if (prg < visiblePrg || prg >= numPrgs)
+        return false;
+
+    const int viewHeight = viewport()->height();
+    qreal top = getFirstTop();
+    for (; visiblePrg < prg; visiblePrg++) {
+        top += getHeight(visiblePrg) + getSpacing();
+        if (top >= viewHeight)
+            return false;
+    }
+
+    return top >= 0 && top + getHeight(prg) <= viewHeight;
+}
+
+void TeleprompterView::updateScrollRange() {
+    verticalScrollBar()->setRange(0, qMax(0, numPrgs - 1) * stepsPerParagraph);
+}
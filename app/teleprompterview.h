@@ -0,0 +1,58 @@
+#ifndef TELEPROMPTERVIEW_H
+#define TELEPROMPTERVIEW_H
+
+#include <QAbstractScrollArea>
+#include <QCache>
+#include <QTextLayout>
+#include <functional>
+#include <memory>
+
+// Shows the text as one scrolling column of paragraphs with the one being
+// narrated highlighted, so the narrator can read ahead. Only the paragraphs
+// on screen are asked for and laid out, and only a few layouts are kept, so
+// scrolling costs the same in a short story as in a long series.
+//
+// Since paragraphs are not laid out until they are shown, the scroll bar
+// moves through paragraphs rather than pixels: each paragraph takes up the
+// same length of it, however tall it is.
+class TeleprompterView : public QAbstractScrollArea {
+    Q_OBJECT
+
+public:
+    // Returns the paragraph's text, or a null string when it cannot be
+    // given yet. The view asks again when it is next updated.
+    using ParagraphSource = std::function<QString(int)>;
+
+    static const int maxCachedLayouts = 64;
+    static const int stepsPerParagraph = 100;
+
+    explicit TeleprompterView(QWidget *parent = nullptr);
+
+    void setParagraphSource(const ParagraphSource &);
+    void setNumParagraphs(int);
+    void setCurrentParagraph(int);
+    int getCurrentParagraph() const;
+    void refresh();
+
+protected:
+    void paintEvent(QPaintEvent *) override;
+    void resizeEvent(QResizeEvent *) override;
+    void scrollContentsBy(int, int) override;
+
+private:
+    ParagraphSource paragraphSource;
+    QCache<int, QTextLayout> layouts;
+    std::unique_ptr<QTextLayout> placeholderLayout;
+    int numPrgs = 0;
+    int currentPrg = 0;
+
+    int getMargin() const;
+    int getSpacing() const;
+    qreal getHeight(int);
+    qreal getFirstTop();
+    QTextLayout *getLayout(int);
+    bool isFullyVisible(int);
+    void updateScrollRange();
+};
+
+#endif // TELEPROMPTERVIEW_H
@@ -0,0 +1,95 @@
+#include "audiocapabilities.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QLibraryInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QSysInfo>
+
+static const quint32 cacheMagic = 0x4e444143; // "NDAC"
+static const quint16 cacheVersion = 1;
+
+bool AudioCapabilities::operator==(const AudioCapabilities &other) const {
+    return fingerprint == other.fingerprint && inputs == other.inputs &&
+           codecs == other.codecs && containers == other.containers &&
+           sampleRates == other.sampleRates;
+}
+
+bool AudioCapabilities::operator!=(const AudioCapabilities &other) const {
+    return !(*this == other);
+}
+
+bool AudioCapabilities::save(const QString &cachePath) const {
+    QDir().mkpath(QFileInfo(cachePath).absolutePath());
+
+    QSaveFile cacheFile(cachePath);
+    if (!cacheFile.open(QIODevice::WriteOnly))
+        return false;
+
+    QDataStream cacheOutput(&cacheFile);
+    cacheOutput << cacheMagic << cacheVersion << fingerprint << inputs
+                << codecs << containers << sampleRates;
+    if (cacheOutput.status() != QDataStream::Ok) {
+        cacheFile.cancelWriting();
+        return false;
+    }
+
+    return cacheFile.commit();
+}
+
+// Leaves the capabilities alone unless the whole cache could be read.
+bool AudioCapabilities::load(const QString &cachePath,
+                             AudioCapabilities &capabilities) {
+    QFile cacheFile(cachePath);
+    if (!cacheFile.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream cacheInput(&cacheFile);
+    quint32 magic = 0;
+    quint16 version = 0;
+    cacheInput >> magic >> version;
+    if (magic != cacheMagic || version != cacheVersion)
+        return false;
+
+    AudioCapabilities cached;
+    cacheInput >> cached.fingerprint >> cached.inputs >> cached.codecs >>
+        cached.containers >> cached.sampleRates;
+    if (cacheInput.status() != QDataStream::Ok)
+        return false;
+
+    capabilities = cached;
+    return true;
+}
+
+QString AudioCapabilities::getCachePath() {
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) +
+           "/audio-capabilities";
+}
+
+// Changes when Qt, the system or the multimedia plugins do, which is when
+// the backend may answer differently. Devices coming and going do not change
+// it; those are picked up when the capabilities are next asked for.
+QByteArray AudioCapabilities::getFingerprint() {
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(qVersion());
+    hash.addData(QSysInfo::buildAbi().toUtf8());
+    hash.addData(QSysInfo::kernelVersion().toUtf8());
+
+    const QString pluginsPath =
+        QLibraryInfo::location(QLibraryInfo::PluginsPath);
+    for (const char *pluginType : {"mediaservice", "audio"}) {
+        const QDir pluginDir(pluginsPath + '/' + pluginType);
+        for (const QFileInfo &plugin :
+             pluginDir.entryInfoList(QDir::Files, QDir::Name)) {
+            hash.addData(plugin.fileName().toUtf8());
+            hash.addData(QByteArray::number(
+                plugin.lastModified().toMSecsSinceEpoch()));
+        }
+    }
+
+    return hash.result().toHex();
+}
@@ -0,0 +1,30 @@
+#ifndef AUDIOCAPABILITIES_H
+#define AUDIOCAPABILITIES_H
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// What the audio backend can record with: its input devices, codecs,
+// containers and sample rates. Asking the backend can take seconds on some
+// systems, so what it said last is kept on disk along with a fingerprint of
+// the backend, and is only trusted while the fingerprint still matches.
+struct AudioCapabilities {
+    QByteArray fingerprint;
+    QStringList inputs;
+    QStringList codecs;
+    QStringList containers;
+    QVector<int> sampleRates;
+
+    bool operator==(const AudioCapabilities &) const;
+    bool operator!=(const AudioCapabilities &) const;
+
+    bool save(const QString &) const;
+    static bool load(const QString &, AudioCapabilities &);
+
+    static QString getCachePath();
+    static QByteArray getFingerprint();
+};
+
+#endif // AUDIOCAPABILITIES_H
@@ -0,0 +1,181 @@
+#include "chapterlist.h"
+
+#include <QCryptographicHash>
+#include <QFile>
+#include <QSettings>
+#include <QTextStream>
+
+// The program and the command line tool have different application names,
+// so the patterns are kept under names of their own that both share.
+static const char *settingsOrganization = "narrative-director";
+static const char *settingsApplication = "narrative-director";
+
+QStringList ChapterList::getDefaultPatterns() {
+    const QString numberWords =
+        "(one|two|three|four|five|six|seven|eight|nine|ten|eleven|twelve|"
+        "thirteen|fourteen|fifteen|sixteen|seventeen|eighteen|nineteen|"
+        "twenty|thirty|forty|fifty|sixty|seventy|eighty|ninety|hundred)"
+        "([- ][a-z]+)?";
+
+    return {"^(chapter|part|book)\\s+([0-9]+|[ivxlcdm]+|" + numberWords +
+                ")\\b.*$",
+            "^(prologue|epilogue|preface|foreword|introduction|afterword)"
+            "\\b.*$"};
+}
+
+QStringList ChapterList::getPatterns() {
+    QSettings globalSettings(settingsOrganization, settingsApplication);
+    if (!globalSettings.contains("chapters/patterns"))
+        return getDefaultPatterns();
+
+    return globalSettings.value("chapters/patterns").toStringList();
+}
+
+void ChapterList::setPatterns(const QStringList &patterns) {
+    QSettings globalSettings(settingsOrganization, settingsApplication);
+    globalSettings.setValue("chapters/patterns", patterns);
+}
+
+// Tells apart chapters found with different patterns, so that a project
+// knows to find its chapters again once the patterns change.
+QString ChapterList::getPatternsKey(const QStringList &patterns) {
+    return QString::fromLatin1(
+        QCryptographicHash::hash(patterns.join('\n').toUtf8(),
+                                 QCryptographicHash::Sha1)
+            .toHex()
+            .left(16));
+}
+
+// Patterns match without regard to case. Ones that do not compile are left
+// out rather than matching nothing in a way that is hard to notice.
+QVector<QRegularExpression>
+ChapterList::compilePatterns(const QStringList &patterns) {
+    QVector<QRegularExpression> compiledPatterns;
+    for (const QString &pattern : patterns) {
+        if (pattern.trimmed().isEmpty())
+            continue;
+
+        QRegularExpression compiledPattern(
+            pattern, QRegularExpression::CaseInsensitiveOption);
+        if (compiledPattern.isValid())
+            compiledPatterns.append(compiledPattern);
+    }
+
+    return compiledPatterns;
+}
+
+// Adds the line as a chapter when it is a heading. Whatever comes before the
+// first heading becomes an untitled chapter of its own, and of headings that
+// share a paragraph, such as a part's followed by its first chapter's, the
+// last one names the chapter.
+void ChapterList::addHeading(QVector<Chapter> &chapters, const QString &line,
+                             uint prg,
+                             const QVector<QRegularExpression> &patterns) {
+    const QString title = line.simplified();
+    if (title.isEmpty() || title.size() > maxHeadingLength)
+        return;
+
+    bool isHeading = false;
+    for (const QRegularExpression &pattern : patterns) {
+        if (pattern.match(title).hasMatch()) {
+            isHeading = true;
+            break;
+        }
+    }
+
+    if (!isHeading)
+        return;
+
+    if (chapters.isEmpty() && prg > 0)
+        chapters.append(Chapter());
+
+    if (!chapters.isEmpty() && chapters.last().firstPrg == prg) {
+        chapters.last().title = title;
+        return;
+    }
+
+    Chapter chapter;
+    chapter.firstPrg = prg;
+    chapter.title = title;
+    chapters.append(chapter);
+}
+
+// The paragraph after the chapter's last one.
+uint ChapterList::getEndPrg(const QVector<Chapter> &chapters, int chapter,
+                            uint numPrgs) {
+    if (chapter + 1 < chapters.size())
+        return qMin(chapters[chapter + 1].firstPrg, numPrgs);
+
+    return numPrgs;
+}
+
+// Numbered so that chapter files sort in the order they are read, and kept
+// free of characters that file systems do not allow.
+QString ChapterList::getFileName(const QVector<Chapter> &chapters,
+                                 int chapter) {
+    QString fileName =
+        QString::number(chapter + 1).rightJustified(2, QChar('0'));
+
+    QString title = chapters[chapter].title;
+    title.replace(QRegularExpression("[\\\\/:*?\"<>|]"), "_");
+    if (!title.isEmpty())
+        fileName += " " + title;
+
+    return fileName;
+}
+
+QString ChapterList::getMetadataPath(const QString &recordingPath) {
+    return recordingPath + "/chapters.txt";
+}
+
+// Writes the chapters as ffmpeg metadata, timed by the lengths of the parts
+// before them. Parts that were not recorded take no time, since they are not
+// joined either.
+bool ChapterList::writeMetadata(const QString &metadataPath,
+                                const QString &bookTitle,
+                                const QVector<Chapter> &chapters,
+                                const QVector<qint64> &partDurationsMs) {
+    QFile metadataFile(metadataPath);
+    if (!metadataFile.open(QIODevice::WriteOnly | QIODevice::Text))
+        return false;
+
+    const uint numPrgs = static_cast<uint>(partDurationsMs.size());
+
+    QTextStream fileOutput(&metadataFile);
+    fileOutput.setCodec("UTF-8");
+    fileOutput << ";FFMETADATA1\n"
+               << "title=" << escapeMetadata(bookTitle) << '\n';
+
+    qint64 chapterStartMs = 0;
+    for (int chapter = 0; chapter < chapters.size(); chapter++) {
+        qint64 chapterEndMs = chapterStartMs;
+        const uint endPrg = getEndPrg(chapters, chapter, numPrgs);
+        for (uint prg = chapters[chapter].firstPrg; prg < endPrg; prg++)
+            chapterEndMs += partDurationsMs[static_cast<int>(prg)];
+
+        fileOutput << "\n[CHAPTER]\n"
+                   << "TIMEBASE=1/1000\n"
+                   << "START=" << chapterStartMs << '\n'
+                   << "END=" << chapterEndMs << '\n';
+        if (!chapters[chapter].title.isEmpty())
+            fileOutput << "title=" << escapeMetadata(chapters[chapter].title)
+                       << '\n';
+
+        chapterStartMs = chapterEndMs;
+    }
+    fileOutput << flush;
+
+    return fileOutput.status() == QTextStream::Ok;
+}
+
+QString ChapterList::escapeMetadata(const QString &value) {
+    QString escapedValue;
+    for (const QChar &letter : value) {
+        if (letter == '=' || letter == ';' || letter == '#' ||
+            letter == '\\' || letter == '\n')
+            escapedValue += '\\';
+        escapedValue += letter;
+    }
+
+    return escapedValue;
+}
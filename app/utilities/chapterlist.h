@@ -0,0 +1,46 @@
+#ifndef CHAPTERLIST_H
+#define CHAPTERLIST_H
+
+#include <QRegularExpression>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// Finds the chapters of a text by its headings, which are whole lines that
+// match one of the patterns set in the preferences. A chapter starts at the
+// paragraph its heading is in and runs up to the next chapter's.
+class ChapterList {
+public:
+    struct Chapter {
+        uint firstPrg = 0;
+        QString title;
+
+        bool operator==(const Chapter &other) const {
+            return firstPrg == other.firstPrg && title == other.title;
+        }
+    };
+
+    // Headings are short, so longer lines are not matched at all.
+    static const int maxHeadingLength = 100;
+
+    static QStringList getDefaultPatterns();
+    static QStringList getPatterns();
+    static void setPatterns(const QStringList &);
+    static QString getPatternsKey(const QStringList &);
+    static QVector<QRegularExpression> compilePatterns(const QStringList &);
+
+    static void addHeading(QVector<Chapter> &, const QString &, uint,
+                           const QVector<QRegularExpression> &);
+    static uint getEndPrg(const QVector<Chapter> &, int, uint);
+    static QString getFileName(const QVector<Chapter> &, int);
+
+    static QString getMetadataPath(const QString &);
+    static bool writeMetadata(const QString &, const QString &,
+                              const QVector<Chapter> &,
+                              const QVector<qint64> &);
+
+private:
+    static QString escapeMetadata(const QString &);
+};
+
+#endif // CHAPTERLIST_H
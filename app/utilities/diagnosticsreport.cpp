@@ -0,0 +1,112 @@
+#include "diagnosticsreport.h"
+
+#include <QFile>
+
+static const QString memorySection = "Memory";
+static const QString processSection = "Process";
+
+void DiagnosticsReport::addBytes(const QString &subsystem, qint64 bytes) {
+    addEntry(memorySection, subsystem, formatBytes(bytes));
+    totalBytes += bytes;
+}
+
+void DiagnosticsReport::addCount(const QString &section, const QString &name,
+                                 qint64 count) {
+    addEntry(section, name, QString::number(count));
+}
+
+void DiagnosticsReport::addRatio(const QString &section, const QString &name,
+                                 qint64 hits, qint64 misses) {
+    const qint64 lookups = hits + misses;
+    if (lookups == 0) {
+        addEntry(section, name, "no lookups");
+        return;
+    }
+
+    addEntry(section, name,
+             QString("%1% hits (%2 of %3)")
+                 .arg(100.0 * hits / lookups, 0, 'f', 1)
+                 .arg(hits)
+                 .arg(lookups));
+}
+
+void DiagnosticsReport::addHistogram(const QString &section,
+                                     const QStringList &bucketNames,
+                                     const QVector<qint64> &bucketCounts) {
+    for (int bucket = 0; bucket < bucketNames.size(); bucket++)
+        addEntry(section, bucketNames[bucket],
+                 QString::number(bucketCounts.value(bucket)));
+}
+
+// What the operating system says the process holds, to compare with the
+// subsystems above. Only Linux reports it.
+void DiagnosticsReport::addProcessMemory() {
+    QFile statusFile("/proc/self/status");
+    if (!statusFile.open(QIODevice::ReadOnly | QIODevice::Text))
+        return;
+
+    for (const QByteArray &line : statusFile.readAll().split('\n')) {
+        const bool isResident = line.startsWith("VmRSS:");
+        if (!isResident && !line.startsWith("VmHWM:"))
+            continue;
+
+        const qint64 kilobytes =
+            line.mid(6).trimmed().split(' ').value(0).toLongLong();
+        addEntry(processSection, isResident ? "Resident" : "Peak resident",
+                 formatBytes(kilobytes * 1024));
+    }
+}
+
+qint64 DiagnosticsReport::getTotalBytes() const { return totalBytes; }
+
+// Sections come in the order their first entry was added.
+QString DiagnosticsReport::toText() const {
+    QStringList sections;
+    int nameWidth = 0;
+    for (const Entry &entry : entries) {
+        if (!sections.contains(entry.section))
+            sections.append(entry.section);
+        nameWidth = qMax(nameWidth, entry.name.size());
+    }
+
+    QString text;
+    for (const QString &section : sections) {
+        text += section + '\n';
+        for (const Entry &entry : entries) {
+            if (entry.section == section)
+                text += "  " + entry.name.leftJustified(nameWidth + 2) +
+                        entry.value + '\n';
+        }
+
+        if (section == memorySection)
+            text += "  " + QString("Total").leftJustified(nameWidth + 2) +
+                    formatBytes(totalBytes) + '\n';
+        text += '\n';
+    }
+
+    return text.trimmed() + '\n';
+}
+
+qint64 DiagnosticsReport::getStringBytes(const QString &text) {
+    return static_cast<qint64>(text.capacity()) * sizeof(QChar);
+}
+
+QString DiagnosticsReport::formatBytes(qint64 bytes) {
+    if (bytes < 1024)
+        return QString("%1 B").arg(bytes);
+    if (bytes < 1024 * 1024)
+        return QString("%1 KB").arg(bytes / 1024.0, 0, 'f', 1);
+    if (bytes < 1024 * 1024 * 1024)
+        return QString("%1 MB").arg(bytes / (1024.0 * 1024), 0, 'f', 1);
+
+    return QString("%1 GB").arg(bytes / (1024.0 * 1024 * 1024), 0, 'f', 2);
+}
+
+void DiagnosticsReport::addEntry(const QString &section, const QString &name,
+                                 const QString &value) {
+    Entry entry;
+    entry.section = section;
+    entry.name = name;
+    entry.value = value;
+    entries.append(entry);
+}
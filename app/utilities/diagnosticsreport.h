@@ -0,0 +1,46 @@
+#ifndef DIAGNOSTICSREPORT_H
+#define DIAGNOSTICSREPORT_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <utility>
+
+// Gathers what a session holds in memory by subsystem, how well its caches
+// do and how long the event loop stalled, as text grouped into sections.
+// Sizes are what the containers have reserved, so they are close to, but
+// not exactly, what the allocator handed out.
+class DiagnosticsReport {
+public:
+    void addBytes(const QString &, qint64);
+    void addCount(const QString &, const QString &, qint64);
+    void addRatio(const QString &, const QString &, qint64, qint64);
+    void addHistogram(const QString &, const QStringList &,
+                      const QVector<qint64> &);
+    void addProcessMemory();
+
+    qint64 getTotalBytes() const;
+    QString toText() const;
+
+    static qint64 getStringBytes(const QString &);
+    static QString formatBytes(qint64);
+
+    template <typename T>
+    static qint64 getVectorBytes(const QVector<T> &vector) {
+        return static_cast<qint64>(vector.capacity()) * sizeof(T);
+    }
+
+private:
+    struct Entry {
+        QString section;
+        QString name;
+        QString value;
+    };
+
+    QVector<Entry> entries;
+    qint64 totalBytes = 0;
+
+    void addEntry(const QString &, const QString &, const QString &);
+};
+
+#endif // DIAGNOSTICSREPORT_H
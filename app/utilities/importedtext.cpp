@@ -0,0 +1,296 @@
+#include "importedtext.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QUrl>
+#include <QXmlStreamReader>
+#include <algorithm>
+#include <cstring>
+
+ImportedText::ImportedText() {}
+
+ImportedText::~ImportedText() { close(); }
+
+bool ImportedText::isImported(const QString &path) {
+    static const QStringList suffixes = {"epub",  "htm",      "html",
+                                         "xhtml", "markdown", "md"};
+    return suffixes.contains(QFileInfo(path).suffix().toLower());
+}
+
+// Opens a text file to be read as it is, or a book to be read through the
+// importer, and returns what to read its text from. The file is left open
+// either way, so it can still be asked whether a text is open.
+QIODevice *ImportedText::openTextDevice(const QString &path, QFile &textFile,
+                                        ImportedText &importedText) {
+    importedText.close();
+    textFile.setFileName(path);
+    if (!isImported(path))
+        return textFile.open(QIODevice::ReadOnly | QIODevice::Text)
+                   ? &textFile
+                   : nullptr;
+
+    if (!textFile.open(QIODevice::ReadOnly))
+        return nullptr;
+    if (!importedText.openText(path)) {
+        textFile.close();
+        return nullptr;
+    }
+
+    return &importedText;
+}
+
+// Makes the whole text once, keeping only its size and the places it can be
+// made again from.
+bool ImportedText::openText(const QString &path) {
+    close();
+
+    const QString suffix = QFileInfo(path).suffix().toLower();
+    format = suffix == "md" || suffix == "markdown" ? MarkupStripper::Markdown
+                                                    : MarkupStripper::Html;
+
+    sourceFile.setFileName(path);
+    if (!sourceFile.open(QIODevice::ReadOnly)) {
+        setErrorString(sourceFile.errorString());
+        return false;
+    }
+
+    if (suffix == "epub") {
+        if (!findEpubDocuments()) {
+            sourceFile.close();
+            return false;
+        }
+    } else {
+        Document wholeFile;
+        wholeFile.name = QFileInfo(path).fileName();
+        documents.append(wholeFile);
+    }
+
+    Checkpoint start;
+    start.stripper = MarkupStripper(format);
+    checkpoints.append(start);
+
+    restart(0);
+    while (produce(windowStart + window.size(), sourceChunkSize, true))
+        continue;
+    textSize = windowStart + window.size();
+    restart(0);
+
+    return QIODevice::open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+}
+
+void ImportedText::close() {
+    QIODevice::close();
+
+    entryReader.close();
+    sourceFile.close();
+    documents.clear();
+    checkpoints.clear();
+    textSize = 0;
+    readPos = 0;
+    document = 0;
+    sourcePos = 0;
+    window.clear();
+    windowStart = 0;
+}
+
+qint64 ImportedText::size() const { return textSize; }
+
+bool ImportedText::seek(qint64 pos) {
+    if (!QIODevice::seek(pos))
+        return false;
+
+    readPos = pos;
+    return true;
+}
+
+QStringList ImportedText::getDocuments() const {
+    QStringList names;
+    for (const Document &source : documents)
+        names.append(source.name);
+
+    return names;
+}
+
+// Finds the document and the byte in it that the letter at the place given
+// was made from.
+ImportedText::SourcePosition ImportedText::getSourcePosition(qint64 textPos) {
+    SourcePosition position;
+    if (!isOpen() || textPos < 0 || textPos >= textSize)
+        return position;
+
+    restart(textPos);
+    int producedDocument = document;
+    qint64 producedPos = sourcePos;
+    while (windowStart + window.size() <= textPos) {
+        producedDocument = document;
+        producedPos = sourcePos;
+        if (!produce(textPos, 1, false))
+            break;
+    }
+
+    position.document = documents.value(producedDocument).name;
+    position.offset = producedPos;
+    return position;
+}
+
+qint64 ImportedText::readData(char *data, qint64 maxSize) {
+    if (readPos < windowStart)
+        restart(readPos);
+    while (readPos >= windowStart + window.size() &&
+           produce(readPos, sourceChunkSize, false))
+        continue;
+
+    const qint64 numAvailable = windowStart + window.size() - readPos;
+    if (numAvailable <= 0)
+        return 0;
+
+    const qint64 numBytes = qMin(maxSize, numAvailable);
+    std::memcpy(data, window.constData() + (readPos - windowStart),
+                static_cast<size_t>(numBytes));
+    readPos += numBytes;
+
+    return numBytes;
+}
+
+qint64 ImportedText::writeData(const char *, qint64) { return -1; }
+
+// The chapters are the package document's spine, in reading order, leaving
+// out what it marks as not part of the reading order, such as its table of
+// contents.
+bool ImportedText::findEpubDocuments() {
+    if (!archive.open(&sourceFile)) {
+        setErrorString("The file is not an EPUB.");
+        return false;
+    }
+
+    QString packagePath;
+    QXmlStreamReader containerReader(archive.readEntry(
+        archive.findEntry("META-INF/container.xml"), maxMetadataSize));
+    while (!containerReader.atEnd() && packagePath.isEmpty()) {
+        containerReader.readNext();
+        if (containerReader.isStartElement() &&
+            containerReader.name() == QLatin1String("rootfile"))
+            packagePath = containerReader.attributes()
+                              .value(QLatin1String("full-path"))
+                              .toString();
+    }
+
+    const QString packageDir =
+        packagePath.left(packagePath.lastIndexOf('/') + 1);
+    QHash<QString, QString> chapterPaths;
+    QStringList spine;
+
+    QXmlStreamReader packageReader(
+        archive.readEntry(archive.findEntry(packagePath), maxMetadataSize));
+    while (!packageReader.atEnd()) {
+        packageReader.readNext();
+        if (!packageReader.isStartElement())
+            continue;
+
+        const QXmlStreamAttributes attributes = packageReader.attributes();
+        const QString mediaType =
+            attributes.value(QLatin1String("media-type")).toString();
+        if (packageReader.name() == QLatin1String("item") &&
+            (mediaType == "application/xhtml+xml" || mediaType == "text/html"))
+            chapterPaths.insert(
+                attributes.value(QLatin1String("id")).toString(),
+                attributes.value(QLatin1String("href")).toString());
+        else if (packageReader.name() == QLatin1String("itemref") &&
+                 attributes.value(QLatin1String("linear")) !=
+                     QLatin1String("no"))
+            spine.append(attributes.value(QLatin1String("idref")).toString());
+    }
+
+    for (const QString &chapterId : spine) {
+        QString chapterPath = chapterPaths.value(chapterId);
+        chapterPath = chapterPath.left(chapterPath.indexOf('#'));
+        if (chapterPath.isEmpty())
+            continue;
+
+        Document chapter;
+        chapter.name = QDir::cleanPath(
+            packageDir + QUrl::fromPercentEncoding(chapterPath.toUtf8()));
+        chapter.entry = archive.findEntry(chapter.name);
+        if (chapter.entry >= 0)
+            documents.append(chapter);
+    }
+
+    if (documents.isEmpty()) {
+        setErrorString("The EPUB has no chapters to read.");
+        return false;
+    }
+
+    return true;
+}
+
+void ImportedText::openDocument(int index, qint64 pos) {
+    document = index;
+    sourcePos = pos;
+    entryReader.close();
+
+    if (index < documents.size() && documents[index].entry >= 0 &&
+        entryReader.open(archive, documents[index].entry))
+        entryReader.skip(pos);
+}
+
+// Strips the next piece of the book onto the end of the text kept, and lets
+// go of what is far enough behind where the text is wanted from. Returns
+// false once the whole book has been read.
+bool ImportedText::produce(qint64 keepFrom, int chunkSize, bool isIndexing) {
+    if (document >= documents.size())
+        return false;
+
+    const qint64 textEnd = windowStart + window.size();
+    if (isIndexing &&
+        textEnd >= checkpoints.last().textPos + checkpointInterval) {
+        Checkpoint checkpoint;
+        checkpoint.textPos = textEnd;
+        checkpoint.document = document;
+        checkpoint.sourcePos = sourcePos;
+        checkpoint.stripper = stripper;
+        checkpoints.append(checkpoint);
+    }
+
+    QByteArray source;
+    if (documents[document].entry >= 0)
+        source = entryReader.read(chunkSize);
+    else if (sourceFile.seek(sourcePos))
+        source = sourceFile.read(chunkSize);
+
+    if (source.isEmpty()) {
+        stripper.endDocument(window);
+        openDocument(document + 1, 0);
+    } else {
+        stripper.strip(source.constData(), source.size(), window);
+        sourcePos += source.size();
+    }
+
+    if (window.size() > 2 * windowSize) {
+        const qint64 keepStart =
+            qMin(keepFrom, windowStart + window.size()) - windowSize;
+        if (keepStart > windowStart) {
+            window.remove(0, static_cast<int>(keepStart - windowStart));
+            windowStart = keepStart;
+        }
+    }
+
+    return true;
+}
+
+// Starts making the text again from the last place noted at or before the
+// one given.
+void ImportedText::restart(qint64 textPos) {
+    auto checkpoint = std::upper_bound(
+        checkpoints.constBegin(), checkpoints.constEnd(), textPos,
+        [](qint64 pos, const Checkpoint &checkpoint) {
+            return pos < checkpoint.textPos;
+        });
+    if (checkpoint != checkpoints.constBegin())
+        checkpoint--;
+
+    openDocument(checkpoint->document, checkpoint->sourcePos);
+    stripper = checkpoint->stripper;
+    window.clear();
+    windowStart = checkpoint->textPos;
+}
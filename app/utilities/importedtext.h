@@ -0,0 +1,87 @@
+#ifndef IMPORTEDTEXT_H
+#define IMPORTEDTEXT_H
+
+#include "markupstripper.h"
+#include "ziparchive.h"
+
+#include <QFile>
+#include <QIODevice>
+#include <QString>
+#include <QVector>
+
+// Reads an EPUB, HTML or Markdown book as the plain UTF-8 text of its
+// chapters, so it can be counted and narrated like a text file without
+// being converted first. The text is made from the book as it is read:
+// EPUB chapters are inflated straight out of the archive and their markup
+// stripped on the way, and only the text around where it is being read is
+// kept.
+//
+// Opening a book makes the text once to learn its size, and notes where in
+// the book the text stood every so often. Seeking back further than the
+// text that is kept starts again from the nearest of those places, which is
+// also how a place in the text is traced back to a place in the book.
+class ImportedText : public QIODevice {
+public:
+    struct SourcePosition {
+        QString document;
+        qint64 offset = -1;
+    };
+
+    static const int checkpointInterval = 16 * 1024;
+    static const int windowSize = 64 * 1024;
+    static const int sourceChunkSize = 4 * 1024;
+    static const qint64 maxMetadataSize = 4 * 1024 * 1024;
+
+    ImportedText();
+    ~ImportedText() override;
+
+    bool openText(const QString &);
+    void close() override;
+    qint64 size() const override;
+    bool seek(qint64) override;
+
+    QStringList getDocuments() const;
+    SourcePosition getSourcePosition(qint64);
+
+    static bool isImported(const QString &);
+    static QIODevice *openTextDevice(const QString &, QFile &, ImportedText &);
+
+protected:
+    qint64 readData(char *, qint64) override;
+    qint64 writeData(const char *, qint64) override;
+
+private:
+    struct Document {
+        QString name;
+        int entry = -1;
+    };
+
+    struct Checkpoint {
+        qint64 textPos = 0;
+        int document = 0;
+        qint64 sourcePos = 0;
+        MarkupStripper stripper;
+    };
+
+    QFile sourceFile;
+    ZipArchive archive;
+    ZipEntryReader entryReader;
+    MarkupStripper::Format format = MarkupStripper::Html;
+    QVector<Document> documents;
+    QVector<Checkpoint> checkpoints;
+    qint64 textSize = 0;
+    qint64 readPos = 0;
+
+    int document = 0;
+    qint64 sourcePos = 0;
+    MarkupStripper stripper;
+    QByteArray window;
+    qint64 windowStart = 0;
+
+    bool findEpubDocuments();
+    void openDocument(int, qint64);
+    bool produce(qint64, int, bool);
+    void restart(qint64);
+};
+
+#endif // IMPORTEDTEXT_H
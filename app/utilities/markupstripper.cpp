@@ -0,0 +1,466 @@
+#include "markupstripper.h"
+
+#include <QString>
+#include <cctype>
+#include <cstring>
+
+static const char *const blockTags[] = {
+    "address", "article", "aside",    "blockquote", "body",  "dd",
+    "div",     "dl",      "dt",       "figcaption", "figure", "footer",
+    "header",  "hr",      "html",     "li",         "main",  "nav",
+    "ol",      "p",       "pre",      "section",    "table", "title",
+    "tr",      "ul"};
+
+static const struct {
+    const char *name;
+    uint codePoint;
+} namedEntities[] = {
+    {"amp", '&'},        {"lt", '<'},         {"gt", '>'},
+    {"quot", '"'},       {"apos", '\''},      {"nbsp", 0xa0},
+    {"shy", 0xad},       {"ndash", 0x2013},   {"mdash", 0x2014},
+    {"lsquo", 0x2018},   {"rsquo", 0x2019},   {"ldquo", 0x201c},
+    {"rdquo", 0x201d},   {"hellip", 0x2026}};
+
+static bool isHtmlSpace(char letter) {
+    return letter == ' ' || letter == '\t' || letter == '\r' ||
+           letter == '\n' || letter == '\f';
+}
+
+// Bytes of longer UTF-8 letters count as part of a word.
+static bool isWordChar(char letter) {
+    const uchar byte = static_cast<uchar>(letter);
+    return byte >= 0x80 || std::isalnum(byte);
+}
+
+static bool isBlockTag(const QByteArray &name) {
+    for (const char *blockTag : blockTags) {
+        if (name == blockTag)
+            return true;
+    }
+
+    return name.size() == 2 && name[0] == 'h' && name[1] >= '1' &&
+           name[1] <= '6';
+}
+
+// Three or more of the same mark, such as "* * *" or "---", alone on a line.
+static bool isRule(const QByteArray &marker) {
+    int numMarks = 0;
+    for (char letter : marker) {
+        if (letter == ' ' || letter == '\t')
+            continue;
+        if (letter != marker[0])
+            return false;
+        numMarks++;
+    }
+
+    return numMarks >= 3 && std::strchr("-*_=", marker[0]) != nullptr;
+}
+
+// Only the entities books tend to use are known. The rest are left as they
+// were written.
+static bool decodeEntity(const QByteArray &name, QByteArray &decoded) {
+    uint codePoint = 0;
+    bool isNumber = true;
+    if (name.startsWith("#x") || name.startsWith("#X"))
+        codePoint = name.mid(2).toUInt(&isNumber, 16);
+    else if (name.startsWith('#'))
+        codePoint = name.mid(1).toUInt(&isNumber, 10);
+    else
+        for (const auto &namedEntity : namedEntities) {
+            if (name == namedEntity.name)
+                codePoint = namedEntity.codePoint;
+        }
+
+    if (!isNumber || codePoint == 0 || codePoint > 0x10ffff ||
+        (codePoint >= 0xd800 && codePoint <= 0xdfff))
+        return false;
+
+    // Soft hyphens only mark where a word may be broken.
+    if (codePoint == 0xad) {
+        decoded.clear();
+        return true;
+    }
+
+    decoded = QString::fromUcs4(&codePoint, 1).toUtf8();
+    return true;
+}
+
+MarkupStripper::MarkupStripper(Format format)
+    : format(format), mode(format == Markdown ? LinePrefix : Text) {}
+
+void MarkupStripper::strip(const char *data, int size, QByteArray &text) {
+    for (int i = 0; i < size; i++)
+        stripChar(data[i], text);
+}
+
+// Whatever the document left open is closed, and the next one starts on a
+// new paragraph.
+void MarkupStripper::endDocument(QByteArray &text) {
+    if (mode == LinePrefix && !linePrefix.isEmpty())
+        endLinePrefix('\n', text);
+    if (isBangPending)
+        put('!', text);
+
+    mode = format == Markdown ? LinePrefix : Text;
+    tag.clear();
+    tagQuote = 0;
+    lastTagChar = 0;
+    numCommentDashes = 0;
+    skippedTag.clear();
+    entity.clear();
+    linePrefix.clear();
+    isInFence = false;
+    isEscaped = false;
+    isBangPending = false;
+    isAfterBracket = false;
+    numUnderscores = 0;
+    isSpacePending = false;
+    breakLine(2);
+}
+
+void MarkupStripper::stripChar(char letter, QByteArray &text) {
+    switch (mode) {
+    case Text:
+        if (format == Html)
+            stripText(letter, text);
+        else
+            stripInline(letter, text);
+        break;
+    case MaybeTag:
+        if (std::isalpha(static_cast<uchar>(letter)) || letter == '/' ||
+            letter == '!' || letter == '?') {
+            mode = Tag;
+            tag = QByteArray(1, letter);
+            tagQuote = 0;
+            lastTagChar = letter;
+        } else {
+            mode = Text;
+            if (skippedTag.isEmpty())
+                put('<', text);
+            stripChar(letter, text);
+        }
+        break;
+    case Tag:
+        stripTag(letter, text);
+        break;
+    case Comment:
+        if (letter == '>' && numCommentDashes >= 2)
+            mode = Text;
+        numCommentDashes = letter == '-' ? numCommentDashes + 1 : 0;
+        break;
+    case Entity:
+        stripEntity(letter, text);
+        break;
+    case LinePrefix:
+        if (letter != '\n' && letter != '\0' &&
+            linePrefix.size() < maxLinePrefixSize &&
+            std::strchr(" \t\r#>-*+_=`~.)0123456789", letter) != nullptr) {
+            linePrefix.append(letter);
+            break;
+        }
+
+        endLinePrefix(letter, text);
+        break;
+    case CodeLine:
+        if (letter == '\r')
+            break;
+        put(letter, text);
+        if (letter == '\n')
+            mode = LinePrefix;
+        break;
+    case SkipLine:
+        if (letter == '\n')
+            mode = LinePrefix;
+        break;
+    case LinkTarget:
+        if (letter == ')') {
+            mode = Text;
+        } else if (letter == '\n') {
+            mode = Text;
+            stripChar(letter, text);
+        }
+        break;
+    }
+}
+
+// HTML's text, where any run of spaces and line breaks is one space.
+void MarkupStripper::stripText(char letter, QByteArray &text) {
+    if (letter == '<') {
+        mode = MaybeTag;
+        return;
+    }
+
+    if (!skippedTag.isEmpty())
+        return;
+
+    if (letter == '&') {
+        mode = Entity;
+        entity.clear();
+    } else if (isHtmlSpace(letter)) {
+        isSpacePending = hasText;
+    } else {
+        put(letter, text);
+    }
+}
+
+// Markdown's text after the markers at the start of its line. Whether some
+// marks are markup depends on what follows them, so those wait for the next
+// letter.
+void MarkupStripper::stripInline(char letter, QByteArray &text) {
+    if (letter == '\r')
+        return;
+
+    if (isEscaped) {
+        isEscaped = false;
+        if (std::ispunct(static_cast<uchar>(letter))) {
+            put(letter, text);
+            return;
+        }
+        put('\\', text);
+    }
+
+    if (isBangPending) {
+        isBangPending = false;
+        if (letter != '[')
+            put('!', text);
+    }
+
+    if (isAfterBracket) {
+        isAfterBracket = false;
+        if (letter == '(') {
+            mode = LinkTarget;
+            return;
+        }
+    }
+
+    if (numUnderscores > 0 && letter != '_') {
+        if (isWordChar(lastChar) && isWordChar(letter))
+            for (int i = 0; i < numUnderscores; i++)
+                put('_', text);
+        numUnderscores = 0;
+    }
+
+    switch (letter) {
+    case '\\':
+        isEscaped = true;
+        break;
+    case '*':
+    case '`':
+    case '[':
+        break;
+    case '_':
+        numUnderscores++;
+        break;
+    case '!':
+        isBangPending = true;
+        break;
+    case ']':
+        isAfterBracket = true;
+        break;
+    case '<':
+        mode = MaybeTag;
+        break;
+    case '&':
+        mode = Entity;
+        entity.clear();
+        break;
+    case '\n':
+        put('\n', text);
+        mode = LinePrefix;
+        break;
+    default:
+        put(letter, text);
+    }
+}
+
+// Only the start of a tag is kept, which is all its name needs.
+void MarkupStripper::stripTag(char letter, QByteArray &) {
+    if (tagQuote != 0) {
+        if (letter == tagQuote)
+            tagQuote = 0;
+        return;
+    }
+
+    if (letter == '"' || letter == '\'') {
+        tagQuote = letter;
+        return;
+    }
+
+    if (letter == '>') {
+        mode = Text;
+        endTag();
+        return;
+    }
+
+    if (tag.size() < maxTagSize)
+        tag.append(letter);
+    if (!isHtmlSpace(letter))
+        lastTagChar = letter;
+    if (tag == "!--") {
+        mode = Comment;
+        numCommentDashes = 0;
+    }
+}
+
+void MarkupStripper::stripEntity(char letter, QByteArray &text) {
+    if (letter == ';') {
+        mode = Text;
+
+        QByteArray decoded;
+        if (decodeEntity(entity, decoded)) {
+            for (char decodedChar : decoded)
+                put(decodedChar, text);
+            return;
+        }
+
+        put('&', text);
+        for (char entityChar : entity)
+            put(entityChar, text);
+        put(';', text);
+        return;
+    }
+
+    if (entity.size() < maxEntitySize &&
+        (std::isalnum(static_cast<uchar>(letter)) ||
+         (letter == '#' && entity.isEmpty()))) {
+        entity.append(letter);
+        return;
+    }
+
+    mode = Text;
+    put('&', text);
+    for (char entityChar : entity)
+        put(entityChar, text);
+    stripChar(letter, text);
+}
+
+// Headings, paragraphs and the like start on a line of their own. What is
+// inside the document's head, scripts and styles is never read out.
+void MarkupStripper::endTag() {
+    const bool isClosing = tag.startsWith('/');
+    const bool isSelfClosing = lastTagChar == '/';
+
+    QByteArray name;
+    for (int i = isClosing ? 1 : 0;
+         i < tag.size() && std::isalnum(static_cast<uchar>(tag[i])); i++)
+        name.append(static_cast<char>(std::tolower(tag[i])));
+
+    if (name.isEmpty())
+        return;
+
+    if (!skippedTag.isEmpty()) {
+        if (isClosing && name == skippedTag)
+            skippedTag.clear();
+        return;
+    }
+
+    if (!isClosing && !isSelfClosing &&
+        (name == "head" || name == "script" || name == "style")) {
+        skippedTag = name;
+        return;
+    }
+
+    if (name == "br")
+        breakLine(1);
+    else if (isBlockTag(name))
+        breakLine(2);
+    else if (name == "td" || name == "th")
+        isSpacePending = hasText;
+}
+
+// Drops the markers that start a Markdown line, such as those of headings,
+// quotes and list items, along with code fences and rules.
+void MarkupStripper::endLinePrefix(char letter, QByteArray &text) {
+    const QByteArray prefix = linePrefix;
+    const QByteArray marker = prefix.trimmed();
+    linePrefix.clear();
+
+    if (marker.startsWith("```") || marker.startsWith("~~~")) {
+        isInFence = !isInFence;
+        mode = letter == '\n' ? LinePrefix : SkipLine;
+        return;
+    }
+
+    if (isInFence) {
+        mode = CodeLine;
+        for (char prefixChar : prefix)
+            stripChar(prefixChar, text);
+        stripChar(letter, text);
+        return;
+    }
+
+    if (letter == '\n' && (marker.isEmpty() || isRule(marker))) {
+        breakLine(2);
+        return;
+    }
+
+    int start = 0;
+    while (true) {
+        while (start < prefix.size() &&
+               (prefix[start] == ' ' || prefix[start] == '\t'))
+            start++;
+        if (start == prefix.size())
+            break;
+
+        int end = start;
+        if (prefix[end] == '>') {
+            start++;
+            continue;
+        }
+
+        if (prefix[end] == '#') {
+            while (end < prefix.size() && prefix[end] == '#')
+                end++;
+        } else if (std::strchr("-*+", prefix[end]) != nullptr) {
+            end++;
+        } else {
+            while (end < prefix.size() &&
+                   std::isdigit(static_cast<uchar>(prefix[end])))
+                end++;
+            if (end == start || end == prefix.size() ||
+                (prefix[end] != '.' && prefix[end] != ')'))
+                break;
+            end++;
+        }
+
+        // A marker is only one when a space follows it.
+        if (end == prefix.size() || (prefix[end] != ' ' && prefix[end] != '\t'))
+            break;
+        start = end;
+    }
+
+    mode = Text;
+    for (int i = start; i < prefix.size(); i++)
+        stripChar(prefix[i], text);
+    stripChar(letter, text);
+}
+
+// Adds a letter of text after the breaks or space waiting before it. Text
+// never starts with either.
+void MarkupStripper::put(char letter, QByteArray &text) {
+    if (!hasText && (letter == ' ' || letter == '\n'))
+        return;
+
+    if (hasText && numPendingBreaks > numTrailingNewlines) {
+        while (numTrailingNewlines < numPendingBreaks) {
+            text.append('\n');
+            numTrailingNewlines++;
+        }
+        lastChar = '\n';
+    } else if (isSpacePending && numTrailingNewlines == 0 &&
+               lastChar != ' ' && letter != ' ' && letter != '\n') {
+        text.append(' ');
+    }
+
+    numPendingBreaks = 0;
+    isSpacePending = false;
+
+    text.append(letter);
+    hasText = true;
+    lastChar = letter;
+    numTrailingNewlines = letter == '\n' ? numTrailingNewlines + 1 : 0;
+}
+
+void MarkupStripper::breakLine(int numNewlines) {
+    numPendingBreaks = qMax(numPendingBreaks, numNewlines);
+}
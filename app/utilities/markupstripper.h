@@ -0,0 +1,74 @@
+#ifndef MARKUPSTRIPPER_H
+#define MARKUPSTRIPPER_H
+
+#include <QByteArray>
+
+// Turns HTML or Markdown into the plain text a narrator reads, however few
+// bytes it is given at a time, so a book can be stripped as it is read or
+// inflated. It works on UTF-8 bytes: everything that marks text up is ASCII,
+// and ASCII never appears inside a longer letter, so letters pass through
+// untouched.
+//
+// Everything it remembers is small, so a copy of it is enough to pick the
+// stripping up again from the same place in the source.
+class MarkupStripper {
+public:
+    enum Format { Html, Markdown };
+
+    static const int maxTagSize = 64;
+    static const int maxEntitySize = 10;
+    static const int maxLinePrefixSize = 32;
+
+    explicit MarkupStripper(Format = Html);
+
+    void strip(const char *, int, QByteArray &);
+    void endDocument(QByteArray &);
+
+private:
+    enum Mode {
+        Text,
+        MaybeTag,
+        Tag,
+        Comment,
+        Entity,
+        LinePrefix,
+        CodeLine,
+        SkipLine,
+        LinkTarget
+    };
+
+    Format format;
+    Mode mode;
+
+    QByteArray tag;
+    char tagQuote = 0;
+    char lastTagChar = 0;
+    int numCommentDashes = 0;
+    QByteArray skippedTag;
+    QByteArray entity;
+
+    QByteArray linePrefix;
+    bool isInFence = false;
+    bool isEscaped = false;
+    bool isBangPending = false;
+    bool isAfterBracket = false;
+    int numUnderscores = 0;
+
+    bool hasText = false;
+    bool isSpacePending = false;
+    int numPendingBreaks = 0;
+    int numTrailingNewlines = 0;
+    char lastChar = 0;
+
+    void stripChar(char, QByteArray &);
+    void stripText(char, QByteArray &);
+    void stripInline(char, QByteArray &);
+    void stripTag(char, QByteArray &);
+    void stripEntity(char, QByteArray &);
+    void endTag();
+    void endLinePrefix(char, QByteArray &);
+    void put(char, QByteArray &);
+    void breakLine(int);
+};
+
+#endif // MARKUPSTRIPPER_H
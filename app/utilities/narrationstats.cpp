@@ -0,0 +1,68 @@
+#include "narrationstats.h"
+
+NarrationStats::NarrationStats() {}
+
+void NarrationStats::setWordCounts(const QVector<quint32> &wordCounts) {
+    this->wordCounts = wordCounts;
+
+    totalWords = 0;
+    for (quint32 wordCount : wordCounts)
+        totalWords += wordCount;
+}
+
+const QVector<quint32> &NarrationStats::getWordCounts() const {
+    return wordCounts;
+}
+
+void NarrationStats::recompute(const RecordedPartsTracker &recordedParts) {
+    recordedWords = 0;
+    timedWords = 0;
+    recordedMs = 0;
+
+    const auto &partInfos = recordedParts.getPartInfos();
+    for (auto info = partInfos.constBegin(); info != partInfos.constEnd();
+         ++info)
+        addPart(info.key(), info->durationMs);
+}
+
+// Only parts with a known duration count towards the narration pace.
+void NarrationStats::addPart(uint part, qint64 durationMs) {
+    quint32 wordCount = getWordCount(part);
+
+    recordedWords += wordCount;
+    if (durationMs > 0) {
+        timedWords += wordCount;
+        recordedMs += durationMs;
+    }
+}
+
+void NarrationStats::removePart(uint part, qint64 durationMs) {
+    quint32 wordCount = getWordCount(part);
+
+    recordedWords -= qMin<quint64>(recordedWords, wordCount);
+    if (durationMs > 0) {
+        timedWords -= qMin<quint64>(timedWords, wordCount);
+        recordedMs -= qMin(recordedMs, durationMs);
+    }
+}
+
+qint64 NarrationStats::getRecordedMs() const { return recordedMs; }
+
+int NarrationStats::getWordsPerMinute() const {
+    if (recordedMs <= 0)
+        return 0;
+
+    return static_cast<int>(timedWords * 60000 / recordedMs);
+}
+
+qint64 NarrationStats::getRemainingMs() const {
+    if (timedWords == 0 || totalWords <= recordedWords)
+        return 0;
+
+    return static_cast<qint64>((totalWords - recordedWords) *
+                               static_cast<quint64>(recordedMs) / timedWords);
+}
+
+quint32 NarrationStats::getWordCount(uint part) const {
+    return part < static_cast<uint>(wordCounts.size()) ? wordCounts[part] : 0;
+}
@@ -0,0 +1,34 @@
+#ifndef NARRATIONSTATS_H
+#define NARRATIONSTATS_H
+
+#include "recordedpartstracker.h"
+#include <QVector>
+
+// Running totals of how much has been narrated, how fast, and how much
+// studio time the rest of the text should take at that pace.
+class NarrationStats {
+public:
+    NarrationStats();
+
+    void setWordCounts(const QVector<quint32> &);
+    const QVector<quint32> &getWordCounts() const;
+
+    void recompute(const RecordedPartsTracker &);
+    void addPart(uint, qint64);
+    void removePart(uint, qint64);
+
+    qint64 getRecordedMs() const;
+    int getWordsPerMinute() const;
+    qint64 getRemainingMs() const;
+
+private:
+    QVector<quint32> wordCounts;
+    quint64 totalWords = 0;
+    quint64 recordedWords = 0;
+    quint64 timedWords = 0;
+    qint64 recordedMs = 0;
+
+    quint32 getWordCount(uint) const;
+};
+
+#endif // NARRATIONSTATS_H
@@ -0,0 +1,322 @@
+#include "noisereducer.h"
+
+#include <algorithm>
+#include <cmath>
+
+static const int frameSize = NoiseReducer::frameSize;
+static const int numBins = NoiseReducer::numBins;
+
+// How much more than the profile is taken out, and how far any bin may be
+// turned down, which keeps what is left of the room from warbling.
+static const float oversubtraction = 2.0f;
+static const float spectralFloor = 0.1f;
+
+// The pauses are what is at least this much quieter than the voice.
+static const int minLevelGap = 10;
+
+struct FftTables {
+    QVector<int> bitReversed;
+    QVector<float> cosines;
+    QVector<float> sines;
+    QVector<float> window;
+};
+
+// A periodic Hann window, which adds up to one when frames overlap by half.
+static const FftTables &getTables() {
+    static const FftTables tables = []() {
+        const double pi = std::acos(-1.0);
+        FftTables newTables;
+        newTables.bitReversed.resize(frameSize);
+        newTables.window.resize(frameSize);
+        for (int i = 0; i < frameSize; i++) {
+            int reversed = 0;
+            for (int bit = 1, mirror = frameSize / 2; bit < frameSize;
+                 bit *= 2, mirror /= 2) {
+                if (i & bit)
+                    reversed |= mirror;
+            }
+            newTables.bitReversed[i] = reversed;
+            newTables.window[i] = static_cast<float>(
+                0.5 - 0.5 * std::cos(2 * pi * i / frameSize));
+        }
+
+        for (int i = 0; i < frameSize / 2; i++) {
+            newTables.cosines.append(
+                static_cast<float>(std::cos(2 * pi * i / frameSize)));
+            newTables.sines.append(
+                static_cast<float>(std::sin(2 * pi * i / frameSize)));
+        }
+
+        return newTables;
+    }();
+
+    return tables;
+}
+
+// An in-place radix-2 transform of one frame. The inverse is scaled, so a
+// frame comes back as it went in.
+static void transform(float *real, float *imaginary, bool isInverse) {
+    const FftTables &tables = getTables();
+    for (int i = 0; i < frameSize; i++) {
+        const int reversed = tables.bitReversed[i];
+        if (reversed > i) {
+            std::swap(real[i], real[reversed]);
+            std::swap(imaginary[i], imaginary[reversed]);
+        }
+    }
+
+    const float direction = isInverse ? 1.0f : -1.0f;
+    for (int size = 2; size <= frameSize; size *= 2) {
+        const int half = size / 2;
+        const int step = frameSize / size;
+        for (int start = 0; start < frameSize; start += size) {
+            for (int k = 0; k < half; k++) {
+                const float twiddleReal = tables.cosines[k * step];
+                const float twiddleImaginary =
+                    direction * tables.sines[k * step];
+                const int a = start + k;
+                const int b = a + half;
+
+                const float productReal = real[b] * twiddleReal -
+                                          imaginary[b] * twiddleImaginary;
+                const float productImaginary = real[b] * twiddleImaginary +
+                                               imaginary[b] * twiddleReal;
+                real[b] = real[a] - productReal;
+                imaginary[b] = imaginary[a] - productImaginary;
+                real[a] += productReal;
+                imaginary[a] += productImaginary;
+            }
+        }
+    }
+
+    if (isInverse) {
+        for (int i = 0; i < frameSize; i++) {
+            real[i] /= frameSize;
+            imaginary[i] /= frameSize;
+        }
+    }
+}
+
+// Windows a frame and transforms it, as profiling and reducing both do, so
+// their magnitudes compare.
+static void analyze(const float *samples, float *real, float *imaginary) {
+    const float *window = getTables().window.constData();
+    for (int i = 0; i < frameSize; i++) {
+        real[i] = samples[i] * window[i];
+        imaginary[i] = 0.0f;
+    }
+
+    transform(real, imaginary, false);
+}
+
+// Profiles are weighed by how many frames of pauses they were made from.
+// Only those of the first valid profile's sample rate can be combined.
+NoiseProfile NoiseProfile::combine(const QVector<NoiseProfile> &profiles) {
+    NoiseProfile combined;
+    QVector<double> sums(numBins, 0.0);
+    for (const NoiseProfile &profile : profiles) {
+        if (!profile.isValid() ||
+            (combined.isValid() && profile.sampleRate != combined.sampleRate))
+            continue;
+
+        combined.sampleRate = profile.sampleRate;
+        combined.numFrames += profile.numFrames;
+        for (int bin = 0; bin < numBins; bin++)
+            sums[bin] += static_cast<double>(profile.magnitudes[bin]) *
+                         profile.numFrames;
+    }
+
+    if (!combined.isValid())
+        return combined;
+
+    combined.magnitudes.resize(numBins);
+    for (int bin = 0; bin < numBins; bin++)
+        combined.magnitudes[bin] =
+            static_cast<float>(sums[bin] / combined.numFrames);
+
+    return combined;
+}
+
+NoiseProfiler::NoiseProfiler(int sampleRate, int channelCount)
+    : sampleRate(sampleRate), channelCount(qMax(1, channelCount)),
+      frames(this->channelCount, QVector<float>(frameSize)),
+      levelMagnitudes(numLevels * numBins, 0.0), levelCounts(numLevels, 0) {}
+
+// Takes interleaved samples, whole frames of every channel at a time.
+void NoiseProfiler::add(const float *samples, int numSamples) {
+    for (int sample = 0; sample + channelCount <= numSamples;
+         sample += channelCount) {
+        for (int channel = 0; channel < channelCount; channel++)
+            frames[channel][frameFill] = samples[sample + channel];
+
+        if (++frameFill < frameSize)
+            continue;
+
+        for (const QVector<float> &frame : frames)
+            addFrame(frame);
+        frameFill = 0;
+    }
+}
+
+// The quietest and loudest tenth stand in for the room and the voice, as
+// they do when splitting recordings. A take with no pauses, or one that is
+// all room, has no profile.
+NoiseProfile NoiseProfiler::getProfile() const {
+    NoiseProfile profile;
+    qint64 numFrames = 0;
+    for (qint64 count : levelCounts)
+        numFrames += count;
+    if (numFrames == 0)
+        return profile;
+
+    auto getLevelAt = [this, numFrames](double fraction) {
+        qint64 numBelow = 0;
+        for (int level = 0; level < numLevels; level++) {
+            numBelow += levelCounts[level];
+            if (numBelow > fraction * (numFrames - 1))
+                return level;
+        }
+        return numLevels - 1;
+    };
+    const int noiseFloor = getLevelAt(0.1);
+    const int speechLevel = getLevelAt(0.9);
+    const int gap = speechLevel - noiseFloor;
+    if (gap < minLevelGap)
+        return profile;
+
+    const int threshold = noiseFloor + qMax(6, static_cast<int>(gap * 0.3));
+    QVector<double> sums(numBins, 0.0);
+    qint64 numQuiet = 0;
+    for (int level = 0; level < threshold; level++) {
+        numQuiet += levelCounts[level];
+        for (int bin = 0; bin < numBins; bin++)
+            sums[bin] += levelMagnitudes[level * numBins + bin];
+    }
+
+    if (numQuiet < minNoiseFrames)
+        return profile;
+
+    profile.sampleRate = sampleRate;
+    profile.numFrames = static_cast<int>(numQuiet);
+    profile.magnitudes.resize(numBins);
+    for (int bin = 0; bin < numBins; bin++)
+        profile.magnitudes[bin] = static_cast<float>(sums[bin] / numQuiet);
+
+    return profile;
+}
+
+// Frames are sorted by their level in whole decibels below full scale.
+void NoiseProfiler::addFrame(const QVector<float> &frame) {
+    double energy = 0.0;
+    for (float sample : frame)
+        energy += static_cast<double>(sample) * sample;
+
+    const double levelDb = 10.0 * std::log10(energy / frameSize + 1e-10);
+    const int level = qBound(0, static_cast<int>(levelDb) + numLevels,
+                             numLevels - 1);
+
+    float real[frameSize];
+    float imaginary[frameSize];
+    analyze(frame.constData(), real, imaginary);
+
+    double *sums = levelMagnitudes.data() + level * numBins;
+    for (int bin = 0; bin < numBins; bin++)
+        sums[bin] += std::sqrt(real[bin] * real[bin] +
+                               imaginary[bin] * imaginary[bin]);
+    levelCounts[level]++;
+}
+
+// Without a valid profile nothing is taken out, and the samples pass
+// through unchanged.
+NoiseReducer::NoiseReducer(const NoiseProfile &profile, int channelCount)
+    : noise(profile.isValid() ? profile.magnitudes
+                              : QVector<float>(numBins, 0.0f)),
+      channelCount(qMax(1, channelCount)),
+      inputs(this->channelCount, QVector<float>(frameSize, 0.0f)),
+      overlaps(this->channelCount, QVector<float>(frameSize, 0.0f)),
+      real(frameSize), imaginary(frameSize), gains(numBins) {
+    // The first frame starts half a frame before the first sample, so that
+    // every sample is covered by two frames.
+    inputFill = frameSize - hopSize;
+    numToSkip = frameSize - hopSize;
+}
+
+// Appends as many cleaned samples as are ready to the output.
+void NoiseReducer::process(const float *samples, int numSamples,
+                           QVector<float> &output) {
+    for (int sample = 0; sample + channelCount <= numSamples;
+         sample += channelCount) {
+        for (int channel = 0; channel < channelCount; channel++)
+            inputs[channel][inputFill] = samples[sample + channel];
+        inputFill++;
+        numIn++;
+
+        if (inputFill == frameSize)
+            processFrame(output);
+    }
+}
+
+// Runs silence through until every sample that went in has come out.
+void NoiseReducer::finish(QVector<float> &output) {
+    while (numOut < numIn) {
+        for (QVector<float> &input : inputs)
+            std::fill(input.begin() + inputFill, input.end(), 0.0f);
+        inputFill = frameSize;
+        processFrame(output);
+    }
+}
+
+void NoiseReducer::processFrame(QVector<float> &output) {
+    for (int channel = 0; channel < channelCount; channel++) {
+        float *re = real.data();
+        float *im = imaginary.data();
+        analyze(inputs[channel].constData(), re, im);
+
+        for (int bin = 0; bin < numBins; bin++) {
+            const float magnitude =
+                std::sqrt(re[bin] * re[bin] + im[bin] * im[bin]);
+            gains[bin] = std::max(
+                1.0f - oversubtraction * noise[bin] / (magnitude + 1e-12f),
+                spectralFloor);
+        }
+
+        // The upper half mirrors the lower one for real samples.
+        for (int bin = 0; bin < numBins; bin++) {
+            re[bin] *= gains[bin];
+            im[bin] *= gains[bin];
+        }
+        for (int bin = numBins; bin < frameSize; bin++) {
+            re[bin] *= gains[frameSize - bin];
+            im[bin] *= gains[frameSize - bin];
+        }
+
+        transform(re, im, true);
+
+        float *overlap = overlaps[channel].data();
+        for (int i = 0; i < frameSize; i++)
+            overlap[i] += re[i];
+    }
+
+    for (int i = 0; i < hopSize; i++) {
+        if (numToSkip > 0) {
+            numToSkip--;
+            continue;
+        }
+        if (numOut == numIn)
+            break;
+
+        for (int channel = 0; channel < channelCount; channel++)
+            output.append(overlaps[channel][i]);
+        numOut++;
+    }
+
+    for (int channel = 0; channel < channelCount; channel++) {
+        QVector<float> &overlap = overlaps[channel];
+        std::copy(overlap.begin() + hopSize, overlap.end(), overlap.begin());
+        std::fill(overlap.end() - hopSize, overlap.end(), 0.0f);
+
+        QVector<float> &input = inputs[channel];
+        std::copy(input.begin() + hopSize, input.end(), input.begin());
+    }
+    inputFill = frameSize - hopSize;
+}
@@ -0,0 +1,74 @@
+#ifndef NOISEREDUCER_H
+#define NOISEREDUCER_H
+
+#include <QVector>
+
+// The average spectrum of a take's room tone, from the frames quiet enough
+// to be pauses between sentences.
+struct NoiseProfile {
+    int sampleRate = 0;
+    int numFrames = 0;
+    QVector<float> magnitudes;
+
+    bool isValid() const { return numFrames > 0; }
+
+    static NoiseProfile combine(const QVector<NoiseProfile> &);
+};
+
+// Builds a noise profile from samples streamed through it. Each frame's
+// spectrum is summed with the others of about the same loudness, so the
+// pauses can be told apart once the whole take has been seen, without
+// keeping it.
+class NoiseProfiler {
+public:
+    static const int numLevels = 100;
+    static const int minNoiseFrames = 8;
+
+    NoiseProfiler(int, int);
+
+    void add(const float *, int);
+    NoiseProfile getProfile() const;
+
+private:
+    int sampleRate = 0;
+    int channelCount = 0;
+    QVector<QVector<float>> frames;
+    int frameFill = 0;
+
+    QVector<double> levelMagnitudes;
+    QVector<qint64> levelCounts;
+
+    void addFrame(const QVector<float> &);
+};
+
+// Takes the noise in a profile out of interleaved samples streamed through
+// it by spectral subtraction. Frames overlap by half, so the samples come
+// back out a little later than they go in; finish() gives the rest.
+class NoiseReducer {
+public:
+    static const int frameSize = 1024;
+    static const int hopSize = frameSize / 2;
+    static const int numBins = frameSize / 2 + 1;
+
+    NoiseReducer(const NoiseProfile &, int);
+
+    void process(const float *, int, QVector<float> &);
+    void finish(QVector<float> &);
+
+private:
+    QVector<float> noise;
+    int channelCount = 0;
+    QVector<QVector<float>> inputs;
+    QVector<QVector<float>> overlaps;
+    int inputFill = 0;
+    int numToSkip = 0;
+    qint64 numIn = 0;
+    qint64 numOut = 0;
+    QVector<float> real;
+    QVector<float> imaginary;
+    QVector<float> gains;
+
+    void processFrame(QVector<float> &);
+};
+
+#endif // NOISEREDUCER_H
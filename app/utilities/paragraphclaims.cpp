@@ -0,0 +1,268 @@
+#include "paragraphclaims.h"
+
+#include <QDateTime>
+#include <QVector>
+#include <atomic>
+
+static_assert(ATOMIC_INT_LOCK_FREE == 2 && ATOMIC_LLONG_LOCK_FREE == 2,
+              "Claims are shared between processes, which only works for "
+              "atomics that take no lock.");
+
+static const quint32 claimsMagic = 0x4e44434c; // "NDCL"
+static const quint32 claimsVersion = 1;
+
+// Header: magic, version, the next session token, reserved.
+static const qint64 headerSize = 16;
+// Session: when it last beat in milliseconds since the epoch (0 when free),
+// its token, reserved.
+static const qint64 sessionSize = 16;
+// Paragraph: the token of the session that claimed it (0 when unclaimed).
+static const qint64 ownerSize = 4;
+
+static const qint64 sessionsOffset = headerSize;
+static const qint64 ownersOffset =
+    sessionsOffset + ParagraphClaims::maxSessions * sessionSize;
+
+template <typename T>
+static std::atomic<T> &getAtomic(uchar *claimsMap, qint64 offset) {
+    return *reinterpret_cast<std::atomic<T> *>(claimsMap + offset);
+}
+
+static std::atomic<qint64> &getHeartbeat(uchar *claimsMap, int session) {
+    return getAtomic<qint64>(claimsMap, sessionsOffset + session * sessionSize);
+}
+
+static std::atomic<quint32> &getToken(uchar *claimsMap, int session) {
+    return getAtomic<quint32>(claimsMap,
+                              sessionsOffset + session * sessionSize + 8);
+}
+
+static std::atomic<quint32> &getOwner(uchar *claimsMap, uint prg) {
+    return getAtomic<quint32>(claimsMap, ownersOffset + prg * ownerSize);
+}
+
+static qint64 now() { return QDateTime::currentMSecsSinceEpoch(); }
+
+ParagraphClaims::ParagraphClaims(qint64 staleAfterMs)
+    : staleAfterMs(staleAfterMs) {}
+
+ParagraphClaims::~ParagraphClaims() { close(); }
+
+// Opens the claims of a text with the given number of paragraphs, making
+// the file when it is the first session, and joins them as a new session.
+bool ParagraphClaims::open(const QString &claimsPath, uint prgNumTotal) {
+    close();
+
+    claimsFile.setFileName(claimsPath);
+    if (!claimsFile.open(QIODevice::ReadWrite))
+        return false;
+
+    // Only ever grown, since other sessions may have mapped all of it.
+    const qint64 claimsSize = ownersOffset + prgNumTotal * ownerSize;
+    if (claimsFile.size() < claimsSize && !claimsFile.resize(claimsSize)) {
+        close();
+        return false;
+    }
+
+    claimsMap = claimsFile.map(0, claimsSize);
+    if (claimsMap == nullptr) {
+        close();
+        return false;
+    }
+
+    // The first session to get here marks the file as claims.
+    quint32 magic = 0;
+    quint32 version = 0;
+    getAtomic<quint32>(claimsMap, 0).compare_exchange_strong(magic,
+                                                             claimsMagic);
+    getAtomic<quint32>(claimsMap, 4).compare_exchange_strong(version,
+                                                             claimsVersion);
+    if ((magic != 0 && magic != claimsMagic) ||
+        (version != 0 && version != claimsVersion)) {
+        close();
+        return false;
+    }
+
+    numPrgs = prgNumTotal;
+    do {
+        token = getAtomic<quint32>(claimsMap, 8).fetch_add(1) + 1;
+    } while (token == 0);
+
+    if (!joinSession()) {
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+// Gives up every claim of the session, which others may then take at once.
+void ParagraphClaims::close() {
+    if (claimsMap != nullptr) {
+        release(0, numPrgs);
+        leaveSession();
+        claimsFile.unmap(claimsMap);
+    }
+
+    claimsMap = nullptr;
+    numPrgs = 0;
+    token = 0;
+    session = -1;
+
+    if (claimsFile.isOpen())
+        claimsFile.close();
+}
+
+bool ParagraphClaims::isOpen() const { return claimsMap != nullptr; }
+
+// Has to be called more often than the stale time. A session that was
+// taken for stale anyway, such as after the computer slept, joins again,
+// and keeps whatever of its claims were not taken over in the meantime.
+// It may beat on a thread of its own while the claims are used on another,
+// but not while they are opened or closed.
+void ParagraphClaims::heartbeat() {
+    if (claimsMap == nullptr)
+        return;
+
+    if (getToken(claimsMap, session).load() == token) {
+        getHeartbeat(claimsMap, session).store(now());
+        return;
+    }
+
+    joinSession();
+}
+
+// Claims the paragraphs from the first one up to the end one, or none of
+// them when another live session holds any. Paragraphs the session already
+// holds stay claimed either way.
+bool ParagraphClaims::claim(uint firstPrg, uint endPrg) {
+    if (claimsMap == nullptr)
+        return false;
+
+    endPrg = qMin(endPrg, numPrgs);
+    QVector<uint> newlyClaimed;
+    for (uint prg = firstPrg; prg < endPrg; prg++) {
+        std::atomic<quint32> &owner = getOwner(claimsMap, prg);
+        quint32 currentOwner = owner.load();
+        if (currentOwner == token)
+            continue;
+
+        bool isClaimed = false;
+        while (!isClaimed && (currentOwner == 0 || !isLive(currentOwner)))
+            isClaimed = owner.compare_exchange_weak(currentOwner, token);
+
+        if (isClaimed) {
+            newlyClaimed.append(prg);
+            continue;
+        }
+
+        for (uint claimedPrg : newlyClaimed) {
+            quint32 claimedOwner = token;
+            getOwner(claimsMap, claimedPrg)
+                .compare_exchange_strong(claimedOwner, 0);
+        }
+        return false;
+    }
+
+    return true;
+}
+
+// Only gives up paragraphs the session holds.
+void ParagraphClaims::release(uint firstPrg, uint endPrg) {
+    if (claimsMap == nullptr)
+        return;
+
+    endPrg = qMin(endPrg, numPrgs);
+    for (uint prg = firstPrg; prg < endPrg; prg++) {
+        quint32 owner = token;
+        getOwner(claimsMap, prg).compare_exchange_strong(owner, 0);
+    }
+}
+
+bool ParagraphClaims::isClaimed(uint prg) const {
+    return claimsMap != nullptr && prg < numPrgs &&
+           getOwner(claimsMap, prg).load() == token;
+}
+
+bool ParagraphClaims::isClaimedByOther(uint prg) const {
+    if (claimsMap == nullptr || prg >= numPrgs)
+        return false;
+
+    const quint32 owner = getOwner(claimsMap, prg).load();
+    return owner != 0 && owner != token && isLive(owner);
+}
+
+uint ParagraphClaims::getNumClaimed() const {
+    uint numClaimed = 0;
+    for (uint prg = 0; prg < numPrgs; prg++) {
+        if (getOwner(claimsMap, prg).load() == token)
+            numClaimed++;
+    }
+
+    return numClaimed;
+}
+
+// Counts this one too.
+int ParagraphClaims::getNumSessions() const {
+    if (claimsMap == nullptr)
+        return 0;
+
+    int numSessions = 0;
+    for (int otherSession = 0; otherSession < maxSessions; otherSession++) {
+        if (!isStale(getHeartbeat(claimsMap, otherSession).load()))
+            numSessions++;
+    }
+
+    return numSessions;
+}
+
+// Tells this session apart from every other that ever joined, or is 0 when
+// the claims are not open.
+quint32 ParagraphClaims::getToken() const { return token; }
+
+QString ParagraphClaims::getClaimsPath(const QString &recordingPath) {
+    return recordingPath + "/claims";
+}
+
+// A free or stale place is won by whoever first moves its heartbeat on, so
+// two sessions joining at once never share one.
+bool ParagraphClaims::joinSession() {
+    for (int freeSession = 0; freeSession < maxSessions; freeSession++) {
+        std::atomic<qint64> &heartbeat = getHeartbeat(claimsMap, freeSession);
+        qint64 lastBeat = heartbeat.load();
+        if (!isStale(lastBeat) ||
+            !heartbeat.compare_exchange_strong(lastBeat, now()))
+            continue;
+
+        getToken(claimsMap, freeSession).store(token);
+        session = freeSession;
+        return true;
+    }
+
+    return false;
+}
+
+void ParagraphClaims::leaveSession() {
+    if (session == -1)
+        return;
+
+    // Another session may have taken the place over already.
+    quint32 sessionToken = token;
+    if (getToken(claimsMap, session).compare_exchange_strong(sessionToken, 0))
+        getHeartbeat(claimsMap, session).store(0);
+    session = -1;
+}
+
+// Whether a session with the token still beats.
+bool ParagraphClaims::isLive(quint32 sessionToken) const {
+    for (int otherSession = 0; otherSession < maxSessions; otherSession++) {
+        if (getToken(claimsMap, otherSession).load() == sessionToken)
+            return !isStale(getHeartbeat(claimsMap, otherSession).load());
+    }
+
+    return false;
+}
+
+bool ParagraphClaims::isStale(qint64 lastBeat) const {
+    return now() - lastBeat > staleAfterMs;
+}
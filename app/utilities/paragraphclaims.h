@@ -0,0 +1,57 @@
+#ifndef PARAGRAPHCLAIMS_H
+#define PARAGRAPHCLAIMS_H
+
+#include <QFile>
+#include <QString>
+
+// Lets several sessions narrate one project at once, each in its own window
+// or process, without two of them recording the same paragraph. Sessions
+// claim paragraphs in a claims file next to the parts, which every session
+// maps into memory and changes only by compare-and-swap, so claiming takes
+// no lock and a session that crashes holding one blocks no one else.
+//
+// Each session keeps a heartbeat in the file. The claims of a session whose
+// heartbeat has stopped for longer than the stale time may be taken over.
+// The file holds native atomics, so it is only shared on one machine.
+class ParagraphClaims {
+public:
+    static const int maxSessions = 64;
+    static const int heartbeatIntervalMs = 5 * 1000;
+    static const int defaultStaleAfterMs = 30 * 1000;
+
+    explicit ParagraphClaims(qint64 = defaultStaleAfterMs);
+    ~ParagraphClaims();
+
+    ParagraphClaims(const ParagraphClaims &) = delete;
+    ParagraphClaims &operator=(const ParagraphClaims &) = delete;
+
+    bool open(const QString &, uint);
+    void close();
+    bool isOpen() const;
+
+    void heartbeat();
+    bool claim(uint, uint);
+    void release(uint, uint);
+    bool isClaimed(uint) const;
+    bool isClaimedByOther(uint) const;
+    uint getNumClaimed() const;
+    int getNumSessions() const;
+    quint32 getToken() const;
+
+    static QString getClaimsPath(const QString &);
+
+private:
+    QFile claimsFile;
+    uchar *claimsMap = nullptr;
+    uint numPrgs = 0;
+    qint64 staleAfterMs = 0;
+    quint32 token = 0;
+    int session = -1;
+
+    bool joinSession();
+    void leaveSession();
+    bool isLive(quint32) const;
+    bool isStale(qint64) const;
+};
+
+#endif // PARAGRAPHCLAIMS_H
@@ -0,0 +1,73 @@
+#include "paragraphcounter.h"
+
+// Counts paragraphs the same way they are read, along with the number of
+// words that falls into each of them. Also finds chapter headings while
+// counting. Only the start of each line is kept, since anything longer than
+// a heading cannot be one.
+ParagraphCounter::Counts ParagraphCounter::countText(
+    QTextStream &input, const QVector<QRegularExpression> &headingPatterns) {
+    Counts counts;
+    uint numPrgs = 1;
+    uint numSents = 1;
+    bool seenEndOfSentence = false;
+    bool isInWord = false;
+
+    QString line;
+    uint linePrg = 0;
+    bool isLineTooLong = false;
+    const bool shouldFindChapters = !headingPatterns.isEmpty();
+
+    QVector<quint32> &wordCounts = counts.wordCounts;
+    wordCounts.fill(0, 1);
+    while (!input.atEnd()) {
+        QChar currentChar = input.read(1).front();
+
+        if (shouldFindChapters) {
+            if (currentChar == '\n') {
+                if (!isLineTooLong)
+                    ChapterList::addHeading(counts.chapters, line, linePrg,
+                                            headingPatterns);
+                line.clear();
+                isLineTooLong = false;
+                linePrg = numPrgs - 1;
+            } else if (line.size() < ChapterList::maxHeadingLength * 2) {
+                line.append(currentChar);
+            } else {
+                isLineTooLong = true;
+            }
+        }
+
+        if (currentChar.isSpace()) {
+            isInWord = false;
+        } else if (!isInWord) {
+            isInWord = true;
+            wordCounts[numPrgs - 1]++;
+        }
+
+        if (!isEndOfSentence(currentChar)) {
+            seenEndOfSentence = false;
+            continue;
+        }
+
+        if (isEndOfSentence(currentChar) && seenEndOfSentence) {
+            continue;
+        }
+
+        if (++numSents % 4 == 0) {
+            numPrgs++;
+            wordCounts.append(0);
+        }
+        seenEndOfSentence = true;
+    }
+
+    if (shouldFindChapters && !isLineTooLong)
+        ChapterList::addHeading(counts.chapters, line, linePrg,
+                                headingPatterns);
+
+    counts.numPrgs = numPrgs;
+    return counts;
+}
+
+bool ParagraphCounter::isEndOfSentence(const QChar &letter) {
+    return letter == "!" || letter == "?" || letter == ".";
+}
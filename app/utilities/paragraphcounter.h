@@ -0,0 +1,26 @@
+#ifndef PARAGRAPHCOUNTER_H
+#define PARAGRAPHCOUNTER_H
+
+#include "chapterlist.h"
+#include <QChar>
+#include <QRegularExpression>
+#include <QTextStream>
+#include <QVector>
+
+// Splits a text into paragraphs of four sentences the same way the narrator
+// reads it, without keeping any of the text around.
+class ParagraphCounter {
+public:
+    // What one pass over a text finds.
+    struct Counts {
+        uint numPrgs = 0;
+        QVector<quint32> wordCounts;
+        QVector<ChapterList::Chapter> chapters;
+    };
+
+    static Counts countText(QTextStream &,
+                            const QVector<QRegularExpression> &);
+    static bool isEndOfSentence(const QChar &);
+};
+
+#endif // PARAGRAPHCOUNTER_H
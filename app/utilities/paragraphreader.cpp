@@ -0,0 +1,56 @@
+#include "paragraphreader.h"
+#include "paragraphcounter.h"
+
+ParagraphReader::ParagraphReader(QTextStream &input) : input(input) {}
+
+// Leaves the location at the start of the paragraph after it.
+QString ParagraphReader::readParagraph(qint64 &location) {
+    QString paragraph = "";
+
+    for (int i = 0; i < 4; i++) {
+        QString sentence = readSentence(location);
+
+        if (sentence.isEmpty())
+            break;
+        paragraph += sentence;
+    }
+
+    return paragraph.trimmed();
+}
+
+QString ParagraphReader::readSentence(qint64 &location) {
+    QString sentence = "";
+
+    input.seek(location);
+    while (!input.atEnd()) {
+        QChar currentLetter = input.read(1).front();
+
+        sentence.append(currentLetter);
+
+        if (ParagraphCounter::isEndOfSentence(currentLetter)) {
+            appendUntilNextSentence(sentence);
+            break;
+        }
+    }
+    location = input.pos();
+
+    return sentence;
+}
+
+bool ParagraphReader::isEndOfQuote(const QChar &letter) {
+    return letter == "\"" || letter == "'" || letter == "”" || letter == "`";
+}
+
+void ParagraphReader::appendUntilNextSentence(QString &sentence) {
+    while (!input.atEnd()) {
+        QChar currentLetter = input.read(1).front();
+
+        if (isEndOfQuote(currentLetter) ||
+            !ParagraphCounter::isEndOfSentence(currentLetter)) {
+            sentence.append(currentLetter);
+            break;
+        }
+
+        sentence.append(currentLetter);
+    }
+}
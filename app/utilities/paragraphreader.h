@@ -0,0 +1,26 @@
+#ifndef PARAGRAPHREADER_H
+#define PARAGRAPHREADER_H
+
+#include <QChar>
+#include <QString>
+#include <QTextStream>
+
+// Reads paragraphs of four sentences straight from the text as the narrator
+// is shown them, starting wherever the paragraph's location points. Nothing
+// but the paragraph being read is kept in memory.
+class ParagraphReader {
+public:
+    explicit ParagraphReader(QTextStream &);
+
+    QString readParagraph(qint64 &);
+    QString readSentence(qint64 &);
+
+    static bool isEndOfQuote(const QChar &);
+
+private:
+    QTextStream &input;
+
+    void appendUntilNextSentence(QString &);
+};
+
+#endif // PARAGRAPHREADER_H
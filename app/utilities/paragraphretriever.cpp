@@ -1,11 +1,16 @@
 #include "paragraphretriever.h"
 
-ParagraphRetriever::ParagraphRetriever(QFile *textFile, uint sentenceLimit) {
+static QString readText(QIODevice *textFile) {
     QTextStream textStream(textFile);
+    textStream.setCodec("UTF-8");
 
-    ParagraphRetriever(textStream.readAll(), sentenceLimit);
+    return textStream.readAll();
 }
 
+ParagraphRetriever::ParagraphRetriever(QIODevice *textFile,
+                                       uint sentenceLimit)
+    : ParagraphRetriever(readText(textFile), sentenceLimit) {}
+
 ParagraphRetriever::ParagraphRetriever(const QString &text,
                                        uint sentenceLimit) {
     this->textFileContents = text;
@@ -68,6 +73,19 @@ uint ParagraphRetriever::getNumParagraphs() {
     return numPrgs;
 }
 
+// The whole text, the paragraphs read so far, and the byte of attributes the
+// boundary finder keeps for every character.
+qint64 ParagraphRetriever::getMemoryUsage() const {
+    qint64 bytes = textFileContents.capacity() * sizeof(QChar) +
+                   textFileContents.size() + 1;
+
+    bytes += knownParagraphs.capacity() * sizeof(std::pair<uint, QString>);
+    for (auto &paragraph : knownParagraphs)
+        bytes += paragraph.second.capacity() * sizeof(QChar);
+
+    return bytes;
+}
+
 void ParagraphRetriever::setPosition(uint position) {
     sentenceFinder.setPosition(position);
 }
@@ -8,12 +8,13 @@
 
 class ParagraphRetriever {
 public:
-    ParagraphRetriever(QFile *, uint);
+    ParagraphRetriever(QIODevice *, uint);
     ParagraphRetriever(const QString &, uint);
 
     QString getParagraph(int);
     QString getNextSentence();
     uint getNumParagraphs();
+    qint64 getMemoryUsage() const;
 
     void setPosition(uint);
 
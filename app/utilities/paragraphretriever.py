@@ -8,6 +8,26 @@ def print_paragraph_entry(sentences, prgnum):
     for sentence in paragraph:
         print(sentence)
 
+def utf16_length(text):
+    return len(text.encode('utf-16-le')) // 2
+
+# Where each sentence starts, in UTF-16 characters as Qt counts them, so the
+# sentences can be compared with those the program finds.
+def print_sentence_starts(full_text, sentences):
+    position = 0
+    utf16_position = 0
+
+    for sentence in sentences:
+        start = full_text.find(sentence, position)
+        if start == -1:
+            continue
+
+        utf16_position += utf16_length(full_text[position:start])
+        print(utf16_position)
+
+        utf16_position += utf16_length(sentence)
+        position = start + len(sentence)
+
 def wait_for_user_request(textfile):
     full_text = textfile.read()
     sentences = tokenize.sent_tokenize(full_text)
@@ -25,6 +45,8 @@ def wait_for_user_request(textfile):
             print_paragraph_entry(sentences, prgnum)
         elif command_name == "getnumprgs":
             print(ceil(len(sentences) / 4))
+        elif command_name == "getsentencestarts":
+            print_sentence_starts(full_text, sentences)
 
 def main():
     if len(sys.argv) != 2:
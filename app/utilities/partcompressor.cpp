@@ -0,0 +1,216 @@
+#include "partcompressor.h"
+
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QProcess>
+#include <QThread>
+#include <QtConcurrent>
+
+static const QString compressedExtension = ".flac";
+
+PartCompressor::PartCompressor(QObject *parent) : QObject(parent) {
+    compressionPool.setMaxThreadCount(1);
+}
+
+PartCompressor::~PartCompressor() { stop(); }
+
+void PartCompressor::compress(uint part, const QString &partPath) {
+    if (queuedParts.contains(part) || unifyFuture.isRunning())
+        return;
+    queuedParts.insert(part);
+
+    QtConcurrent::run(&compressionPool, [this, part, partPath]() {
+        QThread::currentThread()->setPriority(QThread::LowestPriority);
+        compressFile(partPath);
+
+        QMetaObject::invokeMethod(
+            this, [this, part]() { onCompressionFinished(part); },
+            Qt::QueuedConnection);
+    });
+}
+
+// Compresses the given parts after the one being compressed, if any, and
+// before any other. The future tells whether all of them were tried, which
+// they are not when the compressor was stopped first.
+QFuture<bool> PartCompressor::unify(const QStringList &partPaths) {
+    pause();
+
+    unifyFuture = QtConcurrent::run(&compressionPool, [this, partPaths]() {
+        QThread::currentThread()->setPriority(QThread::LowestPriority);
+        for (const QString &partPath : partPaths) {
+            if (isStopping)
+                return false;
+
+            compressFile(partPath);
+        }
+
+        return true;
+    });
+
+    return unifyFuture;
+}
+
+// Drops every part that has not started compressing yet. The one being
+// compressed finishes on its own, and is not swapped in if its original
+// changes before then. Parts being unified are kept, since an export waits
+// for them.
+void PartCompressor::pause() {
+    if (unifyFuture.isRunning())
+        return;
+
+    compressionPool.clear();
+    queuedParts.clear();
+}
+
+// Also waits for the part being compressed, if any, and gives up on the
+// parts being unified.
+void PartCompressor::stop() {
+    isStopping = true;
+    pause();
+    compressionPool.waitForDone();
+    isStopping = false;
+}
+
+// Parts that failed are tried again on the next call to compress().
+void PartCompressor::onCompressionFinished(uint part) {
+    queuedParts.remove(part);
+}
+
+// FLAC only stores integer samples, so only those parts can be compressed
+// without losing anything.
+bool PartCompressor::canCompress(const RecordedPartsTracker::PartInfo &info) {
+    return !info.fileName.isEmpty() && !isCompressed(info.fileName) &&
+           (info.codec == "pcm_s16le" || info.codec == "pcm_s24le");
+}
+
+bool PartCompressor::isCompressed(const QString &partPath) {
+    return partPath.endsWith(compressedExtension, Qt::CaseInsensitive);
+}
+
+// ffmpeg only joins parts that share a codec, so a book is either all
+// compressed or all left as recorded when it is exported.
+bool PartCompressor::hasMixedFormats(const RecordedPartsTracker &recordedParts,
+                                     uint numParts) {
+    bool hasCompressedParts = false;
+    bool hasUncompressedParts = false;
+
+    for (uint part = 0; part < numParts; part++) {
+        if (!recordedParts.isRecorded(part))
+            continue;
+
+        if (isCompressed(recordedParts.getPartInfo(part).fileName))
+            hasCompressedParts = true;
+        else
+            hasUncompressedParts = true;
+    }
+
+    return hasCompressedParts && hasUncompressedParts;
+}
+
+// Returns the parts that still need compressing before the first given
+// parts can be joined, which is none when they already share a format.
+QVector<uint>
+PartCompressor::getPartsToUnify(const RecordedPartsTracker &recordedParts,
+                                uint numParts) {
+    QVector<uint> partsToUnify;
+    if (!hasMixedFormats(recordedParts, numParts))
+        return partsToUnify;
+
+    for (uint part = 0; part < numParts; part++) {
+        if (recordedParts.isRecorded(part) &&
+            canCompress(recordedParts.getPartInfo(part)))
+            partsToUnify.append(part);
+    }
+
+    return partsToUnify;
+}
+
+bool PartCompressor::compressFile(const QString &partPath) {
+    const QFileInfo partInfo(partPath);
+    const qint64 partSize = partInfo.size();
+    const QDateTime partModified = partInfo.lastModified();
+
+    const QString compressedPath = getCompressedPath(partPath);
+    const QString temporaryPath = compressedPath + ".tmp";
+
+    bool isEncoded = runFfmpeg({"-i", partPath, "-map", "0:a:0", "-c:a",
+                                "flac", "-compression_level", "8", "-f",
+                                "flac", temporaryPath});
+
+    QByteArray partChecksum;
+    if (isEncoded)
+        partChecksum = getAudioChecksum(partPath);
+
+    if (partChecksum.isEmpty() ||
+        partChecksum != getAudioChecksum(temporaryPath)) {
+        QFile::remove(temporaryPath);
+        return false;
+    }
+
+    // The part may have been recorded again while it was being compressed.
+    const QFileInfo currentInfo(partPath);
+    if (!currentInfo.exists() || currentInfo.size() != partSize ||
+        currentInfo.lastModified() != partModified) {
+        QFile::remove(temporaryPath);
+        return false;
+    }
+
+    QFile::remove(compressedPath);
+    if (!QFile::rename(temporaryPath, compressedPath)) {
+        QFile::remove(temporaryPath);
+        return false;
+    }
+
+    return QFile::remove(partPath);
+}
+
+// Encodes a part in the format the extension of the new path stands for,
+// as the recorder would have written it. The part itself is left as it is.
+bool PartCompressor::convertFile(const QString &partPath,
+                                 const QString &convertedPath) {
+    if (runFfmpeg({"-i", partPath, "-map", "0:a:0", convertedPath}))
+        return true;
+
+    QFile::remove(convertedPath);
+    return false;
+}
+
+QString PartCompressor::getCompressedPath(const QString &partPath) {
+    const QFileInfo partInfo(partPath);
+
+    return partInfo.path() + "/" + partInfo.completeBaseName() +
+           compressedExtension;
+}
+
+// Hashes the decoded samples rather than the file, so a part and its
+// compressed copy hash the same exactly when no sample changed. The md5
+// muxer would hash them as 16-bit by default, which hides changes to 24-bit
+// parts, so they are hashed as doubles, which hold any integer sample.
+QByteArray PartCompressor::getAudioChecksum(const QString &partPath) {
+    QByteArray checksum;
+    if (!runFfmpeg({"-i", partPath, "-map", "0:a:0", "-c:a", "pcm_f64le",
+                    "-f", "md5", "-"},
+                   &checksum))
+        return QByteArray();
+
+    checksum = checksum.trimmed();
+    return checksum.startsWith("MD5=") ? checksum : QByteArray();
+}
+
+bool PartCompressor::runFfmpeg(const QStringList &arguments,
+                               QByteArray *output) {
+    QProcess ffmpeg;
+    ffmpeg.start("ffmpeg", QStringList{"-nostdin", "-v", "error", "-threads",
+                                       "1", "-y"} +
+                               arguments);
+
+    if (!ffmpeg.waitForFinished(-1) ||
+        ffmpeg.exitStatus() != QProcess::NormalExit || ffmpeg.exitCode() != 0)
+        return false;
+
+    if (output != nullptr)
+        *output = ffmpeg.readAllStandardOutput();
+
+    return true;
+}
@@ -0,0 +1,47 @@
+#ifndef PARTCOMPRESSOR_H
+#define PARTCOMPRESSOR_H
+
+#include "recordedpartstracker.h"
+#include <QFuture>
+#include <QObject>
+#include <QSet>
+#include <QThreadPool>
+#include <QVector>
+#include <atomic>
+
+// Losslessly compresses finished parts to FLAC with ffmpeg on a single low
+// priority worker. A compressed part only replaces its original once both
+// decode to the same samples.
+class PartCompressor : public QObject {
+    Q_OBJECT
+
+public:
+    explicit PartCompressor(QObject *parent = nullptr);
+    ~PartCompressor() override;
+
+    void compress(uint, const QString &);
+    QFuture<bool> unify(const QStringList &);
+    void pause();
+    void stop();
+
+    static bool canCompress(const RecordedPartsTracker::PartInfo &);
+    static bool isCompressed(const QString &);
+    static bool compressFile(const QString &);
+    static bool convertFile(const QString &, const QString &);
+    static bool hasMixedFormats(const RecordedPartsTracker &, uint);
+    static QVector<uint> getPartsToUnify(const RecordedPartsTracker &, uint);
+
+private:
+    QThreadPool compressionPool;
+    QSet<uint> queuedParts;
+    QFuture<bool> unifyFuture;
+    std::atomic<bool> isStopping{false};
+
+    void onCompressionFinished(uint);
+
+    static QString getCompressedPath(const QString &);
+    static QByteArray getAudioChecksum(const QString &);
+    static bool runFfmpeg(const QStringList &, QByteArray * = nullptr);
+};
+
+#endif // PARTCOMPRESSOR_H
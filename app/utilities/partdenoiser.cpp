@@ -0,0 +1,403 @@
+#include "partdenoiser.h"
+#include "partslist.h"
+#include "tracer.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QFuture>
+#include <QProcess>
+#include <QSaveFile>
+#include <QtConcurrent/QtConcurrent>
+
+// Changes whenever cleaning does, so copies made the old way are redone.
+static const QByteArray cacheVersion = "denoise-2";
+
+static const int waveHeaderSize = 44;
+
+// Runs the work for each of the indices at once on the pool, and waits for
+// all of it.
+template <typename Work>
+static void runForEach(QThreadPool *pool, const QVector<int> &indices,
+                       const Work &work) {
+    QVector<QFuture<void>> futures;
+    for (int index : indices)
+        futures.append(
+            QtConcurrent::run(pool, [&work, index]() { work(index); }));
+
+    for (QFuture<void> &future : futures)
+        future.waitForFinished();
+}
+
+// How a profile is cached, and what of it goes into the key of the copies
+// cleaned with it.
+static QByteArray serializeProfile(const NoiseProfile &profile) {
+    QByteArray serialized;
+    QDataStream profileOutput(&serialized, QIODevice::WriteOnly);
+    profileOutput << cacheVersion << qint32(profile.sampleRate)
+                  << qint32(profile.numFrames) << profile.magnitudes;
+
+    return serialized;
+}
+
+// A 32-bit float WAV header, written once the size of the samples is known.
+static QByteArray getWaveHeader(int sampleRate, int channelCount,
+                                quint32 dataSize) {
+    QByteArray header;
+    QDataStream headerOutput(&header, QIODevice::WriteOnly);
+    headerOutput.setByteOrder(QDataStream::LittleEndian);
+
+    const quint16 frameBytes = static_cast<quint16>(channelCount * 4);
+    headerOutput.writeRawData("RIFF", 4);
+    headerOutput << quint32(waveHeaderSize - 8 + dataSize);
+    headerOutput.writeRawData("WAVEfmt ", 8);
+    headerOutput << quint32(16) << quint16(3)
+                 << static_cast<quint16>(channelCount)
+                 << static_cast<quint32>(sampleRate)
+                 << static_cast<quint32>(sampleRate) * frameBytes
+                 << frameBytes << quint16(32);
+    headerOutput.writeRawData("data", 4);
+    headerOutput << dataSize;
+
+    return header;
+}
+
+PartDenoiser::PartDenoiser(const QVector<Take> &takes,
+                           const QString &cacheDirectory, int sampleRate,
+                           int channelCount)
+    : takes(takes), cacheDirectory(cacheDirectory), sampleRate(sampleRate),
+      channelCount(channelCount), takeKeys(takes.size()),
+      profiles(takes.size()), appliedProfiles(takes.size()),
+      cleanPaths(takes.size()), states(takes.size(), State::Pending) {
+    QDir().mkpath(cacheDirectory);
+}
+
+int PartDenoiser::getNumTakes() const { return takes.size(); }
+
+// Finds the take's own profile, which is read back from an earlier export
+// when the take has not changed since.
+void PartDenoiser::profileTake(int take) {
+    TraceScope traceScope("profile take");
+    const Take &current = takes[take];
+    takeKeys[take] = getTakeKey(current);
+    if (takeKeys[take].isEmpty()) {
+        states[take] = State::Failed;
+        return;
+    }
+
+    const QString profilePath =
+        getCachePath(current.part, takeKeys[take], ".profile");
+    if (readProfile(profilePath, profiles[take]))
+        return;
+
+    NoiseProfiler profiler(sampleRate, channelCount);
+    if (!decodeTake(current,
+                    [&profiler](const float *samples, int numSamples) {
+                        profiler.add(samples, numSamples);
+                    })) {
+        states[take] = State::Failed;
+        return;
+    }
+
+    // A take without pauses is cached too, so it is not decoded again only
+    // to find that out.
+    profiles[take] = profiler.getProfile();
+    writeProfile(profilePath, profiles[take]);
+}
+
+// Once every take is profiled, a take without pauses of its own borrows the
+// profiles of the nearest takes on either side that have them, as those
+// were most likely recorded in the same room on the same day. A copy is
+// named after its take and the profile it is cleaned with, so the takes
+// returned are those without a copy cleaned the same way before.
+QVector<int> PartDenoiser::getTakesToClean() {
+    QVector<int> takesToClean;
+    for (int take = 0; take < takes.size(); take++) {
+        if (states[take] == State::Failed)
+            continue;
+
+        appliedProfiles[take] = profiles[take];
+        if (!profiles[take].isValid()) {
+            QVector<NoiseProfile> neighbours;
+            for (int before = take - 1; before >= 0; before--) {
+                if (profiles[before].isValid()) {
+                    neighbours.append(profiles[before]);
+                    break;
+                }
+            }
+            for (int after = take + 1; after < takes.size(); after++) {
+                if (profiles[after].isValid()) {
+                    neighbours.append(profiles[after]);
+                    break;
+                }
+            }
+
+            appliedProfiles[take] = NoiseProfile::combine(neighbours);
+        }
+
+        QCryptographicHash cleanHash(QCryptographicHash::Sha1);
+        cleanHash.addData(takeKeys[take]);
+        cleanHash.addData(serializeProfile(appliedProfiles[take]));
+
+        const uint part = takes[take].part;
+        cleanPaths[take] = getCachePath(
+            part, cleanHash.result().toHex().left(16), ".wav");
+        removeStaleCopies(take);
+
+        if (QFile::exists(cleanPaths[take])) {
+            states[take] = State::Cached;
+        } else {
+            takesToClean.append(take);
+        }
+    }
+
+    return takesToClean;
+}
+
+void PartDenoiser::cleanTake(int take) {
+    states[take] =
+        writeClean(takes[take], appliedProfiles[take], cleanPaths[take])
+            ? State::Cleaned
+            : State::Failed;
+}
+
+// Takes that were never cleaned count as failed.
+PartDenoiser::Results PartDenoiser::getResults() const {
+    Results results;
+    for (int take = 0; take < takes.size(); take++) {
+        const uint part = takes[take].part;
+        switch (states[take]) {
+        case State::Cached:
+            results.cleanPaths.insert(part, cleanPaths[take]);
+            results.numCached++;
+            break;
+        case State::Cleaned:
+            results.cleanPaths.insert(part, cleanPaths[take]);
+            results.numCleaned++;
+            break;
+        case State::Pending:
+        case State::Failed:
+            results.failedParts.append(part);
+            break;
+        }
+    }
+
+    return results;
+}
+
+// Every take comes out at the denoiser's sample rate and channel count, so
+// that the copies can be joined.
+PartDenoiser::Results PartDenoiser::run(QThreadPool *pool) {
+    TraceScope traceScope("denoise parts");
+
+    QVector<int> allTakes;
+    for (int take = 0; take < takes.size(); take++)
+        allTakes.append(take);
+
+    runForEach(pool, allTakes, [this](int take) { profileTake(take); });
+    runForEach(pool, getTakesToClean(),
+               [this](int take) { cleanTake(take); });
+
+    return getResults();
+}
+
+QString PartDenoiser::getCacheDirectory(const QString &recordingPath) {
+    return recordingPath + "/denoised";
+}
+
+// Keys a take on what changes when it is recorded again, without reading
+// all of it. A part's own file is keyed on its size and time. A packed take
+// is keyed on where it sits in the pack, which is append-only, so the range
+// only holds another take once the pack is compacted; the take's first and
+// last blocks tell the two apart. Returns an empty key when the take cannot
+// be found.
+QByteArray PartDenoiser::getTakeKey(const Take &take) const {
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(cacheVersion);
+    hash.addData(QByteArray::number(sampleRate) + "/" +
+                 QByteArray::number(channelCount));
+
+    if (take.offset < 0) {
+        const QFileInfo takeInfo(take.filePath);
+        if (!takeInfo.exists())
+            return QByteArray();
+
+        hash.addData(
+            QByteArray::number(takeInfo.size()) + "/" +
+            QByteArray::number(takeInfo.lastModified().toMSecsSinceEpoch()));
+        return hash.result().toHex().left(16);
+    }
+
+    QFile packFile(take.filePath);
+    if (!packFile.open(QIODevice::ReadOnly))
+        return QByteArray();
+
+    hash.addData(QByteArray::number(take.offset) + "/" +
+                 QByteArray::number(take.size));
+
+    const qint64 edgeSize = qMin<qint64>(take.size, blockSize);
+    const qint64 lastOffset = take.offset + take.size - edgeSize;
+    for (qint64 edgeOffset : {take.offset, lastOffset}) {
+        if (!packFile.seek(edgeOffset))
+            return QByteArray();
+
+        const QByteArray edge = packFile.read(edgeSize);
+        if (edge.size() != edgeSize)
+            return QByteArray();
+
+        hash.addData(edge);
+    }
+
+    return hash.result().toHex().left(16);
+}
+
+QString PartDenoiser::getCachePath(uint part, const QByteArray &key,
+                                   const QString &extension) const {
+    return cacheDirectory + "/part" + QString::number(part) + "-" +
+           QString::fromLatin1(key) + extension;
+}
+
+// Gives the sink whole frames of interleaved samples as ffmpeg decodes them.
+bool PartDenoiser::decodeTake(const Take &take,
+                              const SampleSink &sink) const {
+    QStringList arguments = {"-nostdin", "-v", "error", "-threads", "1"};
+    if (take.offset >= 0)
+        arguments << "-protocol_whitelist"
+                  << "file,subfile"
+                  << "-i"
+                  << PartsList::getSubfileUrl(take.filePath, take.offset,
+                                              take.size);
+    else
+        arguments << "-i" << take.filePath;
+    arguments << "-map"
+              << "0:a:0"
+              << "-ar" << QString::number(sampleRate) << "-ac"
+              << QString::number(channelCount) << "-c:a"
+              << "pcm_f32le"
+              << "-f"
+              << "f32le"
+              << "-";
+
+    QProcess ffmpeg;
+    ffmpeg.setStandardErrorFile(QProcess::nullDevice());
+    ffmpeg.start("ffmpeg", arguments);
+    if (!ffmpeg.waitForStarted(-1))
+        return false;
+
+    const int frameBytes = channelCount * static_cast<int>(sizeof(float));
+    QByteArray samples;
+    while (ffmpeg.bytesAvailable() > 0 || ffmpeg.waitForReadyRead(-1)) {
+        samples += ffmpeg.read(blockSize);
+
+        const int numBytes = samples.size() - samples.size() % frameBytes;
+        if (numBytes == 0)
+            continue;
+
+        sink(reinterpret_cast<const float *>(samples.constData()),
+             numBytes / static_cast<int>(sizeof(float)));
+        samples.remove(0, numBytes);
+    }
+
+    return ffmpeg.waitForFinished(-1) &&
+           ffmpeg.exitStatus() == QProcess::NormalExit &&
+           ffmpeg.exitCode() == 0;
+}
+
+// The copy only takes the place of an older one once it is complete.
+bool PartDenoiser::writeClean(const Take &take, const NoiseProfile &profile,
+                              const QString &cleanPath) const {
+    TraceScope traceScope("clean take");
+    QSaveFile cleanFile(cleanPath);
+    if (!cleanFile.open(QIODevice::WriteOnly) ||
+        cleanFile.write(getWaveHeader(sampleRate, channelCount, 0)) !=
+            waveHeaderSize)
+        return false;
+
+    NoiseReducer reducer(profile, channelCount);
+    QVector<float> cleaned;
+    qint64 dataSize = 0;
+    bool isWritten = true;
+
+    // ffmpeg decodes to little endian samples, which WAV stores as they are.
+    auto writeCleaned = [&]() {
+        const qint64 numBytes =
+            static_cast<qint64>(cleaned.size()) * sizeof(float);
+        if (cleanFile.write(reinterpret_cast<const char *>(cleaned.constData()),
+                            numBytes) != numBytes)
+            isWritten = false;
+
+        dataSize += numBytes;
+        cleaned.resize(0);
+    };
+
+    const bool isDecoded =
+        decodeTake(take, [&](const float *samples, int numSamples) {
+            reducer.process(samples, numSamples, cleaned);
+            writeCleaned();
+        });
+    reducer.finish(cleaned);
+    writeCleaned();
+
+    if (!isDecoded || !isWritten || dataSize > 0xffffffffLL - waveHeaderSize ||
+        !cleanFile.seek(0))
+        return false;
+
+    const QByteArray header =
+        getWaveHeader(sampleRate, channelCount, static_cast<quint32>(dataSize));
+    if (cleanFile.write(header) != waveHeaderSize)
+        return false;
+
+    return cleanFile.commit();
+}
+
+// Profiles and copies of a take that has since been recorded again, or
+// copies cleaned with a profile it no longer borrows, are of no more use.
+void PartDenoiser::removeStaleCopies(int take) const {
+    const uint part = takes[take].part;
+    const QStringList keptNames = {
+        QFileInfo(getCachePath(part, takeKeys[take], ".profile")).fileName(),
+        QFileInfo(cleanPaths[take]).fileName()};
+
+    QDir directory(cacheDirectory);
+    for (const QString &copyName : directory.entryList(
+             {"part" + QString::number(part) + "-*.wav",
+              "part" + QString::number(part) + "-*.profile"},
+             QDir::Files)) {
+        if (!keptNames.contains(copyName))
+            directory.remove(copyName);
+    }
+}
+
+bool PartDenoiser::readProfile(const QString &profilePath,
+                               NoiseProfile &profile) {
+    QFile profileFile(profilePath);
+    if (!profileFile.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream profileInput(&profileFile);
+    QByteArray version;
+    qint32 sampleRate = 0;
+    qint32 numFrames = 0;
+    QVector<float> magnitudes;
+    profileInput >> version >> sampleRate >> numFrames >> magnitudes;
+
+    const bool isValid = numFrames > 0;
+    if (profileInput.status() != QDataStream::Ok || version != cacheVersion ||
+        isValid != (magnitudes.size() == NoiseReducer::numBins))
+        return false;
+
+    profile.sampleRate = sampleRate;
+    profile.numFrames = numFrames;
+    profile.magnitudes = magnitudes;
+    return true;
+}
+
+bool PartDenoiser::writeProfile(const QString &profilePath,
+                                const NoiseProfile &profile) {
+    QSaveFile profileFile(profilePath);
+    return profileFile.open(QIODevice::WriteOnly) &&
+           profileFile.write(serializeProfile(profile)) >= 0 &&
+           profileFile.commit();
+}
@@ -0,0 +1,81 @@
+#ifndef PARTDENOISER_H
+#define PARTDENOISER_H
+
+#include "noisereducer.h"
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <QThreadPool>
+#include <QVector>
+#include <functional>
+
+// Takes the room noise out of a project's takes at export, without touching
+// the takes themselves. Each take is profiled from its own pauses, and both
+// its profile and its cleaned copy are kept next to each other, named after
+// the take, so a take is only profiled and cleaned again once it is
+// recorded again, or once the profile it borrows changes.
+//
+// Takes are decoded by ffmpeg and streamed through in blocks, several takes
+// at once, so only a block of each is ever held in memory. Every take is
+// profiled before any is cleaned, since a take without pauses of its own
+// borrows the profile of its neighbours; a batch runs the two steps as jobs
+// of its own, and run() does both on a pool.
+class PartDenoiser {
+public:
+    static const int blockSize = 64 * 1024;
+
+    // Parts stored inside a pack give the offset and size of their take.
+    struct Take {
+        uint part = 0;
+        QString filePath;
+        qint64 offset = -1;
+        qint64 size = 0;
+    };
+
+    struct Results {
+        QHash<uint, QString> cleanPaths;
+        QVector<uint> failedParts;
+        int numCleaned = 0;
+        int numCached = 0;
+    };
+
+    PartDenoiser(const QVector<Take> &, const QString &, int, int);
+
+    int getNumTakes() const;
+    void profileTake(int);
+    QVector<int> getTakesToClean();
+    void cleanTake(int);
+    Results getResults() const;
+    Results run(QThreadPool *);
+
+    static QString getCacheDirectory(const QString &);
+
+private:
+    using SampleSink = std::function<void(const float *, int)>;
+
+    enum class State { Pending, Failed, Cached, Cleaned };
+
+    QVector<Take> takes;
+    QString cacheDirectory;
+    int sampleRate = 0;
+    int channelCount = 0;
+
+    // One entry for each take, which only the step working on that take
+    // writes to.
+    QVector<QByteArray> takeKeys;
+    QVector<NoiseProfile> profiles;
+    QVector<NoiseProfile> appliedProfiles;
+    QVector<QString> cleanPaths;
+    QVector<State> states;
+
+    QByteArray getTakeKey(const Take &) const;
+    QString getCachePath(uint, const QByteArray &, const QString &) const;
+    bool decodeTake(const Take &, const SampleSink &) const;
+    bool writeClean(const Take &, const NoiseProfile &, const QString &) const;
+    void removeStaleCopies(int) const;
+
+    static bool readProfile(const QString &, NoiseProfile &);
+    static bool writeProfile(const QString &, const NoiseProfile &);
+};
+
+#endif // PARTDENOISER_H
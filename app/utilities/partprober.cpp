@@ -0,0 +1,180 @@
+#include "partprober.h"
+#include "waveheader.h"
+
+#include <QBuffer>
+#include <QFileInfo>
+#include <QtConcurrent>
+
+PartProber::PartProber(QObject *parent) : QObject(parent) {
+    connect(&probeWatcher, &QFutureWatcher<ProbeResults>::finished, this,
+            &PartProber::onProbeFinished);
+}
+
+PartProber::~PartProber() { probeWatcher.waitForFinished(); }
+
+void PartProber::enqueue(uint part, const QString &filePath, qint64 offset,
+                         qint64 size) {
+    if (pendingPartNumbers.contains(part))
+        return;
+
+    PendingPart pendingPart;
+    pendingPart.part = part;
+    pendingPart.filePath = filePath;
+    pendingPart.offset = offset;
+    pendingPart.size = size;
+    pendingParts.append(pendingPart);
+    pendingPartNumbers.insert(part);
+
+    if (!probeWatcher.isRunning())
+        startNextBatch();
+}
+
+// Drops pending parts and ignores whatever the running batch reports.
+void PartProber::cancel() {
+    pendingParts.clear();
+    pendingPartNumbers.clear();
+    generation++;
+}
+
+void PartProber::startNextBatch() {
+    if (pendingParts.isEmpty())
+        return;
+
+    auto batch = pendingParts;
+    pendingParts.clear();
+    pendingPartNumbers.clear();
+    runningGeneration = generation;
+
+    probeWatcher.setFuture(
+        QtConcurrent::run([batch]() { return probeParts(batch); }));
+}
+
+void PartProber::onProbeFinished() {
+    if (runningGeneration == generation) {
+        const ProbeResults results = probeWatcher.result();
+        for (auto &result : results)
+            emit partProbed(result.first, result.second);
+    }
+
+    startNextBatch();
+}
+
+PartProber::ProbeResults
+PartProber::probeParts(const QVector<PendingPart> &parts) {
+    ProbeResults results;
+    results.reserve(parts.size());
+    for (auto &part : parts) {
+        results.append(std::make_pair(
+            part.part, part.offset < 0 ? probeFile(part.filePath)
+                                       : probePacked(part.filePath,
+                                                     part.offset, part.size)));
+    }
+
+    return results;
+}
+
+RecordedPartsTracker::PartInfo PartProber::probeFile(const QString &filePath) {
+    RecordedPartsTracker::PartInfo info;
+
+    QFile partFile(filePath);
+    if (!partFile.open(QIODevice::ReadOnly))
+        return info;
+
+    QFileInfo partFileInfo(filePath);
+    info.fileName = partFileInfo.fileName();
+    info.byteSize = partFile.size();
+
+    // Containers we cannot look into still count as probed, so they are not
+    // opened again; their duration comes from the recorder instead.
+    if (!probeWave(partFile, partFile.size(), info) &&
+        !(partFile.seek(0) && probeFlac(partFile, info))) {
+        info.codec = partFileInfo.suffix().toLower();
+        if (info.codec.isEmpty())
+            info.codec = "unknown";
+    }
+
+    return info;
+}
+
+RecordedPartsTracker::PartInfo
+PartProber::probePacked(const QString &packPath, qint64 offset, qint64 size) {
+    RecordedPartsTracker::PartInfo info;
+    info.byteSize = size;
+
+    // The headers sit at the start of the take, so that is all we read.
+    QFile packFile(packPath);
+    QByteArray takeStart;
+    if (packFile.open(QIODevice::ReadOnly) && packFile.seek(offset))
+        takeStart = packFile.read(qMin<qint64>(size, 64 * 1024));
+
+    QBuffer takeDevice(&takeStart);
+    takeDevice.open(QIODevice::ReadOnly);
+    if (!probeWave(takeDevice, size, info) &&
+        !(takeDevice.seek(0) && probeFlac(takeDevice, info)))
+        info.codec = "unknown";
+
+    return info;
+}
+
+bool PartProber::probeWave(QIODevice &partDevice, qint64 partSize,
+                           RecordedPartsTracker::PartInfo &info) {
+    WaveHeader header;
+    if (!header.read(partDevice, partSize))
+        return false;
+
+    info.sampleRate = static_cast<int>(header.sampleRate);
+    info.channelCount = header.channelCount;
+    if (header.dataStart > 0 && header.byteRate > 0)
+        info.durationMs = header.dataSize * 1000 / header.byteRate;
+
+    switch (header.formatTag) {
+    case 1:
+        info.codec = header.bitsPerSample == 8
+                         ? QString("pcm_u8")
+                         : QString("pcm_s%1le").arg(header.bitsPerSample);
+        break;
+    case 3:
+        info.codec = QString("pcm_f%1le").arg(header.bitsPerSample);
+        break;
+    case 6:
+        info.codec = "pcm_alaw";
+        break;
+    case 7:
+        info.codec = "pcm_mulaw";
+        break;
+    default:
+        info.codec =
+            QString("wav_0x%1").arg(header.formatTag, 4, 16, QChar('0'));
+        break;
+    }
+
+    return true;
+}
+
+bool PartProber::probeFlac(QIODevice &partDevice,
+                           RecordedPartsTracker::PartInfo &info) {
+    // The stream info block always comes first, right after the marker.
+    const QByteArray header = partDevice.read(4 + 4 + 34);
+    if (header.size() != 42 || !header.startsWith("fLaC") ||
+        (header[4] & 0x7F) != 0)
+        return false;
+
+    auto streamInfo =
+        reinterpret_cast<const unsigned char *>(header.constData() + 8);
+    const quint32 sampleRate = (quint32(streamInfo[10]) << 12) |
+                               (quint32(streamInfo[11]) << 4) |
+                               (streamInfo[12] >> 4);
+    const int channelCount = ((streamInfo[12] >> 1) & 0x7) + 1;
+    const quint64 totalSamples =
+        (quint64(streamInfo[13] & 0xF) << 32) |
+        (quint64(streamInfo[14]) << 24) | (quint64(streamInfo[15]) << 16) |
+        (quint64(streamInfo[16]) << 8) | quint64(streamInfo[17]);
+
+    info.sampleRate = static_cast<int>(sampleRate);
+    info.channelCount = channelCount;
+    info.codec = "flac";
+    if (sampleRate > 0)
+        info.durationMs = static_cast<qint64>(totalSamples * 1000 / sampleRate);
+
+    return true;
+}
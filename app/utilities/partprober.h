@@ -0,0 +1,60 @@
+#ifndef PARTPROBER_H
+#define PARTPROBER_H
+
+#include "recordedpartstracker.h"
+#include <QFile>
+#include <QIODevice>
+#include <QFutureWatcher>
+#include <QObject>
+#include <QSet>
+#include <QVector>
+#include <utility>
+
+// Reads duration, sample rate, channels and codec out of part files on a
+// worker thread, one batch at a time, reporting each part as it is done.
+class PartProber : public QObject {
+    Q_OBJECT
+
+public:
+    using ProbeResults =
+        QVector<std::pair<uint, RecordedPartsTracker::PartInfo>>;
+
+    // Parts stored inside a pack give the offset and size of their take.
+    struct PendingPart {
+        uint part = 0;
+        QString filePath;
+        qint64 offset = -1;
+        qint64 size = 0;
+    };
+
+    explicit PartProber(QObject *parent = nullptr);
+    ~PartProber() override;
+
+    void enqueue(uint, const QString &, qint64 = -1, qint64 = 0);
+    void cancel();
+
+    static RecordedPartsTracker::PartInfo probeFile(const QString &);
+    static RecordedPartsTracker::PartInfo probePacked(const QString &, qint64,
+                                                      qint64);
+    static ProbeResults probeParts(const QVector<PendingPart> &);
+
+signals:
+    void partProbed(uint, const RecordedPartsTracker::PartInfo &);
+
+private slots:
+    void onProbeFinished();
+
+private:
+    QVector<PendingPart> pendingParts;
+    QSet<uint> pendingPartNumbers;
+    QFutureWatcher<ProbeResults> probeWatcher;
+    quint64 generation = 0;
+    quint64 runningGeneration = 0;
+
+    void startNextBatch();
+    static bool probeWave(QIODevice &, qint64,
+                          RecordedPartsTracker::PartInfo &);
+    static bool probeFlac(QIODevice &, RecordedPartsTracker::PartInfo &);
+};
+
+#endif // PARTPROBER_H
@@ -0,0 +1,89 @@
+#include "partslist.h"
+
+#include <QFile>
+#include <QTextStream>
+
+QString PartsList::getListPath(const QString &recordingPath) {
+    return recordingPath + "/parts-list.txt";
+}
+
+// Each chapter gets a list of its own next to the one for the whole book.
+QString PartsList::getChapterListPath(const QString &recordingPath,
+                                      int chapter) {
+    return recordingPath + "/parts-list-" +
+           QString::number(chapter + 1).rightJustified(2, QChar('0')) +
+           ".txt";
+}
+
+bool PartsList::writeFiles(const QString &listPath,
+                           const QStringList &partPaths) {
+    QFile partsFile(listPath);
+    if (!partsFile.open(QIODevice::WriteOnly | QIODevice::Text))
+        return false;
+
+    QTextStream fileOutput(&partsFile);
+    for (const QString &partPath : partPaths)
+        fileOutput << "file " << partPath << '\n';
+    fileOutput << flush;
+
+    return fileOutput.status() == QTextStream::Ok;
+}
+
+// Packed parts from the first one up to the end one are listed as byte
+// ranges of the pack, which ffmpeg reads through its subfile protocol.
+bool PartsList::writePacked(const QString &listPath, const PartsPack &pack,
+                            uint firstPart, uint endPart) {
+    QFile partsFile(listPath);
+    if (!partsFile.open(QIODevice::WriteOnly | QIODevice::Text))
+        return false;
+
+    QTextStream fileOutput(&partsFile);
+    for (uint part = firstPart; part < endPart; part++) {
+        if (!pack.contains(part))
+            continue;
+
+        fileOutput << "file '"
+                   << getSubfileUrl(pack.getPackPath(),
+                                    pack.getPartOffset(part),
+                                    pack.getPartSize(part))
+                   << "'\n";
+    }
+    fileOutput << flush;
+
+    return fileOutput.status() == QTextStream::Ok;
+}
+
+// How ffmpeg reads one take out of a pack, given where it starts and how
+// long it is. It has to be let in with -protocol_whitelist file,subfile.
+QString PartsList::getSubfileUrl(const QString &packPath, qint64 offset,
+                                 qint64 size) {
+    return QString("subfile,,start,%1,end,%2,,:%3")
+        .arg(offset)
+        .arg(offset + size)
+        .arg(packPath);
+}
+
+// The ffmpeg arguments that join the listed parts into one file without
+// encoding them again, marking its chapters when there is metadata for them.
+QStringList PartsList::getConcatArguments(const QString &listPath,
+                                          bool isPacked,
+                                          const QString &outputPath,
+                                          const QString &metadataPath) {
+    QStringList arguments = {"-nostdin", "-v", "error", "-y", "-f", "concat",
+                             "-safe", "0"};
+    if (isPacked)
+        arguments << "-protocol_whitelist"
+                  << "file,subfile";
+    arguments << "-i" << listPath;
+    if (!metadataPath.isEmpty())
+        arguments << "-i" << metadataPath << "-map"
+                  << "0"
+                  << "-map_metadata"
+                  << "1"
+                  << "-map_chapters"
+                  << "1";
+    arguments << "-c"
+              << "copy" << outputPath;
+
+    return arguments;
+}
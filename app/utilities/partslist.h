@@ -0,0 +1,22 @@
+#ifndef PARTSLIST_H
+#define PARTSLIST_H
+
+#include "partspack.h"
+#include <QString>
+#include <QStringList>
+
+// Writes the parts-list.txt that ffmpeg's concat demuxer joins a book's
+// parts with, whether the parts are separate files or packed together.
+class PartsList {
+public:
+    static QString getListPath(const QString &);
+    static QString getChapterListPath(const QString &, int);
+    static bool writeFiles(const QString &, const QStringList &);
+    static bool writePacked(const QString &, const PartsPack &, uint, uint);
+    static QString getSubfileUrl(const QString &, qint64, qint64);
+    static QStringList getConcatArguments(const QString &, bool,
+                                          const QString &,
+                                          const QString & = QString());
+};
+
+#endif // PARTSLIST_H
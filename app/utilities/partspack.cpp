@@ -0,0 +1,406 @@
+#include "partspack.h"
+
+#include <QSaveFile>
+#include <QtEndian>
+#include <cstring>
+
+static const quint32 packMagic = 0x4e44504b;   // "NDPK"
+static const quint32 recordMagic = 0x4e445052; // "NDPR"
+static const quint32 indexMagic = 0x4e445049;  // "NDPI"
+static const quint32 packVersion = 1;
+
+// Pack: magic, version, reserved.
+static const qint64 packHeaderSize = 16;
+// Record: magic, part, size of the take (0 marks a removed part), take.
+static const qint64 recordHeaderSize = 16;
+// Index: magic, version, capacity, reserved, pack size the index describes.
+static const qint64 indexHeaderSize = 24;
+// Entry: offset of the take in the pack (0 when absent), size of the take.
+static const qint64 entrySize = 16;
+
+static const quint32 initialCapacity = 1024;
+
+static QByteArray createPackHeader() {
+    QByteArray header(packHeaderSize, '\0');
+    qToLittleEndian<quint32>(packMagic, header.data());
+    qToLittleEndian<quint32>(packVersion, header.data() + 4);
+
+    return header;
+}
+
+static QByteArray createRecordHeader(uint part, qint64 size) {
+    QByteArray header(recordHeaderSize, '\0');
+    qToLittleEndian<quint32>(recordMagic, header.data());
+    qToLittleEndian<quint32>(part, header.data() + 4);
+    qToLittleEndian<qint64>(size, header.data() + 8);
+
+    return header;
+}
+
+PartsPack::PartsPack() {}
+
+PartsPack::~PartsPack() { close(); }
+
+bool PartsPack::open(const QString &packPath) {
+    close();
+
+    packFile.setFileName(packPath);
+    if (!packFile.open(QIODevice::ReadWrite))
+        return false;
+
+    if (packFile.size() < packHeaderSize) {
+        packFile.resize(0);
+        if (packFile.write(createPackHeader()) != packHeaderSize ||
+            !packFile.flush()) {
+            close();
+            return false;
+        }
+    } else {
+        QByteArray header = packFile.read(packHeaderSize);
+        if (qFromLittleEndian<quint32>(header.constData()) != packMagic ||
+            qFromLittleEndian<quint32>(header.constData() + 4) != packVersion) {
+            close();
+            return false;
+        }
+    }
+
+    indexFile.setFileName(packPath + ".idx");
+    if (!indexFile.open(QIODevice::ReadWrite)) {
+        close();
+        return false;
+    }
+
+    // An index that does not describe the whole pack missed the last append,
+    // most likely because the application stopped halfway through it.
+    bool isIndexValid = false;
+    QByteArray indexHeader = indexFile.read(indexHeaderSize);
+    if (indexHeader.size() == indexHeaderSize &&
+        qFromLittleEndian<quint32>(indexHeader.constData()) == indexMagic &&
+        qFromLittleEndian<quint32>(indexHeader.constData() + 4) ==
+            packVersion) {
+        quint32 indexCapacity =
+            qFromLittleEndian<quint32>(indexHeader.constData() + 8);
+
+        isIndexValid =
+            indexFile.size() == indexHeaderSize + indexCapacity * entrySize &&
+            mapIndex(indexCapacity) && getIndexedPackSize() == packFile.size();
+    }
+
+    if (!isIndexValid && !rebuildIndex()) {
+        close();
+        return false;
+    }
+
+    liveBytes = 0;
+    for (auto &part : getParts())
+        liveBytes += recordHeaderSize + part.second;
+
+    return true;
+}
+
+void PartsPack::close() {
+    unmapIndex();
+
+    if (indexFile.isOpen())
+        indexFile.close();
+    if (packFile.isOpen())
+        packFile.close();
+
+    liveBytes = 0;
+}
+
+bool PartsPack::isOpen() const {
+    return packFile.isOpen() && indexMap != nullptr;
+}
+
+QString PartsPack::getPackPath() const { return packFile.fileName(); }
+
+bool PartsPack::contains(uint part) const {
+    return getPartOffset(part) != 0;
+}
+
+bool PartsPack::appendPart(uint part, const QByteArray &take) {
+    if (!isOpen() || take.isEmpty() || part >= maxParts)
+        return false;
+
+    qint64 recordPosition = packFile.size();
+    if (!writeRecord(part, take))
+        return false;
+
+    // A take the offset table has no room for could never be read back.
+    const qint64 replacedBytes =
+        contains(part) ? recordHeaderSize + getPartSize(part) : 0;
+    if (!setEntry(part, recordPosition + recordHeaderSize, take.size())) {
+        packFile.resize(recordPosition);
+        return false;
+    }
+
+    liveBytes += recordHeaderSize + take.size() - replacedBytes;
+    setIndexedPackSize(packFile.size());
+
+    return true;
+}
+
+bool PartsPack::removePart(uint part) {
+    if (!isOpen() || !contains(part))
+        return false;
+
+    if (!writeRecord(part, QByteArray()))
+        return false;
+
+    const qint64 removedBytes = recordHeaderSize + getPartSize(part);
+    if (!setEntry(part, 0, 0))
+        return false;
+
+    liveBytes -= removedBytes;
+    setIndexedPackSize(packFile.size());
+
+    return true;
+}
+
+// Points the part back at the take it had before, given by the offset and
+// size it had then, or removes it when the offset is 0. Replaced takes stay
+// in the pack until it is compacted, so this undoes appends that turn out
+// to be part of a larger change that failed. Only the offset table points
+// back, so rebuilding it still finds the take that was appended last.
+bool PartsPack::restorePart(uint part, qint64 offset, qint64 size) {
+    if (offset == 0)
+        return !contains(part) || removePart(part);
+
+    if (!isOpen() || size <= 0 || offset < packHeaderSize + recordHeaderSize ||
+        offset + size > packFile.size())
+        return false;
+
+    const qint64 replacedBytes =
+        contains(part) ? recordHeaderSize + getPartSize(part) : 0;
+    if (!setEntry(part, offset, size))
+        return false;
+
+    liveBytes += recordHeaderSize + size - replacedBytes;
+    return true;
+}
+
+QByteArray PartsPack::readPart(uint part) {
+    if (!isOpen() || !contains(part))
+        return QByteArray();
+
+    if (!packFile.seek(getPartOffset(part)))
+        return QByteArray();
+
+    return packFile.read(getPartSize(part));
+}
+
+qint64 PartsPack::getPartOffset(uint part) const {
+    if (indexMap == nullptr || part >= capacity)
+        return 0;
+
+    return qFromLittleEndian<qint64>(indexMap + indexHeaderSize +
+                                     part * entrySize);
+}
+
+qint64 PartsPack::getPartSize(uint part) const {
+    if (indexMap == nullptr || part >= capacity)
+        return 0;
+
+    return qFromLittleEndian<qint64>(indexMap + indexHeaderSize +
+                                     part * entrySize + 8);
+}
+
+QVector<std::pair<uint, qint64>> PartsPack::getParts() const {
+    QVector<std::pair<uint, qint64>> parts;
+    for (uint part = 0; part < capacity; part++) {
+        if (contains(part))
+            parts.append(std::make_pair(part, getPartSize(part)));
+    }
+
+    return parts;
+}
+
+qint64 PartsPack::getLiveBytes() const { return liveBytes; }
+
+qint64 PartsPack::getDeadBytes() const {
+    if (!isOpen())
+        return 0;
+
+    return packFile.size() - packHeaderSize - liveBytes;
+}
+
+// The offset table is mapped rather than read, so the system pages it in and
+// out as it is used.
+qint64 PartsPack::getMappedBytes() const {
+    if (indexMap == nullptr)
+        return 0;
+
+    return indexHeaderSize + static_cast<qint64>(capacity) * entrySize;
+}
+
+// Rewrites the pack with only the current take of every part.
+bool PartsPack::compact() {
+    if (!isOpen())
+        return false;
+
+    const auto parts = getParts();
+    QVector<qint64> compactedOffsets;
+    compactedOffsets.reserve(parts.size());
+
+    QSaveFile compactedFile(packFile.fileName());
+    if (!compactedFile.open(QIODevice::WriteOnly))
+        return false;
+
+    qint64 position = compactedFile.write(createPackHeader());
+    for (auto &part : parts) {
+        QByteArray take = readPart(part.first);
+        if (take.size() != part.second)
+            return false;
+
+        position += compactedFile.write(createRecordHeader(part.first,
+                                                           take.size()));
+        compactedOffsets.append(position);
+        position += compactedFile.write(take);
+    }
+
+    // The pack cannot be replaced while it is still open on some platforms.
+    packFile.close();
+    bool isCommitted = compactedFile.commit();
+    if (!packFile.open(QIODevice::ReadWrite)) {
+        close();
+        return false;
+    }
+
+    if (!isCommitted)
+        return false;
+
+    std::memset(indexMap + indexHeaderSize, 0, capacity * entrySize);
+    for (int i = 0; i < parts.size(); i++)
+        setEntry(parts[i].first, compactedOffsets[i], parts[i].second);
+    setIndexedPackSize(packFile.size());
+
+    return true;
+}
+
+// Compacts once replaced takes make up a sizeable share of the pack.
+bool PartsPack::compactIfNeeded() {
+    const qint64 deadBytes = getDeadBytes();
+    if (deadBytes < 16 * 1024 * 1024 || deadBytes < liveBytes / 4)
+        return false;
+
+    return compact();
+}
+
+bool PartsPack::mapIndex(quint32 newCapacity) {
+    unmapIndex();
+
+    qint64 indexSize = indexHeaderSize + newCapacity * entrySize;
+    if (indexFile.size() != indexSize && !indexFile.resize(indexSize))
+        return false;
+
+    indexMap = indexFile.map(0, indexSize);
+    if (indexMap == nullptr)
+        return false;
+
+    capacity = newCapacity;
+    qToLittleEndian<quint32>(indexMagic, indexMap);
+    qToLittleEndian<quint32>(packVersion, indexMap + 4);
+    qToLittleEndian<quint32>(capacity, indexMap + 8);
+
+    return true;
+}
+
+void PartsPack::unmapIndex() {
+    if (indexMap != nullptr)
+        indexFile.unmap(indexMap);
+
+    indexMap = nullptr;
+    capacity = 0;
+}
+
+bool PartsPack::createIndex() {
+    unmapIndex();
+
+    return indexFile.resize(0) && mapIndex(initialCapacity);
+}
+
+// Walks every record of the pack, later takes of a part replacing earlier
+// ones. A record cut short by a crash is dropped from the pack.
+bool PartsPack::rebuildIndex() {
+    if (!createIndex())
+        return false;
+
+    qint64 position = packHeaderSize;
+    while (position + recordHeaderSize <= packFile.size()) {
+        if (!packFile.seek(position))
+            return false;
+
+        QByteArray header = packFile.read(recordHeaderSize);
+        uint part = qFromLittleEndian<quint32>(header.constData() + 4);
+        qint64 size = qFromLittleEndian<qint64>(header.constData() + 8);
+
+        if (qFromLittleEndian<quint32>(header.constData()) != recordMagic ||
+            size < 0 || position + recordHeaderSize + size > packFile.size())
+            break;
+
+        // A part number no take could have is from a damaged header.
+        if (part < maxParts &&
+            !setEntry(part, size == 0 ? 0 : position + recordHeaderSize, size))
+            return false;
+        position += recordHeaderSize + size;
+    }
+
+    if (position != packFile.size() && !packFile.resize(position))
+        return false;
+
+    setIndexedPackSize(packFile.size());
+    return true;
+}
+
+bool PartsPack::writeRecord(uint part, const QByteArray &take) {
+    qint64 recordPosition = packFile.size();
+    if (!packFile.seek(recordPosition))
+        return false;
+
+    if (packFile.write(createRecordHeader(part, take.size())) !=
+            recordHeaderSize ||
+        packFile.write(take) != take.size() || !packFile.flush()) {
+        packFile.resize(recordPosition);
+        return false;
+    }
+
+    return true;
+}
+
+// Grows the offset table when the part is past its end. When it cannot be
+// grown, the table is mapped as it was and the entry is not set.
+bool PartsPack::setEntry(uint part, qint64 offset, qint64 size) {
+    if (part >= maxParts)
+        return false;
+
+    if (part >= capacity) {
+        const quint32 oldCapacity = capacity;
+        qint64 newCapacity = qMax(capacity, initialCapacity);
+        while (newCapacity <= part)
+            newCapacity *= 2;
+
+        if (!mapIndex(static_cast<quint32>(newCapacity))) {
+            mapIndex(oldCapacity);
+            return false;
+        }
+    }
+
+    uchar *entry = indexMap + indexHeaderSize + part * entrySize;
+    qToLittleEndian<qint64>(offset, entry);
+    qToLittleEndian<qint64>(size, entry + 8);
+
+    return true;
+}
+
+void PartsPack::setIndexedPackSize(qint64 packSize) {
+    if (indexMap != nullptr)
+        qToLittleEndian<qint64>(packSize, indexMap + 16);
+}
+
+qint64 PartsPack::getIndexedPackSize() const {
+    if (indexMap == nullptr)
+        return -1;
+
+    return qFromLittleEndian<qint64>(indexMap + 16);
+}
@@ -0,0 +1,61 @@
+#ifndef PARTSPACK_H
+#define PARTSPACK_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QVector>
+#include <utility>
+
+// Stores every take of a project in one append-only pack file. Which take
+// belongs to which paragraph is kept in a memory mapped offset table next to
+// the pack, which can always be rebuilt by walking the pack's records.
+// Replaced and removed takes stay in the pack until it is compacted.
+class PartsPack {
+public:
+    // Parts from here on are refused, so that a stray part number cannot
+    // grow the offset table without bound.
+    static const uint maxParts = 1 << 24;
+
+    PartsPack();
+    ~PartsPack();
+
+    bool open(const QString &);
+    void close();
+    bool isOpen() const;
+    QString getPackPath() const;
+
+    bool contains(uint) const;
+    bool appendPart(uint, const QByteArray &);
+    bool removePart(uint);
+    bool restorePart(uint, qint64, qint64);
+    QByteArray readPart(uint);
+    qint64 getPartOffset(uint) const;
+    qint64 getPartSize(uint) const;
+    QVector<std::pair<uint, qint64>> getParts() const;
+
+    qint64 getLiveBytes() const;
+    qint64 getDeadBytes() const;
+    qint64 getMappedBytes() const;
+    bool compact();
+    bool compactIfNeeded();
+
+private:
+    QFile packFile;
+    QFile indexFile;
+    uchar *indexMap = nullptr;
+    quint32 capacity = 0;
+    qint64 liveBytes = 0;
+
+    bool mapIndex(quint32);
+    void unmapIndex();
+    bool createIndex();
+    bool rebuildIndex();
+    bool writeRecord(uint, const QByteArray &);
+
+    bool setEntry(uint, qint64, qint64);
+    void setIndexedPackSize(qint64);
+    qint64 getIndexedPackSize() const;
+};
+
+#endif // PARTSPACK_H
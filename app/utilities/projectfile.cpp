@@ -0,0 +1,173 @@
+#include "projectfile.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QTextStream>
+
+bool ProjectFile::load(const QString &projectFilePath) {
+    QFile projectFile(projectFilePath);
+    if (!projectFile.open(QIODevice::ReadOnly | QIODevice::Text))
+        return false;
+
+    QTextStream prjInput(&projectFile);
+
+    // Number of paragraphs total.
+    prgNumTotal = prjInput.readLine().toUInt();
+
+    // Known paragraph locations
+    prgStarts.clear();
+    for (const QStringRef &prgStart :
+         prjInput.readLine().splitRef(',', QString::SkipEmptyParts))
+        prgStarts.append(prgStart.toLongLong());
+
+    // Paragraph user was last on.
+    prgNum = prjInput.readLine().toInt();
+
+    // Text file being read for narration.
+    textFilePath = prjInput.readLine();
+
+    // Audio extension for parts
+    audioExtension = prjInput.readLine();
+
+    // Words per paragraph, which older projects do not have yet.
+    wordCounts.clear();
+    for (const QStringRef &wordCount :
+         prjInput.readLine().splitRef(',', QString::SkipEmptyParts))
+        wordCounts.append(wordCount.toUInt());
+
+    // Whether parts are separate files or share one pack file.
+    isPackStorage = prjInput.readLine() == "pack";
+
+    // Chapters as the paragraph each starts at and its title, separated by
+    // tabs. Titles never hold tabs themselves, and may be empty.
+    chapters.clear();
+    const QStringList chapterFields = prjInput.readLine().split('\t');
+    for (int field = 0; field + 1 < chapterFields.size(); field += 2) {
+        ChapterList::Chapter chapter;
+        chapter.firstPrg = chapterFields[field].toUInt();
+        chapter.title = chapterFields[field + 1];
+        chapters.append(chapter);
+    }
+
+    // The patterns the chapters were found with. Older projects do not have
+    // them, and neither do projects whose chapters were never looked for.
+    chapterPatternsKey = prjInput.readLine();
+
+    // Projects saved before the format had a version are version 1. Newer
+    // ones than this knows may hold values it cannot read.
+    const QString version = prjInput.readLine();
+    return version.isEmpty() || version.toInt() <= formatVersion;
+}
+
+// The project only replaces the saved one once it is written in full, so a
+// crash while saving leaves the previous one in place.
+bool ProjectFile::save(const QString &projectFilePath) const {
+    QSaveFile projectFile(projectFilePath);
+    if (!projectFile.open(QIODevice::WriteOnly | QIODevice::Text))
+        return false;
+
+    QTextStream fileOutput(&projectFile);
+    fileOutput << prgNumTotal << '\n';
+    for (qint64 prgStart : prgStarts)
+        fileOutput << prgStart << ",";
+    fileOutput << '\n';
+    fileOutput << prgNum << '\n';
+    fileOutput << textFilePath << '\n';
+    fileOutput << audioExtension << '\n';
+    for (quint32 wordCount : wordCounts)
+        fileOutput << wordCount << ",";
+    fileOutput << '\n';
+    fileOutput << (isPackStorage ? "pack" : "files") << '\n';
+    for (int chapter = 0; chapter < chapters.size(); chapter++) {
+        if (chapter > 0)
+            fileOutput << '\t';
+        fileOutput << chapters[chapter].firstPrg << '\t'
+                   << chapters[chapter].title;
+    }
+    fileOutput << '\n';
+    fileOutput << chapterPatternsKey << '\n';
+    fileOutput << formatVersion << '\n' << flush;
+
+    return fileOutput.status() == QTextStream::Ok && projectFile.commit();
+}
+
+// The text's file name without its extension, or nothing when it has none.
+QString ProjectFile::getBookName(const QString &textFilePath) {
+    QString textFileName = QFileInfo(textFilePath).fileName();
+
+    auto extensionPosition = textFileName.lastIndexOf(".");
+    return extensionPosition != -1 ? textFileName.left(extensionPosition)
+                                   : "";
+}
+
+QString ProjectFile::getRecordingPath(const QString &textFilePath) {
+    return QStandardPaths::writableLocation(QStandardPaths::MusicLocation) +
+           "/" + getBookName(textFilePath);
+}
+
+QString ProjectFile::getProjectFilePath(const QString &textFilePath) {
+    return getRecordingPath(textFilePath) + "/" + getBookName(textFilePath) +
+           ".ndp";
+}
+
+QString ProjectFile::getTrackerFilePath(const QString &textFilePath) {
+    return getRecordingPath(textFilePath) + "/" + getBookName(textFilePath) +
+           ".ndr";
+}
+
+QString ProjectFile::getPackFilePath(const QString &textFilePath) {
+    return getRecordingPath(textFilePath) + "/" + getBookName(textFilePath) +
+           ".ndpack";
+}
+
+// Every session narrating the text keeps a journal of its own, named after
+// its claims token, since sessions cannot share one file to append to.
+QString ProjectFile::getJournalPath(const QString &textFilePath,
+                                    quint32 session) {
+    QString journalPath =
+        getRecordingPath(textFilePath) + "/" + getBookName(textFilePath);
+    if (session != 0)
+        journalPath += "." + QString::number(session);
+
+    return journalPath + ".ndj";
+}
+
+// The journals of every session, the oldest changed first, which is the
+// order they are replayed in.
+QStringList ProjectFile::getJournalPaths(const QString &textFilePath) {
+    const QString bookName = getBookName(textFilePath);
+    const QFileInfoList journalFiles =
+        QDir(getRecordingPath(textFilePath))
+            .entryInfoList(QStringList() << "*.ndj", QDir::Files,
+                           QDir::Time | QDir::Reversed);
+
+    QStringList journalPaths;
+    for (const QFileInfo &journalFile : journalFiles) {
+        // Either the book's own journal or one named after a session.
+        const QString fileName = journalFile.fileName();
+        const QString session = fileName.mid(
+            bookName.size() + 1, fileName.size() - bookName.size() - 5);
+        bool isSession = false;
+        if (fileName == bookName + ".ndj" ||
+            (fileName.startsWith(bookName + ".") &&
+             session.toUInt(&isSession) != 0 && isSession))
+            journalPaths.append(journalFile.filePath());
+    }
+
+    return journalPaths;
+}
+
+// Parts keep their recorded name until they are compressed, so the name the
+// tracker found wins over the one the project's audio extension suggests.
+QString ProjectFile::getPartPath(const QString &recordingPath, uint part,
+                                 const QString &trackedFileName,
+                                 const QString &audioExtension) {
+    QString partFileName = trackedFileName;
+    if (partFileName.isEmpty())
+        partFileName = "part" + QString::number(part) + audioExtension;
+
+    return recordingPath + "/" + partFileName;
+}
@@ -0,0 +1,41 @@
+#ifndef PROJECTFILE_H
+#define PROJECTFILE_H
+
+#include "chapterlist.h"
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// What a .ndp project remembers about narrating one text file. Projects,
+// trackers, packs and parts all live in the text's recording directory,
+// which is named after the text.
+struct ProjectFile {
+    // Bumped when a value's range grows in a way older versions would read
+    // wrongly. Paragraph starts have been 64-bit since version 2.
+    static const int formatVersion = 2;
+
+    uint prgNumTotal = 0;
+    QVector<qint64> prgStarts;
+    int prgNum = 0;
+    QString textFilePath;
+    QString audioExtension;
+    QVector<quint32> wordCounts;
+    bool isPackStorage = false;
+    QVector<ChapterList::Chapter> chapters;
+    QString chapterPatternsKey;
+
+    bool load(const QString &);
+    bool save(const QString &) const;
+
+    static QString getBookName(const QString &);
+    static QString getRecordingPath(const QString &);
+    static QString getProjectFilePath(const QString &);
+    static QString getTrackerFilePath(const QString &);
+    static QString getPackFilePath(const QString &);
+    static QString getJournalPath(const QString &, quint32 = 0);
+    static QStringList getJournalPaths(const QString &);
+    static QString getPartPath(const QString &, uint, const QString &,
+                               const QString &);
+};
+
+#endif // PROJECTFILE_H
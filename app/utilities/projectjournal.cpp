@@ -0,0 +1,138 @@
+#include "projectjournal.h"
+
+#include <QList>
+
+ProjectJournal::ProjectJournal() {}
+
+ProjectJournal::~ProjectJournal() { close(); }
+
+// Carries on from the end of the journal.
+bool ProjectJournal::open(const QString &journalPath) {
+    close();
+
+    journalFile.setFileName(journalPath);
+    return journalFile.open(QIODevice::WriteOnly | QIODevice::Append);
+}
+
+// Empties the journal, since everything in it is in the saved project now.
+// Records always go to the end, wherever that is after the command line
+// tool has emptied the journal too.
+bool ProjectJournal::restart(const QString &journalPath) {
+    close();
+
+    journalFile.setFileName(journalPath);
+    return journalFile.open(QIODevice::WriteOnly | QIODevice::Truncate |
+                            QIODevice::Append);
+}
+
+void ProjectJournal::close() {
+    if (journalFile.isOpen())
+        journalFile.close();
+
+    numRecords = 0;
+}
+
+bool ProjectJournal::isOpen() const { return journalFile.isOpen(); }
+
+int ProjectJournal::getNumRecords() const { return numRecords; }
+
+// The paragraph the narrator is on.
+bool ProjectJournal::appendPosition(int prgNum) {
+    return append("P " + QByteArray::number(prgNum));
+}
+
+// Where in the text a paragraph starts, once it has been read up to.
+bool ProjectJournal::appendParagraphStart(int prgIndex, qint64 prgStart) {
+    return append("S " + QByteArray::number(prgIndex) + " " +
+                  QByteArray::number(prgStart));
+}
+
+// A take was recorded for the part, in a file with the extension given.
+bool ProjectJournal::appendTake(uint part, const QString &audioExtension) {
+    return append("T " + QByteArray::number(part) + " " +
+                  audioExtension.toUtf8());
+}
+
+// Applies the journal's records to the project in the order they were made,
+// and returns how many there were. Every record sets a value rather than
+// changing one, so a journal that was already saved into the project can be
+// replayed over it again. Replay stops at the first record that is cut off
+// or does not fit, which is where the program stopped writing.
+int ProjectJournal::replay(const QString &journalPath, ProjectFile &project) {
+    QFile journalFile(journalPath);
+    if (!journalFile.open(QIODevice::ReadOnly))
+        return 0;
+
+    const QByteArray journal = journalFile.readAll();
+    int numReplayed = 0;
+
+    int recordStart = 0;
+    int recordEnd = journal.indexOf('\n', recordStart);
+    while (recordEnd != -1) {
+        if (!applyRecord(journal.mid(recordStart, recordEnd - recordStart),
+                         project))
+            break;
+
+        numReplayed++;
+        recordStart = recordEnd + 1;
+        recordEnd = journal.indexOf('\n', recordStart);
+    }
+
+    return numReplayed;
+}
+
+// Flushed right away, so the record survives the program stopping.
+bool ProjectJournal::append(const QByteArray &record) {
+    if (!journalFile.isOpen())
+        return false;
+
+    if (journalFile.write(record + '\n') != record.size() + 1 ||
+        !journalFile.flush())
+        return false;
+
+    numRecords++;
+    return true;
+}
+
+bool ProjectJournal::applyRecord(const QByteArray &record,
+                                 ProjectFile &project) {
+    const QList<QByteArray> fields = record.split(' ');
+    bool isNumber = false;
+
+    if (fields[0] == "P" && fields.size() == 2) {
+        const int prgNum = fields[1].toInt(&isNumber);
+        if (!isNumber || prgNum < 0)
+            return false;
+
+        project.prgNum = prgNum;
+        return true;
+    }
+
+    if (fields[0] == "S" && fields.size() == 3) {
+        const int prgIndex = fields[1].toInt(&isNumber);
+        if (!isNumber || prgIndex < 0 || prgIndex > project.prgStarts.size())
+            return false;
+
+        const qint64 prgStart = fields[2].toLongLong(&isNumber);
+        if (!isNumber)
+            return false;
+
+        if (prgIndex == project.prgStarts.size())
+            project.prgStarts.append(prgStart);
+        else
+            project.prgStarts[prgIndex] = prgStart;
+        return true;
+    }
+
+    if (fields[0] == "T" && fields.size() == 3) {
+        fields[1].toUInt(&isNumber);
+        if (!isNumber)
+            return false;
+
+        if (!fields[2].isEmpty())
+            project.audioExtension = QString::fromUtf8(fields[2]);
+        return true;
+    }
+
+    return false;
+}
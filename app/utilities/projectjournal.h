@@ -0,0 +1,45 @@
+#ifndef PROJECTJOURNAL_H
+#define PROJECTJOURNAL_H
+
+#include "projectfile.h"
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+
+// Records what changed in a project since it was last saved in full, one
+// short line per change appended to a journal next to the project. Appending
+// costs the same however large the project is, and every line reaches the
+// file before the next change is made, so a crash loses nothing that was
+// recorded. Replaying the journal over the saved project recovers it, and
+// the journal starts over each time the project is saved in full. While
+// several sessions narrate the project, each appends to a journal of its own
+// and none saves the project in full.
+class ProjectJournal {
+public:
+    // How many records to keep before the project is saved in full again.
+    static const int checkpointInterval = 512;
+
+    ProjectJournal();
+    ~ProjectJournal();
+
+    bool open(const QString &);
+    bool restart(const QString &);
+    void close();
+    bool isOpen() const;
+    int getNumRecords() const;
+
+    bool appendPosition(int);
+    bool appendParagraphStart(int, qint64);
+    bool appendTake(uint, const QString &);
+
+    static int replay(const QString &, ProjectFile &);
+
+private:
+    QFile journalFile;
+    int numRecords = 0;
+
+    bool append(const QByteArray &);
+    static bool applyRecord(const QByteArray &, ProjectFile &);
+};
+
+#endif // PROJECTJOURNAL_H
@@ -1,3 +1,458 @@
 #include "recordedpartstracker.h"
 
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QtAlgorithms>
+#include <algorithm>
+#include <climits>
+
+static const quint32 trackerMagic = 0x4e445250; // "NDRP"
+static const quint16 trackerVersion = 2;
+
+// Past this many entries a sorted array takes more room than a bitmap.
+static const int arrayLimit = 4096;
+static const int bitmapWords = 65536 / 64;
+
 RecordedPartsTracker::RecordedPartsTracker() {}
+
+void RecordedPartsTracker::markRecorded(uint part, qint64 byteSize,
+                                        qint64 durationMs) {
+    if (containers[part >> 16].add(part & 0xFFFF))
+        numRecorded++;
+
+    PartInfo &info = partInfos[part];
+    if (byteSize > 0)
+        info.byteSize = byteSize;
+    if (durationMs > 0)
+        info.durationMs = durationMs;
+}
+
+void RecordedPartsTracker::markUnrecorded(uint part) {
+    partInfos.remove(part);
+
+    auto container = containers.find(part >> 16);
+    if (container == containers.end() || !container->remove(part & 0xFFFF))
+        return;
+
+    numRecorded--;
+    if (container->cardinality == 0)
+        containers.erase(container);
+}
+
+// Takes over what another tracker of the same parts knows and this one does
+// not, such as what another session recorded or probed. Parts that both
+// know keep this one's part information unless only the other probed the
+// same file.
+void RecordedPartsTracker::merge(const RecordedPartsTracker &other) {
+    for (auto info = other.partInfos.constBegin();
+         info != other.partInfos.constEnd(); ++info) {
+        if (!isRecorded(info.key())) {
+            markRecorded(info.key());
+            partInfos[info.key()] = *info;
+            continue;
+        }
+
+        PartInfo &ownInfo = partInfos[info.key()];
+        if (!ownInfo.isProbed() && info->isProbed() &&
+            info->fileName == ownInfo.fileName &&
+            info->byteSize == ownInfo.byteSize)
+            ownInfo = *info;
+    }
+}
+
+void RecordedPartsTracker::clear() {
+    containers.clear();
+    partInfos.clear();
+    numRecorded = 0;
+}
+
+bool RecordedPartsTracker::isRecorded(uint part) const {
+    auto container = containers.constFind(part >> 16);
+    return container != containers.constEnd() &&
+           container->contains(part & 0xFFFF);
+}
+
+uint RecordedPartsTracker::getNumRecorded() const { return numRecorded; }
+
+// Returns the first paragraph in [from, total) without a part, or -1.
+int RecordedPartsTracker::getNextUnrecorded(uint from, uint total) const {
+    uint part = from;
+
+    while (part < total) {
+        auto container = containers.constFind(part >> 16);
+        if (container == containers.constEnd())
+            return static_cast<int>(part);
+
+        int unset = container->getNextUnset(part & 0xFFFF);
+        if (unset != -1) {
+            uint candidate = (part & ~0xFFFFu) | static_cast<uint>(unset);
+            return candidate < total ? static_cast<int>(candidate) : -1;
+        }
+
+        part = ((part >> 16) + 1) << 16;
+        if (part == 0)
+            break;
+    }
+
+    return -1;
+}
+
+int RecordedPartsTracker::getFirstUnrecorded(uint total) const {
+    return getNextUnrecorded(0, total);
+}
+
+int RecordedPartsTracker::getProgressPercentage(uint total) const {
+    if (total == 0)
+        return 0;
+
+    return static_cast<int>(qMin(numRecorded, total) * 100ull / total);
+}
+
+RecordedPartsTracker::PartInfo
+RecordedPartsTracker::getPartInfo(uint part) const {
+    return partInfos.value(part);
+}
+
+const QHash<uint, RecordedPartsTracker::PartInfo> &
+RecordedPartsTracker::getPartInfos() const {
+    return partInfos;
+}
+
+bool RecordedPartsTracker::setPartInfo(uint part, const PartInfo &info) {
+    if (!isRecorded(part))
+        return false;
+
+    partInfos[part] = info;
+    return true;
+}
+
+QVector<uint> RecordedPartsTracker::getUnprobedParts() const {
+    QVector<uint> unprobedParts;
+    for (auto info = partInfos.constBegin(); info != partInfos.constEnd();
+         ++info) {
+        if (!info->isProbed())
+            unprobedParts.append(info.key());
+    }
+
+    std::sort(unprobedParts.begin(), unprobedParts.end());
+    return unprobedParts;
+}
+
+// Roughly, since the nodes of the map and hash are sized by Qt.
+qint64 RecordedPartsTracker::getMemoryUsage() const {
+    qint64 bytes = 0;
+    for (const Container &container : containers) {
+        bytes += sizeof(quint16) + sizeof(Container) + 2 * sizeof(void *);
+        bytes += container.values.capacity() * sizeof(quint16) +
+                 container.bits.capacity() * sizeof(quint64);
+    }
+
+    bytes += partInfos.capacity() * sizeof(void *);
+    for (const PartInfo &info : partInfos) {
+        bytes += sizeof(uint) + sizeof(PartInfo) + 2 * sizeof(void *);
+        bytes += (info.fileName.capacity() + info.codec.capacity()) *
+                 sizeof(QChar);
+    }
+
+    return bytes;
+}
+
+// How long each of the first parts is, where parts that were not recorded
+// take no time at all.
+QVector<qint64> RecordedPartsTracker::getDurationsMs(uint numParts) const {
+    QVector<qint64> durationsMs(static_cast<int>(numParts), 0);
+    for (auto info = partInfos.constBegin(); info != partInfos.constEnd();
+         ++info) {
+        if (info.key() < numParts)
+            durationsMs[static_cast<int>(info.key())] = info->durationMs;
+    }
+
+    return durationsMs;
+}
+
+// Rebuilds the index from the part files found in the directory, keeping
+// what is known about parts whose files did not change.
+void RecordedPartsTracker::scanDirectory(const QString &directoryPath) {
+    QHash<uint, PartInfo> previousInfos = partInfos;
+    clear();
+
+    const QFileInfoList partFiles = QDir(directoryPath).entryInfoList(
+        QStringList() << "part*", QDir::Files);
+    for (const QFileInfo &partFile : partFiles) {
+        int part = getPartNumber(partFile.fileName());
+        if (part == -1)
+            continue;
+
+        // A part left with two files, such as by an interrupted conversion,
+        // keeps the larger one, which is the original.
+        if (isRecorded(static_cast<uint>(part)) &&
+            partInfos[static_cast<uint>(part)].byteSize >= partFile.size())
+            continue;
+
+        addScannedPart(static_cast<uint>(part), partFile.fileName(),
+                       partFile.size(), previousInfos);
+    }
+}
+
+// Rebuilds the index from the parts stored in a pack, which have no file
+// names of their own.
+void RecordedPartsTracker::scanPack(
+    const QVector<std::pair<uint, qint64>> &packedParts) {
+    QHash<uint, PartInfo> previousInfos = partInfos;
+    clear();
+
+    for (auto &packedPart : packedParts)
+        addScannedPart(packedPart.first, QString(), packedPart.second,
+                       previousInfos);
+}
+
+void RecordedPartsTracker::addScannedPart(
+    uint part, const QString &fileName, qint64 byteSize,
+    const QHash<uint, PartInfo> &previousInfos) {
+    PartInfo info = previousInfos.value(part);
+    if (info.fileName != fileName || info.byteSize != byteSize) {
+        // A take that just finished only has the recorder's duration.
+        qint64 durationMs = info.byteSize == 0 ? info.durationMs : 0;
+
+        info = PartInfo();
+        info.fileName = fileName;
+        info.byteSize = byteSize;
+        info.durationMs = durationMs;
+    }
+
+    markRecorded(part);
+    partInfos[part] = info;
+}
+
+// Extracts N out of a "partN" or "partN.ext" file name, or returns -1.
+int RecordedPartsTracker::getPartNumber(const QString &fileName) {
+    if (!fileName.startsWith("part"))
+        return -1;
+
+    int extensionPosition = fileName.lastIndexOf('.');
+    QStringRef number = extensionPosition == -1
+                            ? fileName.midRef(4)
+                            : fileName.midRef(4, extensionPosition - 4);
+
+    bool isNumber = false;
+    uint part = number.toUInt(&isNumber);
+    if (!isNumber || part > static_cast<uint>(INT_MAX))
+        return -1;
+
+    return static_cast<int>(part);
+}
+
+bool RecordedPartsTracker::saveToFile(const QString &filePath) const {
+    QSaveFile trackerFile(filePath);
+    if (!trackerFile.open(QIODevice::WriteOnly))
+        return false;
+
+    QDataStream trackerOutput(&trackerFile);
+    trackerOutput.setVersion(QDataStream::Qt_5_0);
+    trackerOutput << trackerMagic << trackerVersion;
+
+    trackerOutput << quint32(containers.size());
+    for (auto container = containers.constBegin();
+         container != containers.constEnd(); ++container) {
+        trackerOutput << container.key() << quint8(container->isBitmap());
+        if (container->isBitmap())
+            trackerOutput << container->bits;
+        else
+            trackerOutput << container->values;
+    }
+
+    trackerOutput << quint32(partInfos.size());
+    for (auto info = partInfos.constBegin(); info != partInfos.constEnd();
+         ++info) {
+        trackerOutput << quint32(info.key()) << info->fileName
+                      << info->byteSize << info->durationMs
+                      << qint32(info->sampleRate) << qint32(info->channelCount)
+                      << info->codec;
+    }
+
+    return trackerFile.commit();
+}
+
+bool RecordedPartsTracker::loadFromFile(const QString &filePath) {
+    clear();
+
+    QFile trackerFile(filePath);
+    if (!trackerFile.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream trackerInput(&trackerFile);
+    trackerInput.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic = 0;
+    quint16 version = 0;
+    trackerInput >> magic >> version;
+    if (magic != trackerMagic || version == 0 || version > trackerVersion)
+        return false;
+
+    quint32 numContainers = 0;
+    trackerInput >> numContainers;
+    for (quint32 i = 0; i < numContainers; i++) {
+        quint16 key = 0;
+        quint8 isBitmap = 0;
+        trackerInput >> key >> isBitmap;
+
+        Container container;
+        if (isBitmap) {
+            trackerInput >> container.bits;
+            if (container.bits.size() != bitmapWords) {
+                clear();
+                return false;
+            }
+            for (quint64 word : container.bits)
+                container.cardinality += qPopulationCount(word);
+        } else {
+            trackerInput >> container.values;
+            container.cardinality = container.values.size();
+        }
+
+        numRecorded += static_cast<uint>(container.cardinality);
+        containers.insert(key, container);
+    }
+
+    quint32 numInfos = 0;
+    trackerInput >> numInfos;
+    for (quint32 i = 0; i < numInfos; i++) {
+        quint32 part = 0;
+        PartInfo info;
+        trackerInput >> part;
+        if (version >= 2)
+            trackerInput >> info.fileName;
+        trackerInput >> info.byteSize >> info.durationMs;
+        if (version >= 2) {
+            qint32 sampleRate = 0;
+            qint32 channelCount = 0;
+            trackerInput >> sampleRate >> channelCount >> info.codec;
+            info.sampleRate = sampleRate;
+            info.channelCount = channelCount;
+        }
+
+        partInfos.insert(part, info);
+    }
+
+    if (trackerInput.status() != QDataStream::Ok) {
+        clear();
+        return false;
+    }
+
+    return true;
+}
+
+//====================
+// Container functions
+//====================
+bool RecordedPartsTracker::Container::contains(quint16 value) const {
+    if (isBitmap())
+        return (bits[value >> 6] >> (value & 63)) & 1;
+
+    return std::binary_search(values.constBegin(), values.constEnd(), value);
+}
+
+bool RecordedPartsTracker::Container::add(quint16 value) {
+    if (isBitmap()) {
+        quint64 &word = bits[value >> 6];
+        quint64 mask = quint64(1) << (value & 63);
+        if (word & mask)
+            return false;
+
+        word |= mask;
+        cardinality++;
+        return true;
+    }
+
+    auto position = std::lower_bound(values.begin(), values.end(), value);
+    if (position != values.end() && *position == value)
+        return false;
+
+    values.insert(position, value);
+    cardinality++;
+    if (cardinality > arrayLimit)
+        toBitmap();
+
+    return true;
+}
+
+bool RecordedPartsTracker::Container::remove(quint16 value) {
+    if (isBitmap()) {
+        quint64 &word = bits[value >> 6];
+        quint64 mask = quint64(1) << (value & 63);
+        if (!(word & mask))
+            return false;
+
+        word &= ~mask;
+        cardinality--;
+        if (cardinality <= arrayLimit)
+            toArray();
+
+        return true;
+    }
+
+    auto position = std::lower_bound(values.begin(), values.end(), value);
+    if (position == values.end() || *position != value)
+        return false;
+
+    values.erase(position);
+    cardinality--;
+    return true;
+}
+
+// Returns the first value at or after the given one that is not present,
+// or -1 when every remaining value in this container is present.
+int RecordedPartsTracker::Container::getNextUnset(quint16 from) const {
+    if (isBitmap()) {
+        int wordIndex = from >> 6;
+        quint64 unsetBits = ~bits[wordIndex] & (~quint64(0) << (from & 63));
+
+        while (unsetBits == 0) {
+            if (++wordIndex == bitmapWords)
+                return -1;
+            unsetBits = ~bits[wordIndex];
+        }
+
+        int bitIndex = 0;
+        while (!((unsetBits >> bitIndex) & 1))
+            bitIndex++;
+
+        return wordIndex * 64 + bitIndex;
+    }
+
+    auto position =
+        std::lower_bound(values.constBegin(), values.constEnd(), from);
+    int candidate = from;
+    while (position != values.constEnd() && *position == candidate) {
+        ++position;
+        candidate++;
+    }
+
+    return candidate <= 0xFFFF ? candidate : -1;
+}
+
+void RecordedPartsTracker::Container::toBitmap() {
+    bits.fill(0, bitmapWords);
+    for (quint16 value : values)
+        bits[value >> 6] |= quint64(1) << (value & 63);
+
+    values.clear();
+    values.squeeze();
+}
+
+void RecordedPartsTracker::Container::toArray() {
+    values.clear();
+    values.reserve(cardinality);
+    for (int wordIndex = 0; wordIndex < bitmapWords; wordIndex++) {
+        quint64 word = bits[wordIndex];
+        for (int bitIndex = 0; word != 0; bitIndex++, word >>= 1) {
+            if (word & 1)
+                values.append(static_cast<quint16>(wordIndex * 64 + bitIndex));
+        }
+    }
+
+    bits.clear();
+    bits.squeeze();
+}
@@ -1,9 +1,77 @@
 #ifndef RECORDEDPARTSTRACKER_H
 #define RECORDEDPARTSTRACKER_H
 
+#include <QHash>
+#include <QMap>
+#include <QString>
+#include <QVector>
+#include <utility>
+
+// Keeps track of which paragraphs have a recorded part without touching the
+// filesystem. Recorded paragraph numbers are stored as a compressed bitmap:
+// numbers are grouped by their upper 16 bits, and each group holds its lower
+// 16 bits either as a sorted array (sparse) or as a plain bitmap (dense).
 class RecordedPartsTracker {
 public:
+    struct PartInfo {
+        QString fileName;
+        qint64 byteSize = 0;
+        qint64 durationMs = 0;
+        int sampleRate = 0;
+        int channelCount = 0;
+        QString codec;
+
+        bool isProbed() const { return !codec.isEmpty(); }
+    };
+
     RecordedPartsTracker();
+
+    void markRecorded(uint, qint64 = 0, qint64 = 0);
+    void markUnrecorded(uint);
+    void merge(const RecordedPartsTracker &);
+    void clear();
+
+    bool isRecorded(uint) const;
+    uint getNumRecorded() const;
+    int getNextUnrecorded(uint, uint) const;
+    int getFirstUnrecorded(uint) const;
+    int getProgressPercentage(uint) const;
+    PartInfo getPartInfo(uint) const;
+    const QHash<uint, PartInfo> &getPartInfos() const;
+    bool setPartInfo(uint, const PartInfo &);
+    QVector<uint> getUnprobedParts() const;
+    QVector<qint64> getDurationsMs(uint) const;
+    qint64 getMemoryUsage() const;
+
+    void scanDirectory(const QString &);
+    void scanPack(const QVector<std::pair<uint, qint64>> &);
+    static int getPartNumber(const QString &);
+
+    bool saveToFile(const QString &) const;
+    bool loadFromFile(const QString &);
+
+private:
+    struct Container {
+        QVector<quint16> values;
+        QVector<quint64> bits;
+        int cardinality = 0;
+
+        bool isBitmap() const { return !bits.isEmpty(); }
+        bool contains(quint16) const;
+        bool add(quint16);
+        bool remove(quint16);
+        int getNextUnset(quint16) const;
+
+        void toBitmap();
+        void toArray();
+    };
+
+    void addScannedPart(uint, const QString &, qint64,
+                        const QHash<uint, PartInfo> &);
+
+    QMap<quint16, Container> containers;
+    QHash<uint, PartInfo> partInfos;
+    uint numRecorded = 0;
 };
 
 #endif // RECORDEDPARTSTRACKER_H
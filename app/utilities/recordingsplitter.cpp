@@ -0,0 +1,381 @@
+#include "recordingsplitter.h"
+#include "waveheader.h"
+
+#include <QDataStream>
+#include <QtEndian>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+static const int waveHeaderSize = 44;
+static const qint64 chunkLimit = 1 << 20;
+
+// How many seconds closer to where a split is expected a pause has to be to
+// win over one that is a second longer. Paragraph breaks are usually the
+// longest pauses a narrator takes, but their place still matters most.
+static const double pauseWeight = 5.0;
+static const double longPauseSeconds = 2.0;
+
+// How many choices the splits may weigh at most, which bounds the memory
+// proposing them takes for long recordings with many pauses.
+static const qint64 maxChoices = 16 * 1024 * 1024;
+
+// Four running sums keep the loop free of a serial dependency, which lets
+// the compiler vectorize it.
+static float sumOfSquares(const float *samples, int count) {
+    float sums[4] = {0, 0, 0, 0};
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        sums[0] += samples[i] * samples[i];
+        sums[1] += samples[i + 1] * samples[i + 1];
+        sums[2] += samples[i + 2] * samples[i + 2];
+        sums[3] += samples[i + 3] * samples[i + 3];
+    }
+
+    float sum = sums[0] + sums[1] + sums[2] + sums[3];
+    for (; i < count; i++)
+        sum += samples[i] * samples[i];
+
+    return sum;
+}
+
+RecordingSplitter::RecordingSplitter(const QString &recordingPath)
+    : recordingFile(recordingPath) {}
+
+bool RecordingSplitter::open() {
+    if (!recordingFile.open(QIODevice::ReadOnly)) {
+        errorString = "Could not open the recording.";
+        return false;
+    }
+
+    if (!readHeader()) {
+        if (errorString.isEmpty())
+            errorString = "The recording is not a WAV file.";
+        recordingFile.close();
+        return false;
+    }
+
+    return true;
+}
+
+// Marks every stretch of at least the given milliseconds that is quieter
+// than the recording's own speech level, ignoring the lead-in and tail.
+bool RecordingSplitter::detectSilences(int minSilenceMs) {
+    silences.clear();
+    if (!recordingFile.seek(dataStart)) {
+        errorString = "Could not read the recording.";
+        return false;
+    }
+
+    const qint64 framesPerWindow = qMax<qint64>(1, sampleRate / 100);
+    const qint64 windowBytes = framesPerWindow * blockAlign;
+    const qint64 chunkBytes = qMax<qint64>(1, chunkLimit / windowBytes) *
+                              windowBytes;
+    const int samplesPerWindow =
+        static_cast<int>(framesPerWindow) * channelCount;
+
+    QVector<float> windowLevels;
+    windowLevels.reserve(static_cast<int>(dataSize / windowBytes + 1));
+    QVector<float> samples;
+
+    qint64 remaining = dataSize;
+    while (remaining > 0) {
+        const QByteArray chunk =
+            recordingFile.read(qMin(chunkBytes, remaining));
+        if (chunk.isEmpty())
+            break;
+        remaining -= chunk.size();
+
+        const int numSamples = chunk.size() / blockAlign * channelCount;
+        toSamples(chunk.constData(), numSamples, samples);
+
+        for (int start = 0; start < numSamples; start += samplesPerWindow) {
+            const int count = qMin(samplesPerWindow, numSamples - start);
+            const float energy =
+                sumOfSquares(samples.constData() + start, count) / count;
+            windowLevels.append(10.0f * std::log10(energy + 1e-10f));
+        }
+    }
+
+    if (windowLevels.isEmpty()) {
+        errorString = "The recording has no audio in it.";
+        return false;
+    }
+
+    // The quietest and loudest tenth stand in for the room and the voice.
+    QVector<float> sortedLevels = windowLevels;
+    auto getLevelAt = [&sortedLevels](double fraction) {
+        auto position = sortedLevels.begin() +
+                        static_cast<int>(fraction * (sortedLevels.size() - 1));
+        std::nth_element(sortedLevels.begin(), position, sortedLevels.end());
+        return *position;
+    };
+    const float noiseFloor = getLevelAt(0.1);
+    const float speechLevel = getLevelAt(0.9);
+    const float threshold =
+        noiseFloor + qMax(6.0f, (speechLevel - noiseFloor) * 0.3f);
+
+    const int minWindows = qMax(1, minSilenceMs / 10);
+    int runStart = -1;
+    for (int window = 0; window <= windowLevels.size(); window++) {
+        if (window < windowLevels.size() &&
+            windowLevels[window] < threshold) {
+            if (runStart == -1)
+                runStart = window;
+            continue;
+        }
+
+        if (runStart > 0 && window < windowLevels.size() &&
+            window - runStart >= minWindows) {
+            Silence silence;
+            silence.startFrame = runStart * framesPerWindow;
+            silence.endFrame = window * framesPerWindow;
+            silences.append(silence);
+        }
+
+        runStart = -1;
+    }
+
+    return true;
+}
+
+// Picks one pause for each boundary between the given paragraphs, weighing
+// how long each pause is against how far it is from where the word counts
+// say the boundary should be. Returns the frames to split at, or nothing
+// when there are fewer pauses than boundaries, or too many of either.
+QVector<qint64>
+RecordingSplitter::proposeSplits(const QVector<quint32> &wordCounts) const {
+    const int numSplits = wordCounts.size() - 1;
+    const int numSilences = silences.size();
+    if (numSplits <= 0 || numSilences < numSplits ||
+        wordCounts.size() > maxParts)
+        return QVector<qint64>();
+
+    // Each split takes a pause after the one the previous split took and
+    // leaves enough for the splits after it, so split n can only take one
+    // of the band of pauses from pause n on.
+    const int bandWidth = numSilences - numSplits + 1;
+    const qint64 numChoices = static_cast<qint64>(numSplits) * bandWidth;
+    if (numChoices > maxChoices)
+        return QVector<qint64>();
+
+    // Paragraphs without a count are taken to be of equal length.
+    quint64 totalWords = 0;
+    for (quint32 wordCount : wordCounts)
+        totalWords += wordCount;
+    const bool hasWordCounts = totalWords > 0;
+    if (!hasWordCounts)
+        totalWords = static_cast<quint64>(wordCounts.size());
+
+    QVector<double> expectedFrames(numSplits);
+    quint64 wordsBefore = 0;
+    for (int split = 0; split < numSplits; split++) {
+        wordsBefore += hasWordCounts ? wordCounts[split] : 1;
+        expectedFrames[split] =
+            static_cast<double>(getNumFrames()) * wordsBefore / totalWords;
+    }
+
+    auto getCost = [&](int split, int silence) {
+        const Silence &pause = silences[silence];
+        const double distance =
+            std::abs(pause.getMiddleFrame() - expectedFrames[split]) /
+            sampleRate;
+        const double length = qMin(
+            static_cast<double>(pause.getLength()) / sampleRate,
+            longPauseSeconds);
+        return distance - pauseWeight * length;
+    };
+
+    // The cheapest choice for each pause only depends on the best choice
+    // before it for the previous split. Choices are kept by their place in
+    // the band.
+    QVector<double> previousCosts(bandWidth, 0);
+    QVector<double> costs(bandWidth);
+    QVector<int> choices(static_cast<int>(numChoices), -1);
+
+    for (int split = 0; split < numSplits; split++) {
+        double bestPreviousCost = split == 0 ? 0 : previousCosts[0];
+        int bestPrevious = split == 0 ? -1 : 0;
+
+        for (int band = 0; band < bandWidth; band++) {
+            if (split > 0 && previousCosts[band] < bestPreviousCost) {
+                bestPreviousCost = previousCosts[band];
+                bestPrevious = band;
+            }
+
+            costs[band] = bestPreviousCost + getCost(split, split + band);
+            choices[split * bandWidth + band] = bestPrevious;
+        }
+
+        std::swap(previousCosts, costs);
+    }
+
+    int chosen = static_cast<int>(
+        std::min_element(previousCosts.constBegin(), previousCosts.constEnd()) -
+        previousCosts.constBegin());
+
+    QVector<qint64> splitFrames(numSplits);
+    for (int split = numSplits - 1; split >= 0; split--) {
+        splitFrames[split] = silences[split + chosen].getMiddleFrame();
+        chosen = choices[split * bandWidth + chosen];
+    }
+
+    return splitFrames;
+}
+
+// Copies the recording out into one file per part in a single pass, with
+// each part ending at the next split frame. Nothing is left behind when a
+// part could not be written.
+bool RecordingSplitter::writeParts(const QVector<qint64> &splitFrames,
+                                   const QStringList &partPaths) {
+    if (partPaths.size() != splitFrames.size() + 1 ||
+        !recordingFile.seek(dataStart)) {
+        errorString = "Could not read the recording.";
+        return false;
+    }
+
+    QVector<qint64> partEnds = splitFrames;
+    partEnds.append(getNumFrames());
+
+    qint64 partStart = 0;
+    for (int part = 0; part < partPaths.size(); part++) {
+        qint64 partBytes = (partEnds[part] - partStart) * blockAlign;
+
+        QFile partFile(partPaths[part]);
+        bool isWritten = partEnds[part] >= partStart &&
+                         partFile.open(QIODevice::WriteOnly) &&
+                         partFile.write(createWaveHeader(static_cast<quint32>(
+                             partBytes))) == waveHeaderSize;
+
+        while (isWritten && partBytes > 0) {
+            const QByteArray chunk =
+                recordingFile.read(qMin(partBytes, chunkLimit));
+            isWritten =
+                !chunk.isEmpty() && partFile.write(chunk) == chunk.size();
+            partBytes -= chunk.size();
+        }
+
+        partFile.close();
+        if (!isWritten) {
+            for (int writtenPart = 0; writtenPart <= part; writtenPart++)
+                QFile::remove(partPaths[writtenPart]);
+
+            errorString = "Could not write " + partPaths[part] + ".";
+            return false;
+        }
+
+        partStart = partEnds[part];
+    }
+
+    return true;
+}
+
+const QVector<RecordingSplitter::Silence> &
+RecordingSplitter::getSilences() const {
+    return silences;
+}
+
+qint64 RecordingSplitter::getNumFrames() const {
+    return blockAlign == 0 ? 0 : dataSize / blockAlign;
+}
+
+int RecordingSplitter::getSampleRate() const {
+    return static_cast<int>(sampleRate);
+}
+
+qint64 RecordingSplitter::getDurationMs() const {
+    return sampleRate == 0 ? 0 : getNumFrames() * 1000 / sampleRate;
+}
+
+QString RecordingSplitter::getErrorString() const { return errorString; }
+
+bool RecordingSplitter::readHeader() {
+    WaveHeader header;
+    if (!header.read(recordingFile, recordingFile.size()) ||
+        header.dataStart == 0)
+        return false;
+
+    formatTag = header.formatTag;
+    channelCount = header.channelCount;
+    sampleRate = header.sampleRate;
+    blockAlign = header.blockAlign;
+    bitsPerSample = header.bitsPerSample;
+    dataStart = header.dataStart;
+    dataSize = header.dataSize;
+
+    const bool isInteger = formatTag == 1 &&
+                           (bitsPerSample == 8 || bitsPerSample == 16 ||
+                            bitsPerSample == 24 || bitsPerSample == 32);
+    const bool isFloat = formatTag == 3 && bitsPerSample == 32;
+    if ((!isInteger && !isFloat) || channelCount == 0 || sampleRate == 0 ||
+        blockAlign != channelCount * bitsPerSample / 8) {
+        errorString = "Only uncompressed WAV recordings can be split.";
+        return false;
+    }
+
+    return true;
+}
+
+// Turns little-endian samples into floats between -1 and 1.
+void RecordingSplitter::toSamples(const char *data, int numSamples,
+                                  QVector<float> &samples) const {
+    samples.resize(numSamples);
+    float *output = samples.data();
+    const uchar *input = reinterpret_cast<const uchar *>(data);
+
+    if (formatTag == 3) {
+        for (int i = 0; i < numSamples; i++) {
+            const quint32 bits = qFromLittleEndian<quint32>(input + i * 4);
+            memcpy(&output[i], &bits, sizeof(float));
+        }
+        return;
+    }
+
+    switch (bitsPerSample) {
+    case 8:
+        for (int i = 0; i < numSamples; i++)
+            output[i] = (input[i] - 128) / 128.0f;
+        break;
+    case 16:
+        for (int i = 0; i < numSamples; i++)
+            output[i] = qFromLittleEndian<qint16>(input + i * 2) / 32768.0f;
+        break;
+    case 24:
+        for (int i = 0; i < numSamples; i++) {
+            const uchar *sample = input + i * 3;
+            const qint32 value = static_cast<qint32>(
+                                     (quint32(sample[0]) << 8) |
+                                     (quint32(sample[1]) << 16) |
+                                     (quint32(sample[2]) << 24)) >>
+                                 8;
+            output[i] = value / 8388608.0f;
+        }
+        break;
+    default:
+        for (int i = 0; i < numSamples; i++)
+            output[i] =
+                qFromLittleEndian<qint32>(input + i * 4) / 2147483648.0f;
+        break;
+    }
+}
+
+QByteArray RecordingSplitter::createWaveHeader(quint32 partDataSize) const {
+    QByteArray header;
+    QDataStream headerOutput(&header, QIODevice::WriteOnly);
+    headerOutput.setByteOrder(QDataStream::LittleEndian);
+
+    headerOutput.writeRawData("RIFF", 4);
+    headerOutput << quint32(partDataSize + waveHeaderSize - 8);
+    headerOutput.writeRawData("WAVE", 4);
+
+    headerOutput.writeRawData("fmt ", 4);
+    headerOutput << quint32(16) << formatTag << channelCount << sampleRate
+                 << quint32(sampleRate * blockAlign) << blockAlign
+                 << bitsPerSample;
+
+    headerOutput.writeRawData("data", 4);
+    headerOutput << partDataSize;
+
+    return header;
+}
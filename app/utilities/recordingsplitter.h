@@ -0,0 +1,57 @@
+#ifndef RECORDINGSPLITTER_H
+#define RECORDINGSPLITTER_H
+
+#include <QFile>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// Cuts one long WAV recording into parts at its pauses. The recording is
+// only ever streamed through in chunks: once to measure how loud each
+// 10ms frame is, and once more to copy the audio out into the parts.
+class RecordingSplitter {
+public:
+    struct Silence {
+        qint64 startFrame = 0;
+        qint64 endFrame = 0;
+
+        qint64 getMiddleFrame() const { return (startFrame + endFrame) / 2; }
+        qint64 getLength() const { return endFrame - startFrame; }
+    };
+
+    // The most paragraphs one recording is split into at once.
+    static const int maxParts = 1000;
+
+    explicit RecordingSplitter(const QString &);
+
+    bool open();
+    bool detectSilences(int = 250);
+    QVector<qint64> proposeSplits(const QVector<quint32> &) const;
+    bool writeParts(const QVector<qint64> &, const QStringList &);
+
+    const QVector<Silence> &getSilences() const;
+    qint64 getNumFrames() const;
+    int getSampleRate() const;
+    qint64 getDurationMs() const;
+    QString getErrorString() const;
+
+private:
+    QFile recordingFile;
+    QString errorString;
+
+    quint16 formatTag = 0;
+    quint16 channelCount = 0;
+    quint32 sampleRate = 0;
+    quint16 blockAlign = 0;
+    quint16 bitsPerSample = 0;
+    qint64 dataStart = 0;
+    qint64 dataSize = 0;
+
+    QVector<Silence> silences;
+
+    bool readHeader();
+    void toSamples(const char *, int, QVector<float> &) const;
+    QByteArray createWaveHeader(quint32) const;
+};
+
+#endif // RECORDINGSPLITTER_H
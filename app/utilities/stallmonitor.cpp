@@ -0,0 +1,55 @@
+#include "stallmonitor.h"
+
+// The upper bounds of every bucket but the last, in milliseconds. A stall
+// under a frame at 60 Hz goes unnoticed.
+static const QVector<qint64> bucketLimitsMs = {16, 50, 100, 250, 1000};
+
+StallMonitor::StallMonitor(QObject *parent)
+    : QObject(parent), histogram(bucketLimitsMs.size() + 1, 0) {
+    checkTimer = new QTimer(this);
+    checkTimer->setTimerType(Qt::PreciseTimer);
+    checkTimer->setInterval(intervalMs);
+
+    connect(checkTimer, &QTimer::timeout, this, &StallMonitor::onTimeout);
+}
+
+void StallMonitor::start() {
+    sinceCheck.start();
+    checkTimer->start();
+}
+
+void StallMonitor::stop() { checkTimer->stop(); }
+
+void StallMonitor::addStall(qint64 stallMs) {
+    histogram[getBucket(stallMs)]++;
+    longestStallMs = qMax(longestStallMs, stallMs);
+}
+
+QVector<qint64> StallMonitor::getHistogram() const { return histogram; }
+
+qint64 StallMonitor::getLongestStallMs() const { return longestStallMs; }
+
+QStringList StallMonitor::getBucketNames() {
+    QStringList bucketNames;
+    qint64 lowerLimitMs = 0;
+    for (qint64 upperLimitMs : bucketLimitsMs) {
+        bucketNames.append(
+            QString("%1-%2 ms").arg(lowerLimitMs).arg(upperLimitMs));
+        lowerLimitMs = upperLimitMs;
+    }
+    bucketNames.append(QString("%1+ ms").arg(lowerLimitMs));
+
+    return bucketNames;
+}
+
+int StallMonitor::getBucket(qint64 stallMs) {
+    int bucket = 0;
+    while (bucket < bucketLimitsMs.size() && stallMs >= bucketLimitsMs[bucket])
+        bucket++;
+
+    return bucket;
+}
+
+void StallMonitor::onTimeout() {
+    addStall(qMax<qint64>(0, sinceCheck.restart() - intervalMs));
+}
@@ -0,0 +1,42 @@
+#ifndef STALLMONITOR_H
+#define STALLMONITOR_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QStringList>
+#include <QTimer>
+#include <QVector>
+
+// Measures how late a steady timer fires on the thread it lives on, which is
+// how long that thread's event loop was busy with something else. Lateness
+// is counted into buckets, so long sessions can be checked for stalls
+// without keeping every one of them.
+class StallMonitor : public QObject {
+    Q_OBJECT
+
+public:
+    // How often the event loop is checked on.
+    static const int intervalMs = 50;
+
+    explicit StallMonitor(QObject *parent = nullptr);
+
+    void start();
+    void stop();
+    void addStall(qint64);
+
+    QVector<qint64> getHistogram() const;
+    qint64 getLongestStallMs() const;
+    static QStringList getBucketNames();
+    static int getBucket(qint64);
+
+private slots:
+    void onTimeout();
+
+private:
+    QTimer *checkTimer = nullptr;
+    QElapsedTimer sinceCheck;
+    QVector<qint64> histogram;
+    qint64 longestStallMs = 0;
+};
+
+#endif // STALLMONITOR_H
@@ -0,0 +1,132 @@
+#include "takebuffer.h"
+
+#include <QDataStream>
+
+static const int waveHeaderSize = 44;
+
+TakeBuffer::TakeBuffer(qint64 byteLimit) : byteLimit(byteLimit) {}
+
+void TakeBuffer::start(const QUrl &location) {
+    clear();
+
+    takeLocation = location;
+    isRecording = true;
+    waveData.resize(waveHeaderSize);
+}
+
+void TakeBuffer::append(const QAudioBuffer &buffer) {
+    if (!isRecording || isDiscarded || !buffer.isValid())
+        return;
+
+    if (!takeFormat.isValid()) {
+        if (!isWaveCompatible(buffer.format())) {
+            isDiscarded = true;
+            return;
+        }
+
+        takeFormat = buffer.format();
+    } else if (buffer.format() != takeFormat) {
+        isDiscarded = true;
+        return;
+    }
+
+    // Takes that would not fit are played back from disk instead.
+    if (waveData.size() + buffer.byteCount() > byteLimit) {
+        isDiscarded = true;
+        waveData.clear();
+        waveData.squeeze();
+        return;
+    }
+
+    waveData.append(static_cast<const char *>(buffer.constData()),
+                    buffer.byteCount());
+}
+
+void TakeBuffer::finish() {
+    if (!isRecording)
+        return;
+
+    isRecording = false;
+    if (isDiscarded || !takeFormat.isValid() ||
+        waveData.size() <= waveHeaderSize)
+        return;
+
+    const QByteArray header =
+        createWaveHeader(static_cast<quint32>(waveData.size() - waveHeaderSize));
+    waveData.replace(0, waveHeaderSize, header);
+
+    waveDevice.setBuffer(&waveData);
+    waveDevice.open(QIODevice::ReadOnly);
+    isFinished = true;
+}
+
+void TakeBuffer::clear() {
+    if (waveDevice.isOpen())
+        waveDevice.close();
+
+    waveDevice.setBuffer(nullptr);
+    waveData.clear();
+    takeLocation.clear();
+    takeFormat = QAudioFormat();
+
+    isRecording = false;
+    isFinished = false;
+    isDiscarded = false;
+}
+
+bool TakeBuffer::isAvailableFor(const QUrl &location) const {
+    return isFinished && !isDiscarded && location == takeLocation;
+}
+
+qint64 TakeBuffer::getMemoryUsage() const { return waveData.capacity(); }
+
+QIODevice *TakeBuffer::device() {
+    if (!isFinished)
+        return nullptr;
+
+    waveDevice.seek(0);
+    return &waveDevice;
+}
+
+bool TakeBuffer::isWaveCompatible(const QAudioFormat &format) const {
+    if (!format.isValid() || format.byteOrder() != QAudioFormat::LittleEndian)
+        return false;
+
+    switch (format.sampleType()) {
+    case QAudioFormat::UnSignedInt:
+        return format.sampleSize() == 8;
+    case QAudioFormat::SignedInt:
+        return format.sampleSize() >= 16;
+    case QAudioFormat::Float:
+        return format.sampleSize() == 32;
+    default:
+        return false;
+    }
+}
+
+QByteArray TakeBuffer::createWaveHeader(quint32 dataSize) const {
+    const quint16 formatTag =
+        takeFormat.sampleType() == QAudioFormat::Float ? 3 : 1;
+    const quint16 channels = static_cast<quint16>(takeFormat.channelCount());
+    const quint32 sampleRate = static_cast<quint32>(takeFormat.sampleRate());
+    const quint16 blockAlign =
+        static_cast<quint16>(channels * takeFormat.sampleSize() / 8);
+
+    QByteArray header;
+    QDataStream headerOutput(&header, QIODevice::WriteOnly);
+    headerOutput.setByteOrder(QDataStream::LittleEndian);
+
+    headerOutput.writeRawData("RIFF", 4);
+    headerOutput << quint32(dataSize + waveHeaderSize - 8);
+    headerOutput.writeRawData("WAVE", 4);
+
+    headerOutput.writeRawData("fmt ", 4);
+    headerOutput << quint32(16) << formatTag << channels << sampleRate
+                 << quint32(sampleRate * blockAlign) << blockAlign
+                 << quint16(takeFormat.sampleSize());
+
+    headerOutput.writeRawData("data", 4);
+    headerOutput << dataSize;
+
+    return header;
+}
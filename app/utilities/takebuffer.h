@@ -0,0 +1,40 @@
+#ifndef TAKEBUFFER_H
+#define TAKEBUFFER_H
+
+#include <QAudioBuffer>
+#include <QAudioFormat>
+#include <QBuffer>
+#include <QByteArray>
+#include <QUrl>
+
+// Keeps the PCM of the most recent take in memory so it can be played back
+// right after recording without waiting for the encoded file to be probed.
+class TakeBuffer {
+public:
+    explicit TakeBuffer(qint64 byteLimit = 64 * 1024 * 1024);
+
+    void start(const QUrl &);
+    void append(const QAudioBuffer &);
+    void finish();
+    void clear();
+
+    bool isAvailableFor(const QUrl &) const;
+    QIODevice *device();
+    qint64 getMemoryUsage() const;
+
+private:
+    qint64 byteLimit = 0;
+    QUrl takeLocation;
+    QAudioFormat takeFormat;
+    QByteArray waveData;
+    QBuffer waveDevice;
+
+    bool isRecording = false;
+    bool isFinished = false;
+    bool isDiscarded = false;
+
+    bool isWaveCompatible(const QAudioFormat &) const;
+    QByteArray createWaveHeader(quint32) const;
+};
+
+#endif // TAKEBUFFER_H
@@ -0,0 +1,221 @@
+#include "tracer.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMutex>
+#include <QTextStream>
+#include <QThread>
+#include <memory>
+#include <vector>
+
+struct TraceEvent {
+    const char *name;
+    qint64 startNs;
+    qint64 durationNs;
+};
+
+// Only its own thread adds events, and it publishes how many there are after
+// writing each one, so a trace can be written while threads keep running.
+// The buffer is emptied by its thread too, when it records the first event
+// since tracing was turned on again, so that each trace has room for as
+// many events as the first.
+struct ThreadBuffer {
+    int threadId = 0;
+    QString threadName;
+    std::unique_ptr<TraceEvent[]> events;
+    std::atomic<int> numEvents{0};
+    std::atomic<int> numDropped{0};
+    std::atomic<int> traceNumber{0};
+};
+
+// Buffers outlive their threads, so the events of finished workers are still
+// there to be written.
+static QMutex threadBuffersMutex;
+static std::vector<std::unique_ptr<ThreadBuffer>> threadBuffers;
+static thread_local ThreadBuffer *threadBuffer = nullptr;
+
+static std::atomic<qint64> enabledSinceNs{0};
+static std::atomic<int> traceNumber{0};
+
+static QElapsedTimer &getClock() {
+    static QElapsedTimer clock = []() {
+        QElapsedTimer startedClock;
+        startedClock.start();
+        return startedClock;
+    }();
+
+    return clock;
+}
+
+static ThreadBuffer *getThreadBuffer() {
+    if (threadBuffer != nullptr)
+        return threadBuffer;
+
+    std::unique_ptr<ThreadBuffer> buffer(new ThreadBuffer);
+    buffer->events.reset(new TraceEvent[Tracer::eventsPerThread]);
+
+    QThread *thread = QThread::currentThread();
+    if (QCoreApplication::instance() != nullptr &&
+        thread == QCoreApplication::instance()->thread())
+        buffer->threadName = "Main";
+    else if (!thread->objectName().isEmpty())
+        buffer->threadName = thread->objectName();
+
+    QMutexLocker locker(&threadBuffersMutex);
+    buffer->threadId = static_cast<int>(threadBuffers.size()) + 1;
+    if (buffer->threadName.isEmpty())
+        buffer->threadName = QString("Worker %1").arg(buffer->threadId);
+
+    threadBuffer = buffer.get();
+    threadBuffers.push_back(std::move(buffer));
+
+    return threadBuffer;
+}
+
+static QString escapeJson(const QString &text) {
+    QString escaped;
+    for (const QChar &letter : text) {
+        if (letter == '"' || letter == '\\')
+            escaped += '\\';
+        if (letter.unicode() < 0x20)
+            escaped +=
+                QString("\\u%1").arg(letter.unicode(), 4, 16, QChar('0'));
+        else
+            escaped += letter;
+    }
+
+    return escaped;
+}
+
+std::atomic<bool> Tracer::enabled{false};
+
+// A trace only holds what happened since tracing was last turned on.
+void Tracer::setEnabled(bool isEnabled) {
+    if (isEnabled && !enabled.load()) {
+        enabledSinceNs.store(now());
+        traceNumber.fetch_add(1);
+    }
+
+    enabled.store(isEnabled);
+}
+
+qint64 Tracer::now() { return getClock().nsecsElapsed(); }
+
+void Tracer::record(const char *name, qint64 startNs, qint64 endNs) {
+    ThreadBuffer *buffer = getThreadBuffer();
+
+    const int currentTrace = traceNumber.load(std::memory_order_relaxed);
+    if (buffer->traceNumber.load(std::memory_order_relaxed) != currentTrace) {
+        buffer->numEvents.store(0, std::memory_order_relaxed);
+        buffer->numDropped.store(0, std::memory_order_relaxed);
+        buffer->traceNumber.store(currentTrace, std::memory_order_release);
+    }
+
+    const int numEvents = buffer->numEvents.load(std::memory_order_relaxed);
+    if (numEvents == eventsPerThread) {
+        buffer->numDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    buffer->events[numEvents] = {name, startNs, endNs - startNs};
+    buffer->numEvents.store(numEvents + 1, std::memory_order_release);
+}
+
+// For events that end somewhere other than where they start, such as a
+// recording that starts when its first audio arrives. Returns -1 when tracing
+// is off, which end() then ignores.
+qint64 Tracer::begin() { return isEnabled() ? now() : -1; }
+
+void Tracer::end(const char *name, qint64 &startNs) {
+    if (startNs < 0)
+        return;
+
+    record(name, startNs, now());
+    startNs = -1;
+}
+
+// Buffers that were not emptied since tracing was turned on only hold the
+// events of earlier traces.
+static bool isInTrace(const ThreadBuffer &buffer) {
+    return buffer.traceNumber.load(std::memory_order_acquire) ==
+           traceNumber.load();
+}
+
+int Tracer::getNumEvents() {
+    const qint64 sinceNs = enabledSinceNs.load();
+    int numEvents = 0;
+
+    QMutexLocker locker(&threadBuffersMutex);
+    for (auto &buffer : threadBuffers) {
+        if (!isInTrace(*buffer))
+            continue;
+
+        const int numBuffered =
+            buffer->numEvents.load(std::memory_order_acquire);
+        for (int event = 0; event < numBuffered; event++) {
+            if (buffer->events[event].startNs >= sinceNs)
+                numEvents++;
+        }
+    }
+
+    return numEvents;
+}
+
+// Events are complete ("X") events in microseconds, one process and a track
+// for every thread that recorded any.
+bool Tracer::writeChromeTrace(const QString &tracePath) {
+    QFile traceFile(tracePath);
+    if (!traceFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+
+    QTextStream traceOutput(&traceFile);
+    traceOutput.setCodec("UTF-8");
+
+    const qint64 pid = QCoreApplication::applicationPid();
+    const qint64 sinceNs = enabledSinceNs.load();
+    const QString eventFormat =
+        ",\n{\"name\":\"%1\",\"cat\":\"narrative-director\",\"ph\":\"X\","
+        "\"ts\":%2,\"dur\":%3,\"pid\":%4,\"tid\":%5}";
+    int numDropped = 0;
+
+    traceOutput << "{\"traceEvents\":[\n"
+                << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << pid
+                << ",\"tid\":0,\"args\":{\"name\":\""
+                << escapeJson(QCoreApplication::applicationName()) << "\"}}";
+
+    QMutexLocker locker(&threadBuffersMutex);
+    for (auto &buffer : threadBuffers) {
+        if (!isInTrace(*buffer))
+            continue;
+
+        traceOutput << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":"
+                    << pid << ",\"tid\":" << buffer->threadId
+                    << ",\"args\":{\"name\":\""
+                    << escapeJson(buffer->threadName) << "\"}}";
+
+        const int numBuffered =
+            buffer->numEvents.load(std::memory_order_acquire);
+        for (int event = 0; event < numBuffered; event++) {
+            const TraceEvent &traceEvent = buffer->events[event];
+            if (traceEvent.startNs < sinceNs)
+                continue;
+
+            traceOutput << eventFormat
+                               .arg(escapeJson(traceEvent.name))
+                               .arg((traceEvent.startNs - sinceNs) / 1000.0,
+                                    0, 'f', 3)
+                               .arg(traceEvent.durationNs / 1000.0, 0, 'f', 3)
+                               .arg(pid)
+                               .arg(buffer->threadId);
+        }
+
+        numDropped += buffer->numDropped.load(std::memory_order_relaxed);
+    }
+
+    traceOutput << "\n],\n\"displayTimeUnit\":\"ms\",\"otherData\":"
+                << "{\"droppedEvents\":" << numDropped << "}}\n";
+    traceOutput.flush();
+
+    return traceOutput.status() == QTextStream::Ok;
+}
@@ -0,0 +1,83 @@
+#include "waveheader.h"
+
+#include <QDataStream>
+#include <cstring>
+
+// Reads from the start of the device, whose file is the given size even when
+// the device only holds its start. Returns whether the format was found
+// before the samples.
+bool WaveHeader::read(QIODevice &waveDevice, qint64 fileSize) {
+    QDataStream waveInput(&waveDevice);
+    waveInput.setByteOrder(QDataStream::LittleEndian);
+
+    char chunkId[4];
+    quint32 chunkSize = 0;
+    if (waveInput.readRawData(chunkId, 4) != 4 ||
+        memcmp(chunkId, "RIFF", 4) != 0)
+        return false;
+    waveInput >> chunkSize;
+    if (waveInput.readRawData(chunkId, 4) != 4 ||
+        memcmp(chunkId, "WAVE", 4) != 0)
+        return false;
+
+    bool hasFormat = false;
+    while (waveInput.readRawData(chunkId, 4) == 4) {
+        waveInput >> chunkSize;
+        if (waveInput.status() != QDataStream::Ok)
+            return false;
+
+        const qint64 chunkStart = waveDevice.pos();
+
+        if (memcmp(chunkId, "fmt ", 4) == 0) {
+            waveInput >> formatTag >> channelCount >> sampleRate >> byteRate >>
+                blockAlign >> bitsPerSample;
+
+            // WAVE_FORMAT_EXTENSIBLE keeps the real tag in its sub-format.
+            if (formatTag == 0xFFFE && chunkSize >= 26) {
+                quint16 extensionSize = 0;
+                quint16 validBits = 0;
+                quint32 channelMask = 0;
+                waveInput >> extensionSize >> validBits >> channelMask >>
+                    formatTag;
+            }
+
+            hasFormat = true;
+        } else if (memcmp(chunkId, "data", 4) == 0) {
+            if (!hasFormat)
+                return false;
+
+            // Recorders that were interrupted leave the size unset.
+            dataStart = chunkStart;
+            dataSize = chunkSize;
+            if (chunkSize == 0 || dataStart + dataSize > fileSize)
+                dataSize = fileSize - dataStart;
+            break;
+        }
+
+        if (!waveDevice.seek(chunkStart + chunkSize + (chunkSize & 1)))
+            return false;
+    }
+
+    return hasFormat;
+}
+
+// The plain 44 byte header of a file whose format chunk holds these fields
+// and whose samples, dataSize bytes of them, follow right after it.
+QByteArray WaveHeader::write() const {
+    QByteArray header;
+    QDataStream headerOutput(&header, QIODevice::WriteOnly);
+    headerOutput.setByteOrder(QDataStream::LittleEndian);
+
+    headerOutput.writeRawData("RIFF", 4);
+    headerOutput << quint32(36 + dataSize);
+    headerOutput.writeRawData("WAVE", 4);
+
+    headerOutput.writeRawData("fmt ", 4);
+    headerOutput << quint32(16) << formatTag << channelCount << sampleRate
+                 << byteRate << blockAlign << bitsPerSample;
+
+    headerOutput.writeRawData("data", 4);
+    headerOutput << quint32(dataSize);
+
+    return header;
+}
@@ -0,0 +1,24 @@
+#ifndef WAVEHEADER_H
+#define WAVEHEADER_H
+
+#include <QIODevice>
+
+// The format of a WAV file and where its samples lie, read from the chunks
+// at its start. Chunks other than the format and the samples are skipped.
+struct WaveHeader {
+    quint16 formatTag = 0;
+    quint16 channelCount = 0;
+    quint32 sampleRate = 0;
+    quint32 byteRate = 0;
+    quint16 blockAlign = 0;
+    quint16 bitsPerSample = 0;
+
+    // Both are zero when the device ends before the samples start.
+    qint64 dataStart = 0;
+    qint64 dataSize = 0;
+
+    bool read(QIODevice &, qint64);
+    QByteArray write() const;
+};
+
+#endif // WAVEHEADER_H
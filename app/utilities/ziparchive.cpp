@@ -0,0 +1,261 @@
+#include "ziparchive.h"
+
+#include <zlib.h>
+
+static const quint32 endOfDirectorySignature = 0x06054b50;
+static const quint32 directorySignature = 0x02014b50;
+static const quint32 localHeaderSignature = 0x04034b50;
+static const int endOfDirectorySize = 22;
+static const int directoryHeaderSize = 46;
+static const int localHeaderSize = 30;
+static const int maxCommentSize = 0xffff;
+
+static quint16 readU16(const char *data) {
+    const uchar *bytes = reinterpret_cast<const uchar *>(data);
+    return static_cast<quint16>(bytes[0] | bytes[1] << 8);
+}
+
+static quint32 readU32(const char *data) {
+    const uchar *bytes = reinterpret_cast<const uchar *>(data);
+    return static_cast<quint32>(bytes[0]) |
+           static_cast<quint32>(bytes[1]) << 8 |
+           static_cast<quint32>(bytes[2]) << 16 |
+           static_cast<quint32>(bytes[3]) << 24;
+}
+
+// The central directory is found from the record that ends the archive,
+// which only an archive comment can push away from the end.
+bool ZipArchive::open(QIODevice *archive) {
+    this->archive = archive;
+    entries.clear();
+
+    const qint64 tailSize =
+        qMin<qint64>(archive->size(), endOfDirectorySize + maxCommentSize);
+    if (tailSize < endOfDirectorySize ||
+        !archive->seek(archive->size() - tailSize))
+        return false;
+
+    const QByteArray tail = archive->read(tailSize);
+    int endOfDirectory = tail.size() - endOfDirectorySize;
+    while (endOfDirectory >= 0 &&
+           readU32(tail.constData() + endOfDirectory) !=
+               endOfDirectorySignature)
+        endOfDirectory--;
+    if (endOfDirectory < 0)
+        return false;
+
+    const char *record = tail.constData() + endOfDirectory;
+    const int numEntries = readU16(record + 10);
+    const qint64 directorySize = readU32(record + 12);
+    const qint64 directoryOffset = readU32(record + 16);
+    if (!archive->seek(directoryOffset))
+        return false;
+
+    const QByteArray directory = archive->read(directorySize);
+    if (directory.size() != directorySize)
+        return false;
+
+    int offset = 0;
+    for (int i = 0; i < numEntries; i++) {
+        if (offset + directoryHeaderSize > directory.size())
+            return false;
+
+        const char *header = directory.constData() + offset;
+        if (readU32(header) != directorySignature)
+            return false;
+
+        const int nameSize = readU16(header + 28);
+        const int extraSize = readU16(header + 30);
+        const int commentSize = readU16(header + 32);
+        if (offset + directoryHeaderSize + nameSize > directory.size())
+            return false;
+
+        const QByteArray name(header + directoryHeaderSize, nameSize);
+        const bool isUtf8Name = readU16(header + 8) & 0x0800;
+
+        Entry entry;
+        entry.name = isUtf8Name ? QString::fromUtf8(name)
+                                : QString::fromLatin1(name);
+        entry.method = readU16(header + 10);
+        entry.compressedSize = readU32(header + 20);
+        entry.size = readU32(header + 24);
+        entry.headerOffset = readU32(header + 42);
+        entries.append(entry);
+
+        offset += directoryHeaderSize + nameSize + extraSize + commentSize;
+    }
+
+    return true;
+}
+
+QIODevice *ZipArchive::getDevice() const { return archive; }
+
+const QVector<ZipArchive::Entry> &ZipArchive::getEntries() const {
+    return entries;
+}
+
+int ZipArchive::findEntry(const QString &name) const {
+    for (int entry = 0; entry < entries.size(); entry++) {
+        if (entries[entry].name == name)
+            return entry;
+    }
+
+    return -1;
+}
+
+// For the small entries that describe the rest, such as an EPUB's package
+// document. Entries bigger than the limit given are not read, whatever size
+// the archive claims they have.
+QByteArray ZipArchive::readEntry(int entry, qint64 maxSize) const {
+    if (entry < 0 || entry >= entries.size() || entries[entry].size > maxSize)
+        return QByteArray();
+
+    ZipEntryReader entryReader;
+    if (!entryReader.open(*this, entry))
+        return QByteArray();
+
+    QByteArray data;
+    while (!entryReader.atEnd() && !entryReader.hasError()) {
+        data += entryReader.read(ZipEntryReader::chunkSize);
+        if (data.size() > maxSize)
+            return QByteArray();
+    }
+
+    return entryReader.hasError() ? QByteArray() : data;
+}
+
+struct ZipEntryReader::Inflater {
+    z_stream stream;
+};
+
+ZipEntryReader::ZipEntryReader() {}
+
+ZipEntryReader::~ZipEntryReader() { close(); }
+
+bool ZipEntryReader::open(const ZipArchive &zipArchive, int entry) {
+    close();
+
+    const QVector<ZipArchive::Entry> &entries = zipArchive.getEntries();
+    if (entry < 0 || entry >= entries.size())
+        return false;
+
+    const ZipArchive::Entry &zipEntry = entries[entry];
+    if (zipEntry.method != ZipArchive::storedMethod &&
+        zipEntry.method != ZipArchive::deflatedMethod)
+        return false;
+
+    archive = zipArchive.getDevice();
+    if (!archive->seek(zipEntry.headerOffset))
+        return false;
+
+    const QByteArray header = archive->read(localHeaderSize);
+    if (header.size() != localHeaderSize ||
+        readU32(header.constData()) != localHeaderSignature)
+        return false;
+
+    dataOffset = zipEntry.headerOffset + localHeaderSize +
+                 readU16(header.constData() + 26) +
+                 readU16(header.constData() + 28);
+    compressedSize = zipEntry.compressedSize;
+    size = zipEntry.size;
+    isDeflated = zipEntry.method == ZipArchive::deflatedMethod;
+    if (!isDeflated)
+        return true;
+
+    // Entries hold raw deflate data, without zlib's header or checksum.
+    inflater.reset(new Inflater);
+    inflater->stream = z_stream();
+    if (inflateInit2(&inflater->stream, -MAX_WBITS) != Z_OK) {
+        inflater.reset();
+        return false;
+    }
+
+    return true;
+}
+
+void ZipEntryReader::close() {
+    if (inflater)
+        inflateEnd(&inflater->stream);
+
+    inflater.reset();
+    input.clear();
+    archive = nullptr;
+    compressedRead = 0;
+    position = 0;
+    isDeflated = false;
+    isStreamEnded = false;
+    isBroken = false;
+}
+
+// Returns up to as many bytes as asked for, and none at the end of the entry
+// or once it turned out to be broken.
+QByteArray ZipEntryReader::read(int maxSize) {
+    QByteArray data;
+    if (archive == nullptr || atEnd() || isBroken || maxSize <= 0)
+        return data;
+
+    if (!isDeflated) {
+        if (archive->seek(dataOffset + position))
+            data = archive->read(qMin<qint64>(maxSize, size - position));
+        isBroken = data.isEmpty();
+        position += data.size();
+        return data;
+    }
+
+    data.resize(maxSize);
+    z_stream &stream = inflater->stream;
+    stream.next_out = reinterpret_cast<Bytef *>(data.data());
+    stream.avail_out = static_cast<uInt>(maxSize);
+    while (stream.avail_out > 0 && !isStreamEnded) {
+        if (stream.avail_in == 0) {
+            if (compressedRead == compressedSize ||
+                !archive->seek(dataOffset + compressedRead)) {
+                isBroken = true;
+                break;
+            }
+
+            input = archive->read(
+                qMin<qint64>(chunkSize, compressedSize - compressedRead));
+            if (input.isEmpty()) {
+                isBroken = true;
+                break;
+            }
+
+            compressedRead += input.size();
+            stream.next_in = reinterpret_cast<Bytef *>(input.data());
+            stream.avail_in = static_cast<uInt>(input.size());
+        }
+
+        const int status = inflate(&stream, Z_NO_FLUSH);
+        if (status == Z_STREAM_END) {
+            isStreamEnded = true;
+        } else if (status != Z_OK) {
+            isBroken = true;
+            break;
+        }
+    }
+
+    data.resize(maxSize - static_cast<int>(stream.avail_out));
+    position += data.size();
+    return data;
+}
+
+// Deflated entries can only be skipped through by inflating them.
+bool ZipEntryReader::skip(qint64 numBytes) {
+    if (!isDeflated) {
+        position = qMin(size, position + numBytes);
+        return true;
+    }
+
+    while (numBytes > 0 && !atEnd() && !isBroken)
+        numBytes -= read(static_cast<int>(qMin<qint64>(numBytes, chunkSize)))
+                        .size();
+
+    return numBytes == 0;
+}
+
+bool ZipEntryReader::atEnd() const {
+    return isDeflated ? isStreamEnded : position >= size;
+}
+
+bool ZipEntryReader::hasError() const { return isBroken; }
@@ -0,0 +1,70 @@
+#ifndef ZIPARCHIVE_H
+#define ZIPARCHIVE_H
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QString>
+#include <QVector>
+#include <memory>
+
+// Finds the entries of a ZIP archive, such as an EPUB, from its central
+// directory. Entries are read straight out of the archive with a
+// ZipEntryReader, so none of them has to be extracted first.
+class ZipArchive {
+public:
+    struct Entry {
+        QString name;
+        quint16 method = 0;
+        qint64 compressedSize = 0;
+        qint64 size = 0;
+        qint64 headerOffset = 0;
+    };
+
+    static const quint16 storedMethod = 0;
+    static const quint16 deflatedMethod = 8;
+
+    bool open(QIODevice *);
+    QIODevice *getDevice() const;
+    const QVector<Entry> &getEntries() const;
+    int findEntry(const QString &) const;
+    QByteArray readEntry(int, qint64) const;
+
+private:
+    QIODevice *archive = nullptr;
+    QVector<Entry> entries;
+};
+
+// Reads one entry of an archive a piece at a time, inflating it as it goes
+// when it was deflated. Only stored and deflated entries, which are all an
+// EPUB may hold, can be read.
+class ZipEntryReader {
+public:
+    static const int chunkSize = 16 * 1024;
+
+    ZipEntryReader();
+    ~ZipEntryReader();
+
+    bool open(const ZipArchive &, int);
+    void close();
+    QByteArray read(int);
+    bool skip(qint64);
+    bool atEnd() const;
+    bool hasError() const;
+
+private:
+    struct Inflater;
+
+    QIODevice *archive = nullptr;
+    std::unique_ptr<Inflater> inflater;
+    QByteArray input;
+    qint64 dataOffset = 0;
+    qint64 compressedSize = 0;
+    qint64 compressedRead = 0;
+    qint64 size = 0;
+    qint64 position = 0;
+    bool isDeflated = false;
+    bool isStreamEnded = false;
+    bool isBroken = false;
+};
+
+#endif // ZIPARCHIVE_H
@@ -0,0 +1,403 @@
+#include "batchrunner.h"
+#include "partcompressor.h"
+#include "tracer.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QtConcurrent/QtConcurrent>
+
+namespace {
+// Rough sizes of what each kind of job keeps in memory. Counting streams the
+// text, probing reads at most the header of each take, and a running ffmpeg
+// process decodes one part at a time.
+const qint64 megabyte = 1024 * 1024;
+const qint64 indexMemory = 16 * megabyte;
+const qint64 probeMemoryPerPart = 64 * 1024;
+const qint64 ffmpegMemory = 64 * megabyte;
+
+const int partsPerProbeJob = 64;
+} // namespace
+
+BatchRunner::BatchProject::BatchProject(const QString &path)
+    : path(path), logOutput(&log), errorLogOutput(&errorLog),
+      commands(logOutput, errorLogOutput) {}
+
+BatchRunner::BatchRunner(const Options &options, QTextStream &output,
+                         QTextStream &errorOutput)
+    : options(options), output(output), errorOutput(errorOutput) {
+    workerPool.setMaxThreadCount(qMax(1, options.numWorkers));
+}
+
+BatchRunner::~BatchRunner() { workerPool.waitForDone(); }
+
+// Runs every project to the end and returns the worst of their exit codes.
+int BatchRunner::run(const QStringList &projectPaths) {
+    projects.clear();
+    numDoneProjects = 0;
+
+    if (!options.outputDirectory.isEmpty())
+        QDir().mkpath(options.outputDirectory);
+
+    for (const QString &projectPath : projectPaths) {
+        projects.push_back(std::make_unique<BatchProject>(projectPath));
+        projects.back()->commands.setDenoising(options.shouldDenoise);
+    }
+
+    for (auto &project : projects)
+        advance(project.get());
+
+    startJobs();
+    if (numDoneProjects < static_cast<int>(projects.size()))
+        eventLoop.exec();
+
+    int exitCode = ProjectCommands::Success;
+    int numIncomplete = 0;
+    int numFailed = 0;
+    for (auto &project : projects) {
+        exitCode = qMax(exitCode, project->exitCode);
+        if (project->exitCode == ProjectCommands::Incomplete)
+            numIncomplete++;
+        else if (project->exitCode == ProjectCommands::Failure)
+            numFailed++;
+    }
+
+    output << "projects: " << projects.size() << '\n'
+           << "incomplete: " << numIncomplete << '\n'
+           << "failed: " << numFailed << '\n';
+
+    return exitCode;
+}
+
+// One project per line. Blank lines and lines starting with # are skipped,
+// and relative paths are taken from where the list is.
+QStringList BatchRunner::readProjectList(const QString &listPath) {
+    QStringList projectPaths;
+
+    QFile listFile(listPath);
+    if (!listFile.open(QIODevice::ReadOnly | QIODevice::Text))
+        return projectPaths;
+
+    const QDir listDir = QFileInfo(listPath).absoluteDir();
+    QTextStream listInput(&listFile);
+    listInput.setCodec("UTF-8");
+
+    while (!listInput.atEnd()) {
+        const QString line = listInput.readLine().trimmed();
+        if (line.isEmpty() || line.startsWith('#'))
+            continue;
+
+        projectPaths.append(QDir::cleanPath(listDir.absoluteFilePath(line)));
+    }
+
+    return projectPaths;
+}
+
+// Projects take turns at the free workers, so that every one of them keeps
+// moving. A project only runs another job when it fits in what is left of
+// its budget, but a job larger than the whole budget may still run alone.
+void BatchRunner::startJobs() {
+    const size_t numProjects = projects.size();
+    bool hasStartedJob = true;
+
+    while (hasStartedJob && numRunningJobs < workerPool.maxThreadCount()) {
+        hasStartedJob = false;
+
+        for (size_t turn = 0; turn < numProjects; turn++) {
+            if (numRunningJobs >= workerPool.maxThreadCount())
+                break;
+
+            BatchProject *project =
+                projects[(nextProject + turn) % numProjects].get();
+            if (project->pendingJobs.isEmpty())
+                continue;
+
+            const qint64 jobMemory = project->pendingJobs.first().memory;
+            if (project->numRunningJobs > 0 &&
+                project->memoryInUse + jobMemory > options.projectMemoryBudget)
+                continue;
+
+            startJob(project, project->pendingJobs.takeFirst());
+            hasStartedJob = true;
+        }
+
+        if (numProjects > 0)
+            nextProject = (nextProject + 1) % numProjects;
+    }
+}
+
+void BatchRunner::startJob(BatchProject *project, const Job &job) {
+    numRunningJobs++;
+    project->numRunningJobs++;
+    project->memoryInUse += job.memory;
+
+    QtConcurrent::run(&workerPool, [this, project, job]() {
+        TraceScope traceScope("batch job");
+        job.work();
+
+        QMetaObject::invokeMethod(
+            this, [this, project, job]() { onJobFinished(project, job); },
+            Qt::QueuedConnection);
+    });
+}
+
+void BatchRunner::onJobFinished(BatchProject *project, const Job &job) {
+    numRunningJobs--;
+    project->numRunningJobs--;
+    project->memoryInUse -= job.memory;
+
+    if (job.finish)
+        job.finish();
+
+    if (project->pendingJobs.isEmpty() && project->numRunningJobs == 0)
+        advance(project);
+
+    startJobs();
+
+    if (numDoneProjects == static_cast<int>(projects.size()))
+        eventLoop.quit();
+}
+
+// Queues the jobs of the project's next stage once its current one is over.
+// Reporting and checking for missing parts are quick enough to do here.
+void BatchRunner::advance(BatchProject *project) {
+    if (project->exitCode == ProjectCommands::Failure) {
+        finishProject(project);
+        return;
+    }
+
+    switch (project->stage) {
+    case Stage::Queued:
+        project->stage = Stage::Index;
+        queueIndexJob(project);
+        break;
+    case Stage::Index:
+        project->stage = Stage::Probe;
+        queueProbeJobs(project);
+        break;
+    case Stage::Probe:
+        setExitCode(project, project->commands.reportStatus());
+        if (!options.shouldExport) {
+            finishProject(project);
+            return;
+        }
+
+        if (project->commands.checkMissingParts(options.allowMissing) !=
+            ProjectCommands::Success) {
+            setExitCode(project, ProjectCommands::Incomplete);
+            finishProject(project);
+            return;
+        }
+
+        project->stage = Stage::Compress;
+        queueCompressJobs(project);
+        break;
+    case Stage::Compress:
+        if (options.shouldDenoise) {
+            project->stage = Stage::Profile;
+            queueProfileJobs(project);
+            break;
+        }
+
+        project->stage = Stage::Export;
+        queueExportJob(project);
+        break;
+    case Stage::Profile:
+        project->stage = Stage::Denoise;
+        queueDenoiseJobs(project);
+        break;
+    case Stage::Denoise:
+        if (!project->commands.applyDenoiseResults(
+                project->denoiser->getResults())) {
+            setExitCode(project, ProjectCommands::Failure);
+            finishProject(project);
+            return;
+        }
+
+        project->stage = Stage::Export;
+        queueExportJob(project);
+        break;
+    case Stage::Export:
+        if (!options.shouldJoinChapters) {
+            finishProject(project);
+            return;
+        }
+
+        project->stage = Stage::Chapters;
+        queueChapterJobs(project);
+        break;
+    case Stage::Chapters:
+    case Stage::Done:
+        finishProject(project);
+        return;
+    }
+
+    // A stage with nothing to do moves straight on.
+    if (project->pendingJobs.isEmpty())
+        advance(project);
+}
+
+void BatchRunner::queueIndexJob(BatchProject *project) {
+    auto isIndexed = std::make_shared<bool>(false);
+
+    Job job;
+    job.memory = indexMemory;
+    job.work = [project, isIndexed]() {
+        ProjectCommands &commands = project->commands;
+        *isIndexed = commands.openProject(project->path) &&
+                     commands.indexText() && commands.findParts();
+    };
+    job.finish = [this, project, isIndexed]() {
+        if (!*isIndexed)
+            setExitCode(project, ProjectCommands::Failure);
+    };
+
+    project->pendingJobs.append(job);
+}
+
+// Parts are probed in chunks that run side by side. Their results are taken
+// in here, between jobs.
+void BatchRunner::queueProbeJobs(BatchProject *project) {
+    const auto unprobedParts = project->commands.getUnprobedParts();
+
+    for (int first = 0; first < unprobedParts.size();
+         first += partsPerProbeJob) {
+        const auto chunk = unprobedParts.mid(first, partsPerProbeJob);
+        auto results = std::make_shared<PartProber::ProbeResults>();
+
+        Job job;
+        job.memory = chunk.size() * probeMemoryPerPart;
+        job.work = [chunk, results]() {
+            *results = PartProber::probeParts(chunk);
+        };
+        job.finish = [project, results]() {
+            project->commands.applyProbeResults(*results);
+        };
+
+        project->pendingJobs.append(job);
+    }
+}
+
+void BatchRunner::queueCompressJobs(BatchProject *project) {
+    for (const QString &partPath : project->commands.getPartsToUnify()) {
+        Job job;
+        job.memory = ffmpegMemory;
+        job.work = [partPath]() { PartCompressor::compressFile(partPath); };
+
+        project->pendingJobs.append(job);
+    }
+}
+
+// Every take is profiled before any is cleaned, since takes without pauses
+// borrow the profiles of their neighbours.
+void BatchRunner::queueProfileJobs(BatchProject *project) {
+    PartDenoiser *denoiser = project->commands.createDenoiser();
+    project->denoiser = denoiser;
+
+    for (int take = 0; take < denoiser->getNumTakes(); take++) {
+        Job job;
+        job.memory = ffmpegMemory;
+        job.work = [denoiser, take]() { denoiser->profileTake(take); };
+
+        project->pendingJobs.append(job);
+    }
+}
+
+void BatchRunner::queueDenoiseJobs(BatchProject *project) {
+    PartDenoiser *denoiser = project->denoiser;
+
+    for (int take : denoiser->getTakesToClean()) {
+        Job job;
+        job.memory = ffmpegMemory;
+        job.work = [denoiser, take]() { denoiser->cleanTake(take); };
+
+        project->pendingJobs.append(job);
+    }
+}
+
+// Joining copies the parts as they are, but packed parts may be compacted
+// first, which holds the largest of them in memory.
+void BatchRunner::queueExportJob(BatchProject *project) {
+    ProjectCommands &commands = project->commands;
+
+    QString outputPath;
+    if (!options.outputDirectory.isEmpty())
+        outputPath = QDir(options.outputDirectory)
+                         .filePath(commands.getBookName() +
+                                   commands.getJoinedExtension());
+
+    auto exitCode = std::make_shared<int>(ProjectCommands::Failure);
+
+    Job job;
+    job.memory = commands.getLargestPartSize() + ffmpegMemory;
+    job.work = [project, outputPath, exitCode]() {
+        *exitCode = project->commands.writePartsList(outputPath);
+    };
+    job.finish = [this, project, exitCode]() {
+        setExitCode(project, *exitCode);
+    };
+
+    project->pendingJobs.append(job);
+}
+
+// Chapters are joined side by side, each with an ffmpeg process of its own.
+void BatchRunner::queueChapterJobs(BatchProject *project) {
+    ProjectCommands &commands = project->commands;
+    const QVector<int> chapters = commands.getChaptersToJoin();
+    if (chapters.isEmpty())
+        return;
+
+    const QString chapterDirectory =
+        commands.getChapterDirectory(options.outputDirectory);
+    QDir().mkpath(chapterDirectory);
+
+    for (int chapter : chapters) {
+        auto isJoined = std::make_shared<bool>(false);
+
+        Job job;
+        job.memory = ffmpegMemory;
+        job.work = [project, chapter, chapterDirectory, isJoined]() {
+            *isJoined =
+                project->commands.joinChapter(chapter, chapterDirectory);
+        };
+        job.finish = [this, project, chapter, chapterDirectory, isJoined]() {
+            if (!project->commands.reportChapter(chapter, chapterDirectory,
+                                                 *isJoined))
+                setExitCode(project, ProjectCommands::Failure);
+        };
+
+        project->pendingJobs.append(job);
+    }
+}
+
+// Prints everything the project reported at once, each line led by its
+// book's name, so that projects running side by side stay readable.
+void BatchRunner::finishProject(BatchProject *project) {
+    if (project->stage == Stage::Done)
+        return;
+
+    project->stage = Stage::Done;
+    project->pendingJobs.clear();
+    numDoneProjects++;
+
+    QString name = project->commands.getBookName();
+    if (name.isEmpty())
+        name = project->path;
+
+    project->logOutput.flush();
+    project->errorLogOutput.flush();
+
+    for (const QString &line :
+         project->log.split('\n', QString::SkipEmptyParts))
+        output << name << ": " << line << '\n';
+    for (const QString &line :
+         project->errorLog.split('\n', QString::SkipEmptyParts))
+        errorOutput << name << ": " << line << '\n';
+
+    output << flush;
+    errorOutput << flush;
+}
+
+void BatchRunner::setExitCode(BatchProject *project, int exitCode) {
+    project->exitCode = qMax(project->exitCode, exitCode);
+}
@@ -0,0 +1,108 @@
+#ifndef BATCHRUNNER_H
+#define BATCHRUNNER_H
+
+#include "projectcommands.h"
+#include <QEventLoop>
+#include <QObject>
+#include <QString>
+#include <QTextStream>
+#include <QThreadPool>
+#include <QVector>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// Runs the steps of many projects as jobs on one shared pool of workers, so
+// that a batch keeps every core busy however its books are sized. Each
+// project has a memory budget that the jobs it runs at once have to fit
+// in, which keeps one large book from crowding out the rest.
+class BatchRunner : public QObject {
+    Q_OBJECT
+
+public:
+    struct Options {
+        int numWorkers = 1;
+        qint64 projectMemoryBudget = 512 * 1024 * 1024;
+        bool shouldExport = false;
+        bool allowMissing = false;
+        bool shouldJoinChapters = false;
+        bool shouldDenoise = false;
+        QString outputDirectory;
+    };
+
+    BatchRunner(const Options &, QTextStream &, QTextStream &);
+    ~BatchRunner() override;
+
+    int run(const QStringList &);
+
+    static QStringList readProjectList(const QString &);
+
+private:
+    enum class Stage {
+        Queued,
+        Index,
+        Probe,
+        Compress,
+        Profile,
+        Denoise,
+        Export,
+        Chapters,
+        Done
+    };
+
+    struct Job {
+        std::function<void()> work;
+        std::function<void()> finish;
+        qint64 memory = 0;
+    };
+
+    // What a batch knows about each of its projects. Only one of its steps
+    // that touches the project itself runs at a time; probing, compressing
+    // and denoising only ever see copies of what they need, and joining
+    // chapters only reads the project.
+    struct BatchProject {
+        explicit BatchProject(const QString &);
+
+        QString path;
+        QString log;
+        QString errorLog;
+        QTextStream logOutput;
+        QTextStream errorLogOutput;
+        ProjectCommands commands;
+        PartDenoiser *denoiser = nullptr;
+
+        Stage stage = Stage::Queued;
+        QVector<Job> pendingJobs;
+        int numRunningJobs = 0;
+        qint64 memoryInUse = 0;
+        int exitCode = ProjectCommands::Success;
+    };
+
+    Options options;
+    QTextStream &output;
+    QTextStream &errorOutput;
+
+    QThreadPool workerPool;
+    QEventLoop eventLoop;
+    std::vector<std::unique_ptr<BatchProject>> projects;
+    size_t nextProject = 0;
+    int numRunningJobs = 0;
+    int numDoneProjects = 0;
+
+    void startJobs();
+    void startJob(BatchProject *, const Job &);
+    void onJobFinished(BatchProject *, const Job &);
+
+    void advance(BatchProject *);
+    void queueIndexJob(BatchProject *);
+    void queueProbeJobs(BatchProject *);
+    void queueCompressJobs(BatchProject *);
+    void queueProfileJobs(BatchProject *);
+    void queueDenoiseJobs(BatchProject *);
+    void queueExportJob(BatchProject *);
+    void queueChapterJobs(BatchProject *);
+    void finishProject(BatchProject *);
+    void setExitCode(BatchProject *, int);
+};
+
+#endif // BATCHRUNNER_H
@@ -0,0 +1,65 @@
+QT       += core concurrent
+QT       -= gui
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = narrative-director-cli
+TEMPLATE = app
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+SOURCES += \
+        main.cpp \
+        batchrunner.cpp \
+        projectcommands.cpp \
+    ../app/utilities/paragraphretriever.cpp \
+    ../app/utilities/paragraphcounter.cpp \
+    ../app/utilities/chapterlist.cpp \
+    ../app/utilities/projectfile.cpp \
+    ../app/utilities/projectjournal.cpp \
+    ../app/utilities/recordedpartstracker.cpp \
+    ../app/utilities/partprober.cpp \
+    ../app/utilities/waveheader.cpp \
+    ../app/utilities/partspack.cpp \
+    ../app/utilities/partcompressor.cpp \
+    ../app/utilities/partslist.cpp \
+    ../app/utilities/tracer.cpp \
+    ../app/utilities/diagnosticsreport.cpp \
+    ../app/utilities/importedtext.cpp \
+    ../app/utilities/markupstripper.cpp \
+    ../app/utilities/ziparchive.cpp \
+    ../app/utilities/noisereducer.cpp \
+    ../app/utilities/partdenoiser.cpp
+
+HEADERS += \
+        batchrunner.h \
+        projectcommands.h \
+    ../app/utilities/paragraphretriever.h \
+    ../app/utilities/paragraphcounter.h \
+    ../app/utilities/chapterlist.h \
+    ../app/utilities/projectfile.h \
+    ../app/utilities/projectjournal.h \
+    ../app/utilities/recordedpartstracker.h \
+    ../app/utilities/partprober.h \
+    ../app/utilities/waveheader.h \
+    ../app/utilities/partspack.h \
+    ../app/utilities/partcompressor.h \
+    ../app/utilities/partslist.h \
+    ../app/utilities/tracer.h \
+    ../app/utilities/diagnosticsreport.h \
+    ../app/utilities/importedtext.h \
+    ../app/utilities/markupstripper.h \
+    ../app/utilities/ziparchive.h \
+    ../app/utilities/noisereducer.h \
+    ../app/utilities/partdenoiser.h
+
+# EPUB chapters are inflated with zlib, which Qt bundles on Windows.
+unix: LIBS += -lz
+win32: INCLUDEPATH += $$[QT_INSTALL_HEADERS]/QtZlib
+
+DESTDIR = $$PWD/../build
+
+INCLUDEPATH += \
+	$$PWD \
+	../app/utilities
@@ -0,0 +1,140 @@
+#include "batchrunner.h"
+#include "projectcommands.h"
+#include "tracer.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QTextStream>
+#include <QThread>
+
+int main(int argc, char *argv[]) {
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("narrative-director-cli");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        "Indexes, validates and exports Narrative Director projects without "
+        "a display.\n\n"
+        "Commands:\n"
+        "  index     Count the paragraphs and words of a text and store them "
+        "in its project.\n"
+        "  validate  Check that every paragraph has a readable part.\n"
+        "  export    Write parts-list.txt, and join the parts with ffmpeg "
+        "when --output is given.\n"
+        "  batch     Index and validate every project in a list, one per "
+        "line, on a shared pool of workers. Exports them too with --export.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("command",
+                                 "index, validate, export or batch.");
+    parser.addPositionalArgument(
+        "project", "A text file, or its .ndp project file. For batch, a file "
+                   "listing them.");
+
+    QCommandLineOption retrieverOption(
+        "retriever", "index: count paragraphs by sentence boundaries, as "
+                     "ParagraphRetriever does, without storing them.");
+    QCommandLineOption allowMissingOption(
+        "allow-missing",
+        "export, batch: list the recorded parts even if some are missing.");
+    QCommandLineOption outputOption(
+        QStringList() << "o"
+                      << "output",
+        "export: join the parts into this file with ffmpeg.", "file");
+    QCommandLineOption chaptersOption(
+        "chapters", "export, batch: also join each chapter into a file of its "
+                    "own, next to the joined book.");
+    QCommandLineOption denoiseOption(
+        "denoise", "export, batch: take the room noise out of cleaned copies "
+                   "of the parts, and join those. The parts are left as "
+                   "recorded.");
+    QCommandLineOption jobsOption(
+        "jobs", "batch: run this many jobs at once. Defaults to the number of "
+                "cores.", "count",
+        QString::number(QThread::idealThreadCount()));
+    QCommandLineOption projectMemoryOption(
+        "project-memory",
+        "batch: how much memory the running jobs of one project may use.",
+        "megabytes", "512");
+    QCommandLineOption exportOption("export",
+                                    "batch: export the projects as well.");
+    QCommandLineOption outputDirOption(
+        "output-dir", "batch: join each project's parts into a file here.",
+        "directory");
+    QCommandLineOption traceOption(
+        "trace", "Write a Chrome trace of where the time went to this file.",
+        "file");
+    QCommandLineOption diagnosticsOption(
+        "diagnostics", "Report what the command held in memory once it is "
+                       "done. For batch, only the process as a whole.");
+    parser.addOptions({retrieverOption, allowMissingOption, outputOption,
+                       chaptersOption, denoiseOption, jobsOption,
+                       projectMemoryOption, exportOption, outputDirOption,
+                       traceOption, diagnosticsOption});
+
+    parser.process(a);
+
+    const QStringList arguments = parser.positionalArguments();
+    if (arguments.size() != 2)
+        parser.showHelp(ProjectCommands::Failure);
+
+    QTextStream output(stdout);
+    QTextStream errorOutput(stderr);
+    ProjectCommands commands(output, errorOutput);
+    Tracer::setEnabled(parser.isSet(traceOption));
+
+    const QString command = arguments[0];
+    const QString projectPath = arguments[1];
+    int exitCode = ProjectCommands::Failure;
+
+    if (command == "index") {
+        exitCode = commands.index(projectPath, parser.isSet(retrieverOption));
+    } else if (command == "validate") {
+        exitCode = commands.validate(projectPath);
+    } else if (command == "export") {
+        commands.setDenoising(parser.isSet(denoiseOption));
+        exitCode = commands.exportParts(
+            projectPath, parser.isSet(allowMissingOption),
+            parser.value(outputOption), parser.isSet(chaptersOption));
+    } else if (command == "batch") {
+        BatchRunner::Options options;
+        options.numWorkers = parser.value(jobsOption).toInt();
+        options.projectMemoryBudget =
+            parser.value(projectMemoryOption).toLongLong() * 1024 * 1024;
+        options.shouldExport = parser.isSet(exportOption) ||
+                               parser.isSet(outputDirOption) ||
+                               parser.isSet(chaptersOption) ||
+                               parser.isSet(denoiseOption);
+        options.shouldJoinChapters = parser.isSet(chaptersOption);
+        options.shouldDenoise = parser.isSet(denoiseOption);
+        options.allowMissing = parser.isSet(allowMissingOption);
+        options.outputDirectory = parser.value(outputDirOption);
+
+        const QStringList projectPaths =
+            BatchRunner::readProjectList(projectPath);
+        if (projectPaths.isEmpty()) {
+            errorOutput << "No projects to run in " << projectPath << '\n';
+        } else {
+            BatchRunner runner(options, output, errorOutput);
+            exitCode = runner.run(projectPaths);
+        }
+    } else {
+        errorOutput << "Unknown command " << command << '\n';
+    }
+
+    if (parser.isSet(diagnosticsOption)) {
+        DiagnosticsReport report;
+        if (command != "batch")
+            commands.addDiagnostics(report);
+        report.addProcessMemory();
+
+        output << '\n' << report.toText();
+    }
+
+    if (parser.isSet(traceOption) &&
+        !Tracer::writeChromeTrace(parser.value(traceOption)))
+        errorOutput << "Could not write the trace to "
+                    << parser.value(traceOption) << '\n';
+
+    output << flush;
+    errorOutput << flush;
+    return exitCode;
+}
@@ -0,0 +1,698 @@
+#include "projectcommands.h"
+#include "importedtext.h"
+#include "paragraphretriever.h"
+#include "partcompressor.h"
+#include "partslist.h"
+#include "projectjournal.h"
+#include "tracer.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QFuture>
+#include <QProcess>
+#include <QtConcurrent/QtConcurrent>
+#include <algorithm>
+
+// Cleaned copies of parts that were never probed come out like this.
+static const int defaultSampleRate = 44100;
+static const int defaultChannelCount = 1;
+
+ProjectCommands::ProjectCommands(QTextStream &output, QTextStream &errorOutput)
+    : output(output), errorOutput(errorOutput) {}
+
+// Counts the text's paragraphs and words and stores them in its project,
+// creating the project when there is none yet. The retriever only reports
+// its own count, since its paragraphs are not the ones parts belong to.
+int ProjectCommands::index(const QString &path, bool useRetriever) {
+    if (!openProject(path))
+        return Failure;
+
+    if (useRetriever) {
+        TraceScope traceScope("index text");
+        QFile textFile;
+        ImportedText importedText;
+        QIODevice *textDevice = ImportedText::openTextDevice(
+            project.textFilePath, textFile, importedText);
+        if (textDevice == nullptr) {
+            errorOutput << "Could not read " << project.textFilePath << '\n';
+            return Failure;
+        }
+
+        ParagraphRetriever retriever(textDevice, 4);
+        output << "paragraphs: " << retriever.getNumParagraphs() << '\n';
+        textBufferBytes = retriever.getMemoryUsage();
+        return Success;
+    }
+
+    return indexText() ? Success : Failure;
+}
+
+// Checks that every paragraph has a part, and that every part can be read.
+int ProjectCommands::validate(const QString &path) {
+    if (!openProject(path) || !findParts())
+        return Failure;
+
+    applyProbeResults(PartProber::probeParts(getUnprobedParts()));
+    return reportStatus();
+}
+
+// Writes the project's parts-list.txt, and joins the parts into one file
+// when an output path is given. Chapters are joined into files of their own
+// next to it, or in the recording directory when there is no output path.
+int ProjectCommands::exportParts(const QString &path, bool allowMissing,
+                                 const QString &outputPath,
+                                 bool shouldJoinChapters) {
+    if (!openProject(path) || !findParts())
+        return Failure;
+
+    applyProbeResults(PartProber::probeParts(getUnprobedParts()));
+
+    int exitCode = checkMissingParts(allowMissing);
+    if (exitCode != Success)
+        return exitCode;
+
+    for (const QString &partPath : getPartsToUnify())
+        PartCompressor::compressFile(partPath);
+
+    if (isDenoising &&
+        !applyDenoiseResults(
+            createDenoiser()->run(QThreadPool::globalInstance())))
+        return Failure;
+
+    exitCode = writePartsList(outputPath);
+    if (exitCode != Success || !shouldJoinChapters)
+        return exitCode;
+
+    return joinChapters(getChapterDirectory(
+        outputPath.isEmpty() ? QString()
+                             : QFileInfo(outputPath).absolutePath()));
+}
+
+// Exports from then on take the room noise out of the parts, writing cleaned
+// copies and listing those in place of the parts.
+void ProjectCommands::setDenoising(bool shouldDenoise) {
+    isDenoising = shouldDenoise;
+}
+
+// Takes either a text file or its .ndp project. A text opens the project
+// that sits in its recording directory, if there is one yet.
+bool ProjectCommands::openProject(const QString &path) {
+    project = ProjectFile();
+    recordedParts.clear();
+    partsPack.close();
+    cleanPaths.clear();
+    denoiser.reset();
+
+    if (path.endsWith(".ndp")) {
+        projectFilePath = path;
+        if (!project.load(projectFilePath)) {
+            errorOutput << "Could not read " << projectFilePath << '\n';
+            return false;
+        }
+
+        replayJournals();
+        return true;
+    }
+
+    const QString textFilePath = QFileInfo(path).absoluteFilePath();
+    projectFilePath = ProjectFile::getProjectFilePath(textFilePath);
+    if (QFileInfo::exists(projectFilePath) && !project.load(projectFilePath)) {
+        errorOutput << "Could not read " << projectFilePath << '\n';
+        return false;
+    }
+
+    // The text asked for wins, as it does when opening it in the program.
+    project.textFilePath = textFilePath;
+    replayJournals();
+    return true;
+}
+
+// Brings the project up to date with what the program journaled since it
+// last saved it in full, as the program does when it opens the project.
+void ProjectCommands::replayJournals() {
+    for (const QString &journalPath :
+         ProjectFile::getJournalPaths(project.textFilePath))
+        ProjectJournal::replay(journalPath, project);
+}
+
+// Once the project is saved, the journals it replayed are in it. They are
+// emptied rather than removed, since a session of the program may still be
+// appending to its own.
+bool ProjectCommands::saveProject() {
+    if (!project.save(projectFilePath)) {
+        errorOutput << "Could not write " << projectFilePath << '\n';
+        return false;
+    }
+
+    for (const QString &journalPath :
+         ProjectFile::getJournalPaths(project.textFilePath))
+        QFile::resize(journalPath, 0);
+
+    return true;
+}
+
+bool ProjectCommands::indexText() {
+    ParagraphCounter::Counts counts;
+    if (!countText(counts))
+        return false;
+
+    const uint numPrgs = counts.numPrgs;
+
+    // Locations found in an older version of the text no longer point at
+    // the start of its paragraphs.
+    if (project.prgNumTotal != numPrgs) {
+        project.prgStarts.clear();
+        project.prgNum = 0;
+    }
+    project.prgNumTotal = numPrgs;
+    project.wordCounts = counts.wordCounts;
+    project.chapters = counts.chapters;
+    project.chapterPatternsKey =
+        ChapterList::getPatternsKey(ChapterList::getPatterns());
+
+    QDir().mkpath(getRecordingPath());
+    if (!saveProject())
+        return false;
+
+    quint64 numWords = 0;
+    for (quint32 wordCount : counts.wordCounts)
+        numWords += wordCount;
+
+    output << "project: " << projectFilePath << '\n'
+           << "paragraphs: " << numPrgs << '\n'
+           << "words: " << numWords << '\n'
+           << "chapters: " << counts.chapters.size() << '\n';
+    return true;
+}
+
+// Finds the project's parts the same way the program does when it opens
+// the project, keeping what the tracker already knew about them.
+bool ProjectCommands::findParts() {
+    // Projects that were never saved with a count are counted on the fly.
+    if (project.prgNumTotal == 0) {
+        ParagraphCounter::Counts counts;
+        if (!countText(counts))
+            return false;
+
+        project.prgNumTotal = counts.numPrgs;
+        project.chapters = counts.chapters;
+        project.chapterPatternsKey =
+            ChapterList::getPatternsKey(ChapterList::getPatterns());
+    }
+
+    const QString textFilePath = project.textFilePath;
+    recordedParts.loadFromFile(ProjectFile::getTrackerFilePath(textFilePath));
+
+    if (!project.isPackStorage) {
+        recordedParts.scanDirectory(getRecordingPath());
+        return true;
+    }
+
+    if (!partsPack.open(ProjectFile::getPackFilePath(textFilePath))) {
+        errorOutput << "Could not open "
+                    << ProjectFile::getPackFilePath(textFilePath) << '\n';
+        return false;
+    }
+
+    recordedParts.scanPack(partsPack.getParts());
+    return true;
+}
+
+QVector<PartProber::PendingPart> ProjectCommands::getUnprobedParts() const {
+    QVector<PartProber::PendingPart> unprobedParts;
+    for (uint part : recordedParts.getUnprobedParts()) {
+        PartProber::PendingPart pendingPart;
+        pendingPart.part = part;
+
+        if (project.isPackStorage) {
+            pendingPart.filePath = partsPack.getPackPath();
+            pendingPart.offset = partsPack.getPartOffset(part);
+            pendingPart.size = partsPack.getPartSize(part);
+        } else {
+            pendingPart.filePath = getPartPath(part);
+        }
+
+        unprobedParts.append(pendingPart);
+    }
+
+    return unprobedParts;
+}
+
+void ProjectCommands::applyProbeResults(
+    const PartProber::ProbeResults &results) {
+    for (auto &result : results) {
+        const uint part = result.first;
+        auto info = result.second;
+
+        // Containers the prober cannot look into keep the recorder's length.
+        if (info.durationMs == 0)
+            info.durationMs = recordedParts.getPartInfo(part).durationMs;
+        recordedParts.setPartInfo(part, info);
+    }
+}
+
+// Reports missing and unreadable parts once they have been probed.
+int ProjectCommands::reportStatus() {
+    output << "paragraphs: " << project.prgNumTotal << '\n'
+           << "recorded: "
+           << qMin(recordedParts.getNumRecorded(), project.prgNumTotal)
+           << '\n';
+
+    uint numMissing = reportMissingParts();
+
+    QVector<uint> parts = recordedParts.getPartInfos().keys().toVector();
+    std::sort(parts.begin(), parts.end());
+
+    uint numUnreadable = 0;
+    uint numExtra = 0;
+    for (uint part : parts) {
+        // Parts past the end belong to paragraphs the text no longer has.
+        if (part >= project.prgNumTotal) {
+            numExtra++;
+            continue;
+        }
+
+        if (isReadable(recordedParts.getPartInfo(part)))
+            continue;
+
+        output << "unreadable: " << part + 1 << " "
+               << (project.isPackStorage ? partsPack.getPackPath()
+                                         : getPartPath(part))
+               << '\n';
+        numUnreadable++;
+    }
+
+    if (numExtra > 0)
+        output << "extra: " << numExtra << '\n';
+
+    bool isComplete = numMissing == 0 && numUnreadable == 0;
+    output << "status: " << (isComplete ? "complete" : "incomplete") << '\n';
+
+    return isComplete ? Success : Incomplete;
+}
+
+int ProjectCommands::checkMissingParts(bool allowMissing) {
+    if (allowMissing ||
+        recordedParts.getFirstUnrecorded(project.prgNumTotal) == -1)
+        return Success;
+
+    reportMissingParts();
+    errorOutput << "Some paragraphs have not been recorded yet. Pass "
+                   "--allow-missing to export anyway.\n";
+    return Incomplete;
+}
+
+// Parts that have to be compressed before ffmpeg can join them with the
+// ones that already are. Packed parts are always kept as recorded.
+QStringList ProjectCommands::getPartsToUnify() const {
+    QStringList partPaths;
+    if (project.isPackStorage)
+        return partPaths;
+
+    for (uint part :
+         PartCompressor::getPartsToUnify(recordedParts, project.prgNumTotal))
+        partPaths.append(getPartPath(part));
+
+    return partPaths;
+}
+
+// Also writes a list for each chapter, and the metadata that marks where
+// they start, when the text has chapters.
+int ProjectCommands::writePartsList(const QString &outputPath) {
+    const uint numPrgs = project.prgNumTotal;
+    const QString listPath = PartsList::getListPath(getRecordingPath());
+
+    if (project.isPackStorage) {
+        partsPack.compactIfNeeded();
+    } else {
+        // Compressed parts were renamed.
+        recordedParts.scanDirectory(getRecordingPath());
+        if (PartCompressor::hasMixedFormats(recordedParts, numPrgs))
+            errorOutput << "Some parts could not be converted to the format "
+                           "of the others, so ffmpeg may not be able to join "
+                           "them.\n";
+    }
+
+    if (!writeList(listPath, 0, numPrgs)) {
+        errorOutput << "Could not write " << listPath << '\n';
+        return Failure;
+    }
+
+    output << "list: " << listPath << '\n';
+    if (!writeChapterLists())
+        return Failure;
+
+    if (outputPath.isEmpty())
+        return Success;
+
+    const QString metadataPath =
+        project.chapters.isEmpty()
+            ? QString()
+            : ChapterList::getMetadataPath(getRecordingPath());
+    if (!runFfmpeg(PartsList::getConcatArguments(listPath, isListPacked(),
+                                                 outputPath, metadataPath))) {
+        errorOutput << "ffmpeg could not join the parts into " << outputPath
+                    << '\n';
+        return Failure;
+    }
+
+    output << "output: " << QFileInfo(outputPath).absoluteFilePath() << '\n';
+    return Success;
+}
+
+// Joins every chapter with recorded parts into a file of its own, all of
+// them at once.
+int ProjectCommands::joinChapters(const QString &chapterDirectory) {
+    if (project.chapters.isEmpty()) {
+        errorOutput << "No chapter headings were found in "
+                    << project.textFilePath << '\n';
+        return Success;
+    }
+
+    QDir().mkpath(chapterDirectory);
+
+    const QVector<int> chapters = getChaptersToJoin();
+    QVector<QFuture<bool>> chapterJoins;
+    for (int chapter : chapters)
+        chapterJoins.append(
+            QtConcurrent::run([this, chapter, chapterDirectory]() {
+                return joinChapter(chapter, chapterDirectory);
+            }));
+
+    int exitCode = Success;
+    for (int join = 0; join < chapters.size(); join++) {
+        if (!reportChapter(chapters[join], chapterDirectory,
+                           chapterJoins[join].result()))
+            exitCode = Failure;
+    }
+
+    return exitCode;
+}
+
+// Chapters without a single recorded part have nothing to join.
+QVector<int> ProjectCommands::getChaptersToJoin() const {
+    QVector<int> chapters;
+    for (int chapter = 0; chapter < project.chapters.size(); chapter++) {
+        const uint endPrg = ChapterList::getEndPrg(project.chapters, chapter,
+                                                   project.prgNumTotal);
+        for (uint prg = project.chapters[chapter].firstPrg; prg < endPrg;
+             prg++) {
+            if (recordedParts.isRecorded(prg)) {
+                chapters.append(chapter);
+                break;
+            }
+        }
+    }
+
+    return chapters;
+}
+
+// Only reads the project, so any number of chapters can be joined at once
+// once their lists are written.
+bool ProjectCommands::joinChapter(int chapter,
+                                  const QString &chapterDirectory) const {
+    QStringList arguments = PartsList::getConcatArguments(
+        PartsList::getChapterListPath(getRecordingPath(), chapter),
+        isListPacked(), getChapterPath(chapter, chapterDirectory));
+
+    // Each chapter file is titled by its heading.
+    const QString title = project.chapters[chapter].title;
+    if (!title.isEmpty()) {
+        arguments.insert(arguments.size() - 1, "-metadata");
+        arguments.insert(arguments.size() - 1, "title=" + title);
+    }
+
+    return runFfmpeg(arguments);
+}
+
+bool ProjectCommands::reportChapter(int chapter,
+                                    const QString &chapterDirectory,
+                                    bool isJoined) {
+    const QString chapterPath = getChapterPath(chapter, chapterDirectory);
+    if (!isJoined) {
+        errorOutput << "ffmpeg could not join chapter " << chapter + 1
+                    << " into " << chapterPath << '\n';
+        return false;
+    }
+
+    output << "chapter: " << QFileInfo(chapterPath).absoluteFilePath()
+           << '\n';
+    return true;
+}
+
+// Chapter files of a joined book go in a directory named after it, and
+// otherwise in the recording directory.
+QString
+ProjectCommands::getChapterDirectory(const QString &outputDirectory) const {
+    if (outputDirectory.isEmpty())
+        return getRecordingPath() + "/chapters";
+
+    return QDir(outputDirectory).filePath(getBookName());
+}
+
+QString ProjectCommands::getBookName() const {
+    return ProjectFile::getBookName(project.textFilePath);
+}
+
+// Joining parts without encoding them again keeps their container, so the
+// joined file takes the extension of the parts.
+QString ProjectCommands::getJoinedExtension() const {
+    if (isDenoising)
+        return ".wav";
+
+    if (!project.isPackStorage) {
+        for (uint part = 0; part < project.prgNumTotal; part++) {
+            if (!recordedParts.isRecorded(part))
+                continue;
+
+            const QString suffix =
+                QFileInfo(recordedParts.getPartInfo(part).fileName).suffix();
+            if (!suffix.isEmpty())
+                return "." + suffix;
+        }
+    }
+
+    return project.audioExtension;
+}
+
+qint64 ProjectCommands::getLargestPartSize() const {
+    qint64 largestPartSize = 0;
+    for (auto &info : recordedParts.getPartInfos())
+        largestPartSize = qMax(largestPartSize, info.byteSize);
+
+    return largestPartSize;
+}
+
+// What the project holds in memory after the command that ran.
+void ProjectCommands::addDiagnostics(DiagnosticsReport &report) const {
+    qint64 chapterBytes = DiagnosticsReport::getVectorBytes(project.chapters);
+    for (auto &chapter : project.chapters)
+        chapterBytes += DiagnosticsReport::getStringBytes(chapter.title);
+
+    if (textBufferBytes > 0)
+        report.addBytes("Text (ParagraphRetriever)", textBufferBytes);
+    report.addBytes("Paragraph starts",
+                    DiagnosticsReport::getVectorBytes(project.prgStarts));
+    report.addBytes("Word counts",
+                    DiagnosticsReport::getVectorBytes(project.wordCounts));
+    report.addBytes("Chapters", chapterBytes);
+    report.addBytes("Recorded parts", recordedParts.getMemoryUsage());
+    report.addBytes("Pack offset table (mapped)", partsPack.getMappedBytes());
+
+    report.addCount("Index", "Paragraphs in text", project.prgNumTotal);
+    report.addCount("Index", "Paragraphs found", project.prgStarts.size());
+    report.addCount("Index", "Chapters", project.chapters.size());
+    report.addCount("Index", "Recorded parts", recordedParts.getNumRecorded());
+}
+
+bool ProjectCommands::countText(ParagraphCounter::Counts &counts) {
+    TraceScope traceScope("index text");
+    QFile textFile;
+    ImportedText importedText;
+    QIODevice *textDevice = ImportedText::openTextDevice(
+        project.textFilePath, textFile, importedText);
+    if (textDevice == nullptr) {
+        errorOutput << "Could not read " << project.textFilePath << '\n';
+        return false;
+    }
+
+    QTextStream textInput(textDevice);
+    textInput.setCodec("UTF-8");
+    counts = ParagraphCounter::countText(
+        textInput,
+        ChapterList::compilePatterns(ChapterList::getPatterns()));
+
+    return true;
+}
+
+// Sets out to clean every recorded part, or find the copy cleaned on an
+// earlier export. The copies all take the sample rate and channels most of
+// the parts have, so that they can be joined without encoding them again.
+PartDenoiser *ProjectCommands::createDenoiser() {
+    // Compressed parts were renamed.
+    if (!project.isPackStorage)
+        recordedParts.scanDirectory(getRecordingPath());
+
+    QVector<PartDenoiser::Take> takes;
+    QHash<QPair<int, int>, int> numFormats;
+    for (uint part = 0; part < project.prgNumTotal; part++) {
+        if (!recordedParts.isRecorded(part))
+            continue;
+
+        PartDenoiser::Take take;
+        take.part = part;
+        if (project.isPackStorage) {
+            take.filePath = partsPack.getPackPath();
+            take.offset = partsPack.getPartOffset(part);
+            take.size = partsPack.getPartSize(part);
+        } else {
+            take.filePath = getPartPath(part);
+        }
+        takes.append(take);
+
+        const RecordedPartsTracker::PartInfo info =
+            recordedParts.getPartInfo(part);
+        if (info.sampleRate > 0 && info.channelCount > 0)
+            numFormats[qMakePair(info.sampleRate, info.channelCount)]++;
+    }
+
+    QPair<int, int> format(defaultSampleRate, defaultChannelCount);
+    int numMostCommon = 0;
+    for (auto formatCount = numFormats.cbegin();
+         formatCount != numFormats.cend(); ++formatCount) {
+        if (formatCount.value() > numMostCommon) {
+            format = formatCount.key();
+            numMostCommon = formatCount.value();
+        }
+    }
+
+    denoiser = std::make_unique<PartDenoiser>(
+        takes, PartDenoiser::getCacheDirectory(getRecordingPath()),
+        format.first, format.second);
+    return denoiser.get();
+}
+
+// Exports list the cleaned copies from then on.
+bool ProjectCommands::applyDenoiseResults(
+    const PartDenoiser::Results &results) {
+    cleanPaths = results.cleanPaths;
+
+    for (uint part : results.failedParts)
+        errorOutput << "Could not take the noise out of part " << part + 1
+                    << '\n';
+
+    output << "denoised: " << results.numCleaned << '\n'
+           << "denoised cached: " << results.numCached << '\n';
+    return results.failedParts.isEmpty();
+}
+
+// Cleaned copies are separate files even when the parts are packed.
+bool ProjectCommands::isListPacked() const {
+    return project.isPackStorage && !isDenoising;
+}
+
+// The recorded parts from the first paragraph up to the end one.
+bool ProjectCommands::writeList(const QString &listPath, uint firstPrg,
+                                uint endPrg) const {
+    if (isListPacked())
+        return PartsList::writePacked(listPath, partsPack, firstPrg, endPrg);
+
+    QStringList partPaths;
+    for (uint part = firstPrg; part < endPrg; part++) {
+        if (!recordedParts.isRecorded(part))
+            continue;
+
+        partPaths.append(isDenoising ? cleanPaths.value(part)
+                                     : getPartPath(part));
+    }
+
+    return PartsList::writeFiles(listPath, partPaths);
+}
+
+bool ProjectCommands::writeChapterLists() {
+    const QVector<ChapterList::Chapter> &chapters = project.chapters;
+    if (chapters.isEmpty())
+        return true;
+
+    for (int chapter = 0; chapter < chapters.size(); chapter++) {
+        const QString listPath =
+            PartsList::getChapterListPath(getRecordingPath(), chapter);
+        const uint endPrg = ChapterList::getEndPrg(chapters, chapter,
+                                                   project.prgNumTotal);
+
+        if (!writeList(listPath, chapters[chapter].firstPrg, endPrg)) {
+            errorOutput << "Could not write " << listPath << '\n';
+            return false;
+        }
+    }
+
+    const QString metadataPath =
+        ChapterList::getMetadataPath(getRecordingPath());
+    if (!ChapterList::writeMetadata(
+            metadataPath, getBookName(), chapters,
+            recordedParts.getDurationsMs(project.prgNumTotal))) {
+        errorOutput << "Could not write " << metadataPath << '\n';
+        return false;
+    }
+
+    output << "chapters: " << metadataPath << '\n';
+    return true;
+}
+
+QString ProjectCommands::getChapterPath(int chapter,
+                                        const QString &chapterDirectory) const {
+    return QDir(chapterDirectory)
+        .filePath(ChapterList::getFileName(project.chapters, chapter) +
+                  getJoinedExtension());
+}
+
+bool ProjectCommands::runFfmpeg(const QStringList &arguments) {
+    TraceScope traceScope("ffmpeg");
+    QProcess ffmpeg;
+    ffmpeg.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+    ffmpeg.start("ffmpeg", arguments);
+
+    return ffmpeg.waitForFinished(-1) &&
+           ffmpeg.exitStatus() == QProcess::NormalExit &&
+           ffmpeg.exitCode() == 0;
+}
+
+// Lists paragraphs without a part as ranges, numbered as the program shows
+// them, and returns how many there are.
+uint ProjectCommands::reportMissingParts() {
+    const uint numPrgs = project.prgNumTotal;
+    uint numMissing = 0;
+
+    int missing = recordedParts.getFirstUnrecorded(numPrgs);
+    while (missing != -1) {
+        uint rangeEnd = static_cast<uint>(missing);
+        while (rangeEnd + 1 < numPrgs &&
+               !recordedParts.isRecorded(rangeEnd + 1))
+            rangeEnd++;
+
+        output << "missing: " << missing + 1;
+        if (rangeEnd > static_cast<uint>(missing))
+            output << "-" << rangeEnd + 1;
+        output << '\n';
+
+        numMissing += rangeEnd - static_cast<uint>(missing) + 1;
+        missing = recordedParts.getNextUnrecorded(rangeEnd + 1, numPrgs);
+    }
+
+    return numMissing;
+}
+
+QString ProjectCommands::getRecordingPath() const {
+    return ProjectFile::getRecordingPath(project.textFilePath);
+}
+
+QString ProjectCommands::getPartPath(uint part) const {
+    return ProjectFile::getPartPath(getRecordingPath(), part,
+                                    recordedParts.getPartInfo(part).fileName,
+                                    project.audioExtension);
+}
+
+bool ProjectCommands::isReadable(const RecordedPartsTracker::PartInfo &info) {
+    return info.byteSize > 0 && !info.codec.isEmpty() &&
+           info.codec != "unknown";
+}
@@ -0,0 +1,87 @@
+#ifndef PROJECTCOMMANDS_H
+#define PROJECTCOMMANDS_H
+
+#include "chapterlist.h"
+#include "diagnosticsreport.h"
+#include "paragraphcounter.h"
+#include "partdenoiser.h"
+#include "partprober.h"
+#include "partspack.h"
+#include "projectfile.h"
+#include "recordedpartstracker.h"
+#include <QHash>
+#include <QStringList>
+#include <QTextStream>
+#include <QVector>
+#include <memory>
+
+// Indexes, validates and exports a project without a display. Results are
+// written as "key: value" lines so that scripts can pick them apart, and
+// problems go to the error stream.
+//
+// Each command is made of steps that a batch can also run one at a time.
+// Only probing, compressing and denoising parts and joining chapters are
+// safe to run while other steps of the same project are running.
+class ProjectCommands {
+public:
+    enum ExitCode { Success = 0, Incomplete = 1, Failure = 2 };
+
+    ProjectCommands(QTextStream &, QTextStream &);
+
+    int index(const QString &, bool = false);
+    int validate(const QString &);
+    int exportParts(const QString &, bool = false, const QString & = QString(),
+                    bool = false);
+
+    void setDenoising(bool);
+
+    bool openProject(const QString &);
+    bool indexText();
+    bool findParts();
+    QVector<PartProber::PendingPart> getUnprobedParts() const;
+    void applyProbeResults(const PartProber::ProbeResults &);
+    int reportStatus();
+    int checkMissingParts(bool);
+    QStringList getPartsToUnify() const;
+    PartDenoiser *createDenoiser();
+    bool applyDenoiseResults(const PartDenoiser::Results &);
+    int writePartsList(const QString &);
+    int joinChapters(const QString &);
+    QVector<int> getChaptersToJoin() const;
+    bool joinChapter(int, const QString &) const;
+    bool reportChapter(int, const QString &, bool);
+    QString getChapterDirectory(const QString &) const;
+
+    QString getBookName() const;
+    QString getJoinedExtension() const;
+    qint64 getLargestPartSize() const;
+    void addDiagnostics(DiagnosticsReport &) const;
+
+private:
+    QTextStream &output;
+    QTextStream &errorOutput;
+
+    ProjectFile project;
+    QString projectFilePath;
+    RecordedPartsTracker recordedParts;
+    PartsPack partsPack;
+    qint64 textBufferBytes = 0;
+    bool isDenoising = false;
+    QHash<uint, QString> cleanPaths;
+    std::unique_ptr<PartDenoiser> denoiser;
+
+    void replayJournals();
+    bool saveProject();
+    bool countText(ParagraphCounter::Counts &);
+    bool isListPacked() const;
+    bool writeList(const QString &, uint, uint) const;
+    bool writeChapterLists();
+    QString getChapterPath(int, const QString &) const;
+    static bool runFfmpeg(const QStringList &);
+    uint reportMissingParts();
+    QString getRecordingPath() const;
+    QString getPartPath(uint) const;
+    static bool isReadable(const RecordedPartsTracker::PartInfo &);
+};
+
+#endif // PROJECTCOMMANDS_H
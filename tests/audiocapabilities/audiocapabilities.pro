@@ -0,0 +1,14 @@
+QT += testlib
+QT -= gui
+
+CONFIG += qt console warn_on depend_includepath testcase
+CONFIG -= app_bundle
+
+TEMPLATE = app
+
+SOURCES +=  tst_audiocapabilitiestests.cpp \
+        ../../app/utilities/audiocapabilities.cpp
+HEADERS += ../../app/utilities/audiocapabilities.h
+INCLUDEPATH += \
+    ../../app \
+    ../../app/utilities
@@ -0,0 +1,80 @@
+#include "audiocapabilities.h"
+#include <QtTest>
+
+class AudioCapabilitiesTests : public QObject {
+    Q_OBJECT
+
+public:
+    AudioCapabilitiesTests();
+    ~AudioCapabilitiesTests();
+
+private slots:
+    void testSaveAndLoad();
+    void testLoadMissing();
+    void testLoadCorrupt();
+    void testFingerprint();
+
+private:
+    QTemporaryDir cacheDir;
+
+    static AudioCapabilities getExample();
+};
+
+AudioCapabilitiesTests::AudioCapabilitiesTests() {}
+
+AudioCapabilitiesTests::~AudioCapabilitiesTests() {}
+
+AudioCapabilities AudioCapabilitiesTests::getExample() {
+    AudioCapabilities capabilities;
+    capabilities.fingerprint = AudioCapabilities::getFingerprint();
+    capabilities.inputs = QStringList{"Built-in Microphone", "USB Headset"};
+    capabilities.codecs = QStringList{"audio/x-flac", "audio/x-vorbis"};
+    capabilities.containers = QStringList{"audio/ogg", "audio/x-wav"};
+    capabilities.sampleRates = QVector<int>{44100, 48000};
+
+    return capabilities;
+}
+
+void AudioCapabilitiesTests::testSaveAndLoad() {
+    const QString cachePath = cacheDir.filePath("nested/audio-capabilities");
+    const AudioCapabilities saved = getExample();
+    QVERIFY(saved.save(cachePath));
+
+    AudioCapabilities loaded;
+    QVERIFY(AudioCapabilities::load(cachePath, loaded));
+    QVERIFY(loaded == saved);
+}
+
+void AudioCapabilitiesTests::testLoadMissing() {
+    AudioCapabilities loaded = getExample();
+    QVERIFY(!AudioCapabilities::load(cacheDir.filePath("missing"), loaded));
+    QVERIFY(loaded == getExample());
+}
+
+void AudioCapabilitiesTests::testLoadCorrupt() {
+    const QString cachePath = cacheDir.filePath("corrupt");
+    QVERIFY(getExample().save(cachePath));
+
+    QFile cacheFile(cachePath);
+    QVERIFY(cacheFile.open(QIODevice::ReadWrite));
+    QVERIFY(cacheFile.resize(cacheFile.size() / 2));
+    cacheFile.close();
+
+    AudioCapabilities loaded;
+    QVERIFY(!AudioCapabilities::load(cachePath, loaded));
+    QVERIFY(loaded == AudioCapabilities());
+}
+
+void AudioCapabilitiesTests::testFingerprint() {
+    const QByteArray fingerprint = AudioCapabilities::getFingerprint();
+    QVERIFY(!fingerprint.isEmpty());
+    QVERIFY(AudioCapabilities::getFingerprint() == fingerprint);
+
+    AudioCapabilities stale = getExample();
+    stale.fingerprint = "stale";
+    QVERIFY(stale != getExample());
+}
+
+QTEST_APPLESS_MAIN(AudioCapabilitiesTests)
+
+#include "tst_audiocapabilitiestests.moc"
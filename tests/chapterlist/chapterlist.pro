@@ -0,0 +1,16 @@
+QT += testlib
+QT -= gui
+
+CONFIG += qt console warn_on depend_includepath testcase
+CONFIG -= app_bundle
+
+TEMPLATE = app
+
+SOURCES +=  tst_chapterlisttests.cpp \
+        ../../app/utilities/chapterlist.cpp \
+        ../../app/utilities/paragraphcounter.cpp
+HEADERS += ../../app/utilities/chapterlist.h \
+        ../../app/utilities/paragraphcounter.h
+INCLUDEPATH += \
+    ../../app \
+    ../../app/utilities
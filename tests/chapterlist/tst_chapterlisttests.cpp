@@ -0,0 +1,163 @@
+#include "chapterlist.h"
+#include "paragraphcounter.h"
+#include <QFile>
+#include <QTemporaryDir>
+#include <QtTest>
+
+class ChapterListTests : public QObject {
+    Q_OBJECT
+
+public:
+    ChapterListTests();
+    ~ChapterListTests();
+
+private slots:
+    void testCountChapters();
+    void testCountWithoutPatterns();
+    void testHeadingsInOneParagraph();
+    void testInvalidPattern();
+    void testGetPatternsKey();
+
+    void testGetEndPrg();
+    void testGetFileName();
+    void testWriteMetadata();
+
+private:
+    QTemporaryDir metadataDir;
+
+    // Front matter, two chapters, and a line that only starts like a heading.
+    const QString book = "Title Page. By Someone. Copyright. Dedication.\n"
+                         "CHAPTER ONE\n"
+                         "It was. A dark. Night. Really.\n"
+                         "She went. Home. Quickly. Now.\n"
+                         "\n"
+                         "Chapter 2: The Return\n"
+                         "He came. Back. Late. Again.\n"
+                         "Part of him stayed. Behind.";
+
+    QVector<ChapterList::Chapter> countChapters(const QString &,
+                                                const QStringList &);
+    static ChapterList::Chapter makeChapter(uint, const QString &);
+};
+
+ChapterListTests::ChapterListTests() {}
+
+ChapterListTests::~ChapterListTests() {}
+
+void ChapterListTests::testCountChapters() {
+    QString text = book;
+    QTextStream input(&text);
+    auto counts = ParagraphCounter::countText(
+        input, ChapterList::compilePatterns(ChapterList::getDefaultPatterns()));
+
+    QVERIFY(counts.numPrgs == 5);
+    QVERIFY(counts.chapters.size() == 3);
+    QVERIFY(counts.chapters[0] == makeChapter(0, ""));
+    QVERIFY(counts.chapters[1] == makeChapter(1, "CHAPTER ONE"));
+    QVERIFY(counts.chapters[2] == makeChapter(3, "Chapter 2: The Return"));
+}
+
+void ChapterListTests::testCountWithoutPatterns() {
+    QString text = book;
+    QTextStream input(&text);
+    auto counts = ParagraphCounter::countText(input, {});
+    QVERIFY(counts.chapters.isEmpty());
+
+    // Finding chapters does not change how paragraphs and words are counted.
+    QString sameText = book;
+    QTextStream sameInput(&sameText);
+    auto chapterCounts = ParagraphCounter::countText(
+        sameInput,
+        ChapterList::compilePatterns(ChapterList::getDefaultPatterns()));
+    QVERIFY(chapterCounts.numPrgs == counts.numPrgs);
+    QVERIFY(chapterCounts.wordCounts == counts.wordCounts);
+}
+
+void ChapterListTests::testHeadingsInOneParagraph() {
+    auto chapters = countChapters("PART ONE\nCHAPTER I\nIt begins.\n",
+                                  ChapterList::getDefaultPatterns());
+
+    QVERIFY(chapters.size() == 1);
+    QVERIFY(chapters[0] == makeChapter(0, "CHAPTER I"));
+}
+
+void ChapterListTests::testInvalidPattern() {
+    auto chapters =
+        countChapters("Act 1\nThey meet. Talk. Fight.\nAct 2\nThey part.",
+                      {"^act [0-9]+$", "(unclosed", ""});
+
+    QVERIFY(chapters.size() == 2);
+    QVERIFY(chapters[1].title == "Act 2");
+}
+
+// A project's chapters are only found again when the patterns changed.
+void ChapterListTests::testGetPatternsKey() {
+    const QStringList patterns = ChapterList::getDefaultPatterns();
+    const QString key = ChapterList::getPatternsKey(patterns);
+
+    QVERIFY(!key.isEmpty());
+    QVERIFY(ChapterList::getPatternsKey(patterns) == key);
+    QVERIFY(ChapterList::getPatternsKey(patterns.mid(1)) != key);
+}
+
+void ChapterListTests::testGetEndPrg() {
+    QVector<ChapterList::Chapter> chapters = {makeChapter(0, ""),
+                                              makeChapter(4, "Two")};
+
+    QVERIFY(ChapterList::getEndPrg(chapters, 0, 10) == 4);
+    QVERIFY(ChapterList::getEndPrg(chapters, 1, 10) == 10);
+    QVERIFY(ChapterList::getEndPrg(chapters, 0, 2) == 2);
+}
+
+void ChapterListTests::testGetFileName() {
+    QVector<ChapterList::Chapter> chapters = {
+        makeChapter(0, ""), makeChapter(4, "Chapter 1: Here/There?")};
+
+    QVERIFY(ChapterList::getFileName(chapters, 0) == "01");
+    QVERIFY(ChapterList::getFileName(chapters, 1) ==
+            "02 Chapter 1_ Here_There_");
+}
+
+void ChapterListTests::testWriteMetadata() {
+    QVector<ChapterList::Chapter> chapters = {
+        makeChapter(0, ""), makeChapter(1, "One"), makeChapter(3, "Two=2")};
+    const QString metadataPath =
+        ChapterList::getMetadataPath(metadataDir.path());
+
+    // The fourth part was never recorded.
+    QVERIFY(ChapterList::writeMetadata(metadataPath, "Book", chapters,
+                                       {1000, 2000, 3000, 0, 500}));
+
+    QFile metadataFile(metadataPath);
+    QVERIFY(metadataFile.open(QIODevice::ReadOnly | QIODevice::Text));
+    const QString metadata = QString::fromUtf8(metadataFile.readAll());
+
+    QVERIFY(metadata.startsWith(";FFMETADATA1\ntitle=Book\n"));
+    QVERIFY(metadata.contains("START=0\nEND=1000\n\n"));
+    QVERIFY(metadata.contains("START=1000\nEND=6000\ntitle=One\n"));
+    QVERIFY(metadata.contains("START=6000\nEND=6500\ntitle=Two\\=2\n"));
+}
+
+QVector<ChapterList::Chapter>
+ChapterListTests::countChapters(const QString &text,
+                                const QStringList &patterns) {
+    QString textCopy = text;
+    QTextStream input(&textCopy);
+
+    return ParagraphCounter::countText(input,
+                                       ChapterList::compilePatterns(patterns))
+        .chapters;
+}
+
+ChapterList::Chapter ChapterListTests::makeChapter(uint firstPrg,
+                                                   const QString &title) {
+    ChapterList::Chapter chapter;
+    chapter.firstPrg = firstPrg;
+    chapter.title = title;
+
+    return chapter;
+}
+
+QTEST_APPLESS_MAIN(ChapterListTests)
+
+#include "tst_chapterlisttests.moc"
@@ -0,0 +1,16 @@
+QT += testlib
+QT -= gui
+
+CONFIG += qt console warn_on depend_includepath testcase
+CONFIG -= app_bundle
+
+TEMPLATE = app
+
+SOURCES +=  tst_diagnosticsreporttests.cpp \
+        ../../app/utilities/diagnosticsreport.cpp \
+        ../../app/utilities/stallmonitor.cpp
+HEADERS += ../../app/utilities/diagnosticsreport.h \
+        ../../app/utilities/stallmonitor.h
+INCLUDEPATH += \
+    ../../app \
+    ../../app/utilities
@@ -0,0 +1,91 @@
+#include "diagnosticsreport.h"
+#include "stallmonitor.h"
+#include <QtTest>
+
+class DiagnosticsReportTests : public QObject {
+    Q_OBJECT
+
+public:
+    DiagnosticsReportTests();
+    ~DiagnosticsReportTests();
+
+private slots:
+    void testFormatBytes();
+    void testTotalBytes();
+    void testRatio();
+    void testSections();
+
+    void testStallBuckets();
+    void testStallHistogram();
+};
+
+DiagnosticsReportTests::DiagnosticsReportTests() {}
+
+DiagnosticsReportTests::~DiagnosticsReportTests() {}
+
+void DiagnosticsReportTests::testFormatBytes() {
+    QVERIFY(DiagnosticsReport::formatBytes(512) == "512 B");
+    QVERIFY(DiagnosticsReport::formatBytes(1536) == "1.5 KB");
+    QVERIFY(DiagnosticsReport::formatBytes(3 * 1024 * 1024) == "3.0 MB");
+    QVERIFY(DiagnosticsReport::formatBytes(5LL * 1024 * 1024 * 1024) ==
+            "5.00 GB");
+}
+
+void DiagnosticsReportTests::testTotalBytes() {
+    DiagnosticsReport report;
+    report.addBytes("Paragraphs", 1024);
+    report.addBytes("Word counts", 512);
+
+    QVERIFY(report.getTotalBytes() == 1536);
+    QVERIFY(report.toText().contains(QRegularExpression("Total +1.5 KB\n")));
+}
+
+void DiagnosticsReportTests::testRatio() {
+    DiagnosticsReport report;
+    report.addRatio("Caches", "Paragraph text", 3, 1);
+    report.addRatio("Caches", "Unused", 0, 0);
+
+    const QString text = report.toText();
+    QVERIFY(text.contains("75.0% hits (3 of 4)"));
+    QVERIFY(text.contains("no lookups"));
+}
+
+void DiagnosticsReportTests::testSections() {
+    DiagnosticsReport report;
+    report.addCount("Index", "Paragraphs found", 10);
+    report.addBytes("Paragraphs", 100);
+    report.addCount("Index", "Chapters", 2);
+
+    const QString text = report.toText();
+    QVERIFY(text.startsWith("Index\n"));
+    QVERIFY(text.indexOf("Chapters") < text.indexOf("Memory\n"));
+}
+
+void DiagnosticsReportTests::testStallBuckets() {
+    QVERIFY(StallMonitor::getBucket(0) == 0);
+    QVERIFY(StallMonitor::getBucket(15) == 0);
+    QVERIFY(StallMonitor::getBucket(16) == 1);
+    QVERIFY(StallMonitor::getBucket(999) == 4);
+    QVERIFY(StallMonitor::getBucket(5000) == 5);
+
+    const QStringList bucketNames = StallMonitor::getBucketNames();
+    QVERIFY(bucketNames.size() == 6);
+    QVERIFY(bucketNames.first() == "0-16 ms");
+    QVERIFY(bucketNames.last() == "1000+ ms");
+}
+
+void DiagnosticsReportTests::testStallHistogram() {
+    StallMonitor stallMonitor;
+    stallMonitor.addStall(2);
+    stallMonitor.addStall(3);
+    stallMonitor.addStall(300);
+
+    const QVector<qint64> histogram = stallMonitor.getHistogram();
+    QVERIFY(histogram[0] == 2);
+    QVERIFY(histogram[4] == 1);
+    QVERIFY(stallMonitor.getLongestStallMs() == 300);
+}
+
+QTEST_APPLESS_MAIN(DiagnosticsReportTests)
+
+#include "tst_diagnosticsreporttests.moc"
@@ -0,0 +1,21 @@
+QT += testlib
+QT -= gui
+
+CONFIG += qt console warn_on depend_includepath testcase
+CONFIG -= app_bundle
+
+TEMPLATE = app
+
+SOURCES +=  tst_importedtexttests.cpp \
+        ../../app/utilities/importedtext.cpp \
+        ../../app/utilities/markupstripper.cpp \
+        ../../app/utilities/ziparchive.cpp
+HEADERS += ../../app/utilities/importedtext.h \
+        ../../app/utilities/markupstripper.h \
+        ../../app/utilities/ziparchive.h
+INCLUDEPATH += \
+    ../../app \
+    ../../app/utilities
+
+unix: LIBS += -lz
+win32: INCLUDEPATH += $$[QT_INSTALL_HEADERS]/QtZlib
@@ -0,0 +1,259 @@
+#include "importedtext.h"
+#include "markupstripper.h"
+#include "ziparchive.h"
+#include <QtTest>
+
+class ImportedTextTests : public QObject {
+    Q_OBJECT
+
+public:
+    ImportedTextTests();
+    ~ImportedTextTests();
+
+private slots:
+    void testStripHtml();
+    void testStripMarkdown();
+    void testStripInPieces();
+    void testReadEpub();
+    void testSeekBack();
+    void testSourcePosition();
+    void testReadEntryPastItsSize();
+
+private:
+    QTemporaryDir bookDir;
+
+    static QByteArray strip(MarkupStripper::Format, const QByteArray &, int);
+    static bool writeEpub(const QString &);
+    static bool writeZip(const QString &,
+                         const QVector<std::pair<QString, QByteArray>> &,
+                         bool = false);
+    static QByteArray getSecondChapter();
+};
+
+static const QByteArray htmlBook =
+    "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<!DOCTYPE html>\n"
+    "<html><head><title>Title</title><style>p { margin: 0; }</style>"
+    "</head><body>\n<h1 class=\"a>b\">Chapter 1</h1>\n"
+    "<p>It was &ldquo;late&rdquo;.<br/>Very   late &amp; AT&T.</p>"
+    "<!-- a note --><p>Then a < b.</p></body></html>";
+
+static const QByteArray markdownBook =
+    "# Chapter 1\n\nIt was *very* late, said [Hale](http://x.org).\n\n"
+    "* * *\n\n- One_two item\n```\ncode\n```\n1. The end!\n"
+    "> _Quoted_ \\*star\\*\r\n";
+
+ImportedTextTests::ImportedTextTests() {}
+
+ImportedTextTests::~ImportedTextTests() {}
+
+QByteArray ImportedTextTests::strip(MarkupStripper::Format format,
+                                    const QByteArray &source, int pieceSize) {
+    MarkupStripper stripper(format);
+    QByteArray text;
+    for (int start = 0; start < source.size(); start += pieceSize)
+        stripper.strip(source.constData() + start,
+                       qMin(pieceSize, source.size() - start), text);
+    stripper.endDocument(text);
+
+    return text;
+}
+
+QByteArray ImportedTextTests::getSecondChapter() {
+    return "<html><body><h1>Chapter Two</h1><p>The end.</p></body></html>";
+}
+
+bool ImportedTextTests::writeEpub(const QString &epubPath) {
+    return writeZip(epubPath, {
+        {"mimetype", "application/epub+zip"},
+        {"META-INF/container.xml",
+         "<?xml version=\"1.0\"?><container><rootfiles>"
+         "<rootfile full-path=\"OEBPS/content.opf\"/></rootfiles></container>"},
+        {"OEBPS/content.opf",
+         "<?xml version=\"1.0\"?><package><manifest>"
+         "<item id=\"nav\" href=\"nav.xhtml\" "
+         "media-type=\"application/xhtml+xml\"/>"
+         "<item id=\"two\" href=\"text/ch%202.xhtml\" "
+         "media-type=\"application/xhtml+xml\"/>"
+         "<item id=\"one\" href=\"text/ch1.xhtml#start\" "
+         "media-type=\"application/xhtml+xml\"/>"
+         "<item id=\"css\" href=\"style.css\" media-type=\"text/css\"/>"
+         "</manifest><spine><itemref idref=\"nav\" linear=\"no\"/>"
+         "<itemref idref=\"one\"/><itemref idref=\"two\"/></spine>"
+         "</package>"},
+        {"OEBPS/nav.xhtml", "<html><body><p>Contents</p></body></html>"},
+        {"OEBPS/text/ch1.xhtml",
+         "<html><body><h1>Chapter One</h1><p>It was late.</p></body></html>"},
+        {"OEBPS/text/ch 2.xhtml", getSecondChapter()},
+        {"OEBPS/style.css", "p { margin: 0; }"}});
+}
+
+// Stores the mimetype as EPUBs do and deflates the rest. qCompress() wraps
+// raw deflate data in a size, a zlib header and a checksum, which ZIP
+// entries leave out. Deflated entries can claim to be empty, as a crafted
+// archive might.
+bool ImportedTextTests::writeZip(
+    const QString &zipPath,
+    const QVector<std::pair<QString, QByteArray>> &entries,
+    bool isSizeHidden) {
+    QFile epubFile(zipPath);
+    if (!epubFile.open(QIODevice::WriteOnly))
+        return false;
+
+    QDataStream epubOutput(&epubFile);
+    epubOutput.setByteOrder(QDataStream::LittleEndian);
+
+    QByteArray directory;
+    QDataStream directoryOutput(&directory, QIODevice::WriteOnly);
+    directoryOutput.setByteOrder(QDataStream::LittleEndian);
+
+    for (int i = 0; i < entries.size(); i++) {
+        const QByteArray name = entries[i].first.toUtf8();
+        const QByteArray &data = entries[i].second;
+        const quint16 method = entries[i].first == "mimetype" ? 0 : 8;
+        QByteArray stored = data;
+        if (method == 8) {
+            stored = qCompress(data);
+            stored = stored.mid(6, stored.size() - 10);
+        }
+        const quint32 size =
+            method == 8 && isSizeHidden ? 0 : quint32(data.size());
+
+        const quint32 headerOffset = static_cast<quint32>(epubFile.pos());
+        epubOutput << quint32(0x04034b50) << quint16(20) << quint16(0x0800)
+                   << method << quint32(0) << quint32(0)
+                   << quint32(stored.size()) << size
+                   << quint16(name.size()) << quint16(0);
+        epubOutput.writeRawData(name.constData(), name.size());
+        epubOutput.writeRawData(stored.constData(), stored.size());
+
+        directoryOutput << quint32(0x02014b50) << quint16(20) << quint16(20)
+                        << quint16(0x0800) << method << quint32(0)
+                        << quint32(0) << quint32(stored.size()) << size
+                        << quint16(name.size())
+                        << quint16(0) << quint16(0) << quint16(0)
+                        << quint16(0) << quint32(0) << headerOffset;
+        directoryOutput.writeRawData(name.constData(), name.size());
+    }
+
+    const quint32 directoryOffset = static_cast<quint32>(epubFile.pos());
+    epubOutput.writeRawData(directory.constData(), directory.size());
+    epubOutput << quint32(0x06054b50) << quint16(0) << quint16(0)
+               << quint16(entries.size()) << quint16(entries.size())
+               << quint32(directory.size()) << directoryOffset << quint16(0);
+
+    return epubOutput.status() == QDataStream::Ok;
+}
+
+void ImportedTextTests::testStripHtml() {
+    QVERIFY(strip(MarkupStripper::Html, htmlBook, htmlBook.size()) ==
+            "Chapter 1\n\nIt was “late”.\nVery late & AT&T.\n\n"
+            "Then a < b.");
+}
+
+void ImportedTextTests::testStripMarkdown() {
+    QVERIFY(strip(MarkupStripper::Markdown, markdownBook,
+                  markdownBook.size()) ==
+            "Chapter 1\n\nIt was very late, said Hale.\n\nOne_two item\n"
+            "code\nThe end!\nQuoted *star*\n");
+}
+
+// Where the source is cut into pieces must not change the text.
+void ImportedTextTests::testStripInPieces() {
+    for (int pieceSize : {1, 2, 7}) {
+        QVERIFY(strip(MarkupStripper::Html, htmlBook, pieceSize) ==
+                strip(MarkupStripper::Html, htmlBook, htmlBook.size()));
+        QVERIFY(strip(MarkupStripper::Markdown, markdownBook, pieceSize) ==
+                strip(MarkupStripper::Markdown, markdownBook,
+                      markdownBook.size()));
+    }
+}
+
+void ImportedTextTests::testReadEpub() {
+    const QString epubPath = bookDir.filePath("book.epub");
+    QVERIFY(writeEpub(epubPath));
+
+    ImportedText importedText;
+    QVERIFY(importedText.openText(epubPath));
+    QVERIFY(importedText.getDocuments() ==
+            QStringList({"OEBPS/text/ch1.xhtml", "OEBPS/text/ch 2.xhtml"}));
+
+    const QByteArray text = importedText.readAll();
+    QVERIFY(text ==
+            "Chapter One\n\nIt was late.\n\nChapter Two\n\nThe end.");
+    QVERIFY(importedText.size() == text.size());
+}
+
+// Seeking back past the text that is kept makes it again from a checkpoint,
+// which has to give the same text as reading straight through.
+void ImportedTextTests::testSeekBack() {
+    QByteArray html = "<html><body>";
+    for (int i = 0; i < 20000; i++)
+        html += QString("<p>Paragraph %1 &mdash; is <em>here</em>.</p>\n")
+                    .arg(i)
+                    .toUtf8();
+    html += "</body></html>";
+
+    const QString htmlPath = bookDir.filePath("long.html");
+    QFile htmlFile(htmlPath);
+    QVERIFY(htmlFile.open(QIODevice::WriteOnly));
+    htmlFile.write(html);
+    htmlFile.close();
+
+    const QByteArray expected = strip(MarkupStripper::Html, html, html.size());
+    QVERIFY(expected.size() > 4 * ImportedText::windowSize);
+
+    ImportedText importedText;
+    QVERIFY(importedText.openText(htmlPath));
+    QVERIFY(importedText.readAll() == expected);
+
+    for (qint64 pos : {qint64(expected.size()) - 10, qint64(5), qint64(200000),
+                       qint64(ImportedText::checkpointInterval) - 1,
+                       qint64(199000)}) {
+        QVERIFY(importedText.seek(pos));
+        QVERIFY(importedText.read(100) == expected.mid(pos, 100));
+    }
+
+    QTextStream textInput(&importedText);
+    textInput.setCodec("UTF-8");
+    textInput.seek(150000);
+    textInput.readLine();
+    const qint64 linePos = textInput.pos();
+    textInput.seek(linePos);
+    QVERIFY(textInput.readLine() ==
+            QString::fromUtf8(expected.mid(linePos).split('\n').front()));
+}
+
+void ImportedTextTests::testSourcePosition() {
+    const QString epubPath = bookDir.filePath("traced.epub");
+    QVERIFY(writeEpub(epubPath));
+
+    ImportedText importedText;
+    QVERIFY(importedText.openText(epubPath));
+    const QByteArray text = importedText.readAll();
+
+    const ImportedText::SourcePosition position =
+        importedText.getSourcePosition(text.indexOf("The end"));
+    QVERIFY(position.document == "OEBPS/text/ch 2.xhtml");
+    QVERIFY(position.offset == getSecondChapter().indexOf("The end"));
+
+    QVERIFY(importedText.getSourcePosition(text.size()).offset == -1);
+}
+
+// An entry that inflates past the limit is not read, even when the archive
+// claims it is small.
+void ImportedTextTests::testReadEntryPastItsSize() {
+    const QString zipPath = bookDir.filePath("understated.zip");
+    const QByteArray data(64 * 1024, 'a');
+    QVERIFY(writeZip(zipPath, {{"big.txt", data}}, true));
+
+    QFile zipFile(zipPath);
+    QVERIFY(zipFile.open(QIODevice::ReadOnly));
+    ZipArchive archive;
+    QVERIFY(archive.open(&zipFile));
+    QVERIFY(archive.readEntry(0, 1024).isEmpty());
+    QVERIFY(archive.readEntry(0, data.size()) == data);
+}
+
+QTEST_APPLESS_MAIN(ImportedTextTests)
+
+#include "tst_importedtexttests.moc"
@@ -0,0 +1,16 @@
+QT += testlib
+QT -= gui
+
+CONFIG += qt console warn_on depend_includepath testcase
+CONFIG -= app_bundle
+
+TEMPLATE = app
+
+SOURCES +=  tst_narrationstatstests.cpp \
+        ../../app/utilities/narrationstats.cpp \
+        ../../app/utilities/recordedpartstracker.cpp
+HEADERS += ../../app/utilities/narrationstats.h \
+        ../../app/utilities/recordedpartstracker.h
+INCLUDEPATH += \
+    ../../app \
+    ../../app/utilities
@@ -0,0 +1,120 @@
+#include "narrationstats.h"
+#include <QtTest>
+
+class NarrationStatsTests : public QObject {
+    Q_OBJECT
+
+public:
+    NarrationStatsTests();
+    ~NarrationStatsTests();
+
+private slots:
+    void testEmpty();
+    void testAddParts();
+    void testRemoveParts();
+    void testUntimedParts();
+    void testRecompute();
+    void testPartsPastTheText();
+
+private:
+    // Four paragraphs of 100, 200, 300 and 400 words.
+    static NarrationStats makeStats();
+};
+
+NarrationStatsTests::NarrationStatsTests() {}
+
+NarrationStatsTests::~NarrationStatsTests() {}
+
+NarrationStats NarrationStatsTests::makeStats() {
+    NarrationStats stats;
+    stats.setWordCounts({100, 200, 300, 400});
+
+    return stats;
+}
+
+void NarrationStatsTests::testEmpty() {
+    const NarrationStats stats = makeStats();
+
+    QVERIFY(stats.getRecordedMs() == 0);
+    QVERIFY(stats.getWordsPerMinute() == 0);
+    QVERIFY(stats.getRemainingMs() == 0);
+    QVERIFY(stats.getWordCounts().size() == 4);
+}
+
+// 300 words in two minutes is 150 a minute, which leaves 700 words taking
+// four minutes and forty seconds.
+void NarrationStatsTests::testAddParts() {
+    NarrationStats stats = makeStats();
+    stats.addPart(0, 40 * 1000);
+    stats.addPart(1, 80 * 1000);
+
+    QVERIFY(stats.getRecordedMs() == 120 * 1000);
+    QVERIFY(stats.getWordsPerMinute() == 150);
+    QVERIFY(stats.getRemainingMs() == 280 * 1000);
+
+    stats.addPart(2, 120 * 1000);
+    stats.addPart(3, 160 * 1000);
+    QVERIFY(stats.getRemainingMs() == 0);
+}
+
+// Removing a part undoes adding it, as recording a paragraph again does.
+void NarrationStatsTests::testRemoveParts() {
+    NarrationStats stats = makeStats();
+    stats.addPart(0, 40 * 1000);
+    stats.addPart(1, 80 * 1000);
+    stats.removePart(1, 80 * 1000);
+
+    QVERIFY(stats.getRecordedMs() == 40 * 1000);
+    QVERIFY(stats.getWordsPerMinute() == 150);
+    QVERIFY(stats.getRemainingMs() == 360 * 1000);
+
+    stats.removePart(0, 40 * 1000);
+    QVERIFY(stats.getRecordedMs() == 0);
+    QVERIFY(stats.getRemainingMs() == 0);
+
+    // Never goes below nothing, however often a part is removed.
+    stats.removePart(0, 40 * 1000);
+    QVERIFY(stats.getRecordedMs() == 0);
+    QVERIFY(stats.getWordsPerMinute() == 0);
+}
+
+// A part without a duration counts as recorded, but not towards the pace.
+void NarrationStatsTests::testUntimedParts() {
+    NarrationStats stats = makeStats();
+    stats.addPart(0, 40 * 1000);
+    stats.addPart(3, 0);
+
+    QVERIFY(stats.getRecordedMs() == 40 * 1000);
+    QVERIFY(stats.getWordsPerMinute() == 150);
+    QVERIFY(stats.getRemainingMs() == 200 * 1000);
+
+    stats.removePart(3, 0);
+    QVERIFY(stats.getRemainingMs() == 360 * 1000);
+}
+
+void NarrationStatsTests::testRecompute() {
+    RecordedPartsTracker recordedParts;
+    recordedParts.markRecorded(0, 1000, 40 * 1000);
+    recordedParts.markRecorded(1, 1000, 80 * 1000);
+
+    NarrationStats stats = makeStats();
+    stats.addPart(3, 1000);
+    stats.recompute(recordedParts);
+
+    QVERIFY(stats.getRecordedMs() == 120 * 1000);
+    QVERIFY(stats.getWordsPerMinute() == 150);
+    QVERIFY(stats.getRemainingMs() == 280 * 1000);
+}
+
+void NarrationStatsTests::testPartsPastTheText() {
+    NarrationStats stats = makeStats();
+    stats.addPart(0, 40 * 1000);
+    stats.addPart(10, 60 * 1000);
+
+    QVERIFY(stats.getRecordedMs() == 100 * 1000);
+    QVERIFY(stats.getWordsPerMinute() == 60);
+}
+
+QTEST_APPLESS_MAIN(NarrationStatsTests)
+
+#include "tst_narrationstatstests.moc"
@@ -0,0 +1,14 @@
+QT += testlib
+QT -= gui
+
+CONFIG += qt console warn_on depend_includepath testcase
+CONFIG -= app_bundle
+
+TEMPLATE = app
+
+SOURCES +=  tst_noisereducertests.cpp \
+        ../../app/utilities/noisereducer.cpp
+HEADERS += ../../app/utilities/noisereducer.h
+INCLUDEPATH += \
+    ../../app \
+    ../../app/utilities
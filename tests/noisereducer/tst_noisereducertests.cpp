@@ -0,0 +1,168 @@
+#include "noisereducer.h"
+#include <QVector>
+#include <QtMath>
+#include <QtTest>
+#include <random>
+
+class NoiseReducerTests : public QObject {
+    Q_OBJECT
+
+public:
+    NoiseReducerTests();
+    ~NoiseReducerTests();
+
+private slots:
+    void testPassThroughWithoutProfile();
+    void testProfileFromPauses();
+    void testNoProfileWithoutPauses();
+    void testReduceNoiseInPauses();
+    void testCombineProfiles();
+
+private:
+    static const int sampleRate = 8000;
+
+    // Speech is stood in for by a tone in every other half second, over
+    // noise that never stops.
+    static QVector<float> makeTake(double);
+    static bool isSpeaking(int);
+    static QVector<float> reduce(const NoiseProfile &, const QVector<float> &,
+                                 int, int);
+};
+
+NoiseReducerTests::NoiseReducerTests() {}
+
+NoiseReducerTests::~NoiseReducerTests() {}
+
+QVector<float> NoiseReducerTests::makeTake(double seconds) {
+    std::mt19937 generator(7);
+    std::normal_distribution<float> noise(0.0f, 0.01f);
+
+    QVector<float> samples;
+    for (int sample = 0; sample < seconds * sampleRate; sample++) {
+        float value = noise(generator);
+        if (isSpeaking(sample))
+            value += 0.5f * qSin(2 * M_PI * 440 * sample / sampleRate);
+        samples.append(value);
+    }
+
+    return samples;
+}
+
+bool NoiseReducerTests::isSpeaking(int sample) {
+    return (sample / (sampleRate / 2)) % 2 == 0;
+}
+
+// Streams the samples through in blocks of the given size, as decoding does.
+QVector<float> NoiseReducerTests::reduce(const NoiseProfile &profile,
+                                         const QVector<float> &samples,
+                                         int channelCount, int blockSize) {
+    NoiseReducer reducer(profile, channelCount);
+    QVector<float> output;
+    for (int start = 0; start < samples.size(); start += blockSize)
+        reducer.process(samples.constData() + start,
+                        qMin(blockSize, samples.size() - start), output);
+    reducer.finish(output);
+
+    return output;
+}
+
+void NoiseReducerTests::testPassThroughWithoutProfile() {
+    std::mt19937 generator(3);
+    std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+
+    for (int channelCount = 1; channelCount <= 2; channelCount++) {
+        QVector<float> samples;
+        for (int sample = 0; sample < 10007 * channelCount; sample++)
+            samples.append(distribution(generator));
+
+        const QVector<float> output =
+            reduce(NoiseProfile(), samples, channelCount, 333 * channelCount);
+        QVERIFY(output.size() == samples.size());
+        for (int sample = 0; sample < samples.size(); sample++)
+            QVERIFY(qAbs(output[sample] - samples[sample]) < 1e-5f);
+    }
+}
+
+void NoiseReducerTests::testProfileFromPauses() {
+    const QVector<float> samples = makeTake(4.0);
+
+    NoiseProfiler profiler(sampleRate, 1);
+    profiler.add(samples.constData(), samples.size());
+    const NoiseProfile profile = profiler.getProfile();
+
+    QVERIFY(profile.isValid());
+    QVERIFY(profile.sampleRate == sampleRate);
+    QVERIFY(profile.magnitudes.size() == NoiseReducer::numBins);
+    QVERIFY(profile.numFrames >= NoiseProfiler::minNoiseFrames);
+}
+
+// A take that never pauses has nothing to tell the noise apart by.
+void NoiseReducerTests::testNoProfileWithoutPauses() {
+    QVector<float> samples;
+    for (int sample = 0; sample < 4 * sampleRate; sample++)
+        samples.append(0.5f * qSin(2 * M_PI * 440 * sample / sampleRate));
+
+    NoiseProfiler profiler(sampleRate, 1);
+    profiler.add(samples.constData(), samples.size());
+
+    QVERIFY(!profiler.getProfile().isValid());
+}
+
+void NoiseReducerTests::testReduceNoiseInPauses() {
+    const QVector<float> samples = makeTake(4.0);
+
+    NoiseProfiler profiler(sampleRate, 1);
+    profiler.add(samples.constData(), samples.size());
+    const QVector<float> output =
+        reduce(profiler.getProfile(), samples, 1, 4096);
+    QVERIFY(output.size() == samples.size());
+
+    // The tone spills a frame into the pauses on either side, so only their
+    // middles are measured.
+    const int pauseLength = sampleRate / 2;
+    double pauseBefore = 0.0;
+    double pauseAfter = 0.0;
+    double speechBefore = 0.0;
+    double speechAfter = 0.0;
+    for (int sample = 0; sample < samples.size(); sample++) {
+        const double before = samples[sample] * samples[sample];
+        const double after = output[sample] * output[sample];
+        if (isSpeaking(sample)) {
+            speechBefore += before;
+            speechAfter += after;
+        } else if (qAbs(sample % pauseLength - pauseLength / 2) <
+                   pauseLength / 2 - NoiseReducer::frameSize) {
+            pauseBefore += before;
+            pauseAfter += after;
+        }
+    }
+
+    QVERIFY(pauseAfter < pauseBefore / 10);
+    QVERIFY(speechAfter > speechBefore * 0.9);
+}
+
+void NoiseReducerTests::testCombineProfiles() {
+    NoiseProfile quiet;
+    quiet.sampleRate = sampleRate;
+    quiet.numFrames = 30;
+    quiet.magnitudes.fill(1.0f, NoiseReducer::numBins);
+
+    NoiseProfile loud = quiet;
+    loud.numFrames = 10;
+    loud.magnitudes.fill(5.0f);
+
+    NoiseProfile otherRate = loud;
+    otherRate.sampleRate = sampleRate * 2;
+
+    const NoiseProfile combined =
+        NoiseProfile::combine({NoiseProfile(), quiet, loud, otherRate});
+    QVERIFY(combined.numFrames == 40);
+    QVERIFY(combined.sampleRate == sampleRate);
+    QVERIFY(qAbs(combined.magnitudes[0] - 2.0f) < 1e-5f);
+
+    QVERIFY(!NoiseProfile::combine({}).isValid());
+}
+
+QTEST_APPLESS_MAIN(NoiseReducerTests)
+
+#include "tst_noisereducertests.moc"
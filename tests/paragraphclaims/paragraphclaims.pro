@@ -0,0 +1,14 @@
+QT += testlib concurrent
+QT -= gui
+
+CONFIG += qt console warn_on depend_includepath testcase
+CONFIG -= app_bundle
+
+TEMPLATE = app
+
+SOURCES +=  tst_paragraphclaimstests.cpp \
+        ../../app/utilities/paragraphclaims.cpp
+HEADERS += ../../app/utilities/paragraphclaims.h
+INCLUDEPATH += \
+    ../../app \
+    ../../app/utilities
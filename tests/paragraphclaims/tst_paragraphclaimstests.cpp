@@ -0,0 +1,172 @@
+#include "paragraphclaims.h"
+#include <QTemporaryDir>
+#include <QThread>
+#include <QVector>
+#include <QtConcurrent>
+#include <QtTest>
+#include <memory>
+#include <vector>
+
+class ParagraphClaimsTests : public QObject {
+    Q_OBJECT
+
+public:
+    ParagraphClaimsTests();
+    ~ParagraphClaimsTests();
+
+private slots:
+    void init();
+
+    void testOpenTwoSessions();
+    void testClaimIsExclusive();
+    void testFailedClaimKeepsNothing();
+    void testCloseReleasesClaims();
+    void testTakeOverStaleSession();
+    void testRacingSessions();
+
+private:
+    QTemporaryDir claimsDir;
+    QString claimsPath;
+
+    static const uint numPrgs = 1000;
+};
+
+ParagraphClaimsTests::ParagraphClaimsTests() {}
+
+ParagraphClaimsTests::~ParagraphClaimsTests() {}
+
+// Every test starts without a claims file.
+void ParagraphClaimsTests::init() {
+    claimsPath = ParagraphClaims::getClaimsPath(claimsDir.path());
+    QFile::remove(claimsPath);
+}
+
+void ParagraphClaimsTests::testOpenTwoSessions() {
+    ParagraphClaims first;
+    ParagraphClaims second;
+
+    QVERIFY(first.open(claimsPath, numPrgs));
+    QVERIFY(second.open(claimsPath, numPrgs));
+    QVERIFY(first.isOpen());
+    QVERIFY(first.getNumSessions() == 2);
+    QVERIFY(second.getNumSessions() == 2);
+}
+
+void ParagraphClaimsTests::testClaimIsExclusive() {
+    ParagraphClaims first;
+    ParagraphClaims second;
+    QVERIFY(first.open(claimsPath, numPrgs));
+    QVERIFY(second.open(claimsPath, numPrgs));
+
+    QVERIFY(first.claim(0, 10));
+    QVERIFY(first.claim(5, 12));
+    QVERIFY(!second.claim(11, 20));
+    QVERIFY(second.claim(12, 20));
+
+    QVERIFY(first.isClaimed(11));
+    QVERIFY(!first.isClaimedByOther(11));
+    QVERIFY(second.isClaimedByOther(11));
+    QVERIFY(first.isClaimedByOther(12));
+    QVERIFY(!first.isClaimedByOther(20));
+    QVERIFY(first.getNumClaimed() == 12u);
+    QVERIFY(second.getNumClaimed() == 8u);
+
+    first.release(0, 5);
+    QVERIFY(second.claim(0, 5));
+}
+
+// A range that runs into another session's claim is given back whole, but
+// what the session held before stays held.
+void ParagraphClaimsTests::testFailedClaimKeepsNothing() {
+    ParagraphClaims first;
+    ParagraphClaims second;
+    QVERIFY(first.open(claimsPath, numPrgs));
+    QVERIFY(second.open(claimsPath, numPrgs));
+
+    QVERIFY(first.claim(50, 51));
+    QVERIFY(second.claim(40, 42));
+    QVERIFY(!second.claim(40, 60));
+
+    QVERIFY(second.getNumClaimed() == 2u);
+    QVERIFY(second.isClaimed(40));
+    QVERIFY(!second.isClaimed(45));
+    QVERIFY(!first.isClaimedByOther(45));
+}
+
+void ParagraphClaimsTests::testCloseReleasesClaims() {
+    ParagraphClaims first;
+    ParagraphClaims second;
+    QVERIFY(first.open(claimsPath, numPrgs));
+    QVERIFY(second.open(claimsPath, numPrgs));
+
+    QVERIFY(first.claim(0, numPrgs));
+    QVERIFY(!second.claim(0, 1));
+
+    first.close();
+    QVERIFY(!first.isOpen());
+    QVERIFY(second.getNumSessions() == 1);
+    QVERIFY(second.claim(0, numPrgs));
+}
+
+// A session that stops beating, as one that crashed would, loses its claims
+// to whoever asks once it is stale, and joins again when it beats.
+void ParagraphClaimsTests::testTakeOverStaleSession() {
+    ParagraphClaims stalled(100);
+    ParagraphClaims live(100);
+    QVERIFY(stalled.open(claimsPath, numPrgs));
+    QVERIFY(live.open(claimsPath, numPrgs));
+
+    QVERIFY(stalled.claim(0, 10));
+    QVERIFY(!live.claim(0, 10));
+
+    QThread::msleep(200);
+    live.heartbeat();
+    QVERIFY(live.getNumSessions() == 1);
+    QVERIFY(live.claim(0, 10));
+    QVERIFY(!stalled.isClaimed(0));
+
+    stalled.heartbeat();
+    QVERIFY(live.getNumSessions() == 2);
+    QVERIFY(!stalled.claim(0, 1));
+}
+
+// Sessions claiming the same ranges at once each get every range or none.
+void ParagraphClaimsTests::testRacingSessions() {
+    const int numSessions = 8;
+    const uint rangeSize = 10;
+
+    std::vector<std::unique_ptr<ParagraphClaims>> sessions;
+    for (int session = 0; session < numSessions; session++) {
+        sessions.emplace_back(new ParagraphClaims);
+        QVERIFY(sessions.back()->open(claimsPath, numPrgs));
+    }
+
+    QVector<QFuture<void>> claimRuns;
+    for (auto &session : sessions) {
+        ParagraphClaims *claims = session.get();
+        claimRuns.append(QtConcurrent::run([claims, rangeSize]() {
+            for (uint prg = 0; prg < numPrgs; prg += rangeSize)
+                claims->claim(prg, prg + rangeSize);
+        }));
+    }
+    for (QFuture<void> &claimRun : claimRuns)
+        claimRun.waitForFinished();
+
+    uint numClaimed = 0;
+    for (auto &session : sessions)
+        numClaimed += session->getNumClaimed();
+    QVERIFY(numClaimed == numPrgs);
+
+    for (uint prg = 0; prg < numPrgs; prg += rangeSize) {
+        for (auto &session : sessions) {
+            if (session->isClaimed(prg)) {
+                QVERIFY(session->isClaimed(prg + rangeSize - 1));
+                break;
+            }
+        }
+    }
+}
+
+QTEST_APPLESS_MAIN(ParagraphClaimsTests)
+
+#include "tst_paragraphclaimstests.moc"
@@ -1,4 +1,5 @@
 #include "paragraphretriever.h"
+#include <QTemporaryFile>
 #include <QtTest>
 
 class ParagraphRetrieverTests : public QObject {
@@ -20,6 +21,7 @@ private slots:
 
     void testGetParagraphCountWithOnlyOne();
     void testGetParagraphCountWithTwo();
+    void testGetParagraphCountFromFile();
 
 private:
     QString firstParagraph = "This is a paragraph. It has four sentences. This "
@@ -127,6 +129,17 @@ void ParagraphRetrieverTests::testGetParagraphCountWithTwo() {
     QVERIFY(expectedNumPrgs == actualNumPrgs);
 }
 
+void ParagraphRetrieverTests::testGetParagraphCountFromFile() {
+    QTemporaryFile textFile;
+    QVERIFY(textFile.open());
+    textFile.write(paragraphs.toUtf8());
+    QVERIFY(textFile.seek(0));
+
+    ParagraphRetriever retriever(&textFile, 4);
+    QVERIFY(retriever.getNumParagraphs() == 2);
+    QVERIFY(retriever.getParagraph(0).compare(firstParagraph) == 0);
+}
+
 QTEST_APPLESS_MAIN(ParagraphRetrieverTests)
 
 #include "tst_paragraphretrievertests.moc"
@@ -0,0 +1,148 @@
+#include "partcompressor.h"
+#include "waveheader.h"
+#include <QFile>
+#include <QProcess>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QtTest>
+
+class PartCompressorTests : public QObject {
+    Q_OBJECT
+
+public:
+    PartCompressorTests();
+    ~PartCompressorTests();
+
+private slots:
+    void initTestCase();
+    void testCompressIsBitExact();
+    void testUnverifiedPartIsKept();
+    void testUnify();
+
+private:
+    QTemporaryDir partsDir;
+
+    static QByteArray makeSamples(int, int);
+    static QByteArray makeWave(quint16, quint16, const QByteArray &);
+    static QByteArray decodeSamples(const QString &, const QString &);
+    QString writePart(const QString &, const QByteArray &);
+};
+
+PartCompressorTests::PartCompressorTests() {}
+
+PartCompressorTests::~PartCompressorTests() {}
+
+void PartCompressorTests::initTestCase() {
+    if (QStandardPaths::findExecutable("ffmpeg").isEmpty())
+        QSKIP("ffmpeg is needed to compress parts.");
+}
+
+// Noise down to the lowest bit, which is where a lossy copy would differ.
+QByteArray PartCompressorTests::makeSamples(int numSamples,
+                                            int bytesPerSample) {
+    QByteArray samples;
+    quint32 state = 12345;
+    for (int i = 0; i < numSamples * bytesPerSample; i++) {
+        state = state * 1103515245 + 12345;
+        samples.append(static_cast<char>(state >> 16));
+    }
+
+    return samples;
+}
+
+// A mono 8 kHz WAV file holding the given samples.
+QByteArray PartCompressorTests::makeWave(quint16 formatTag,
+                                         quint16 bitsPerSample,
+                                         const QByteArray &samples) {
+    WaveHeader header;
+    header.formatTag = formatTag;
+    header.channelCount = 1;
+    header.sampleRate = 8000;
+    header.blockAlign = bitsPerSample / 8;
+    header.byteRate = header.sampleRate * header.blockAlign;
+    header.bitsPerSample = bitsPerSample;
+    header.dataSize = samples.size();
+
+    return header.write() + samples;
+}
+
+// The raw samples ffmpeg decodes from a part, in the given sample format.
+QByteArray PartCompressorTests::decodeSamples(const QString &partPath,
+                                              const QString &format) {
+    QProcess ffmpeg;
+    ffmpeg.start("ffmpeg", {"-nostdin", "-v", "error", "-i", partPath, "-f",
+                            format, "-"});
+    if (!ffmpeg.waitForFinished(-1) || ffmpeg.exitCode() != 0)
+        return QByteArray();
+
+    return ffmpeg.readAllStandardOutput();
+}
+
+QString PartCompressorTests::writePart(const QString &fileName,
+                                       const QByteArray &contents) {
+    const QString partPath = partsDir.filePath(fileName);
+    QFile partFile(partPath);
+    if (!partFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return QString();
+
+    partFile.write(contents);
+    return partPath;
+}
+
+// The compressed part takes the place of the original, and decodes to the
+// same samples down to the last bit.
+void PartCompressorTests::testCompressIsBitExact() {
+    const QByteArray samples16 = makeSamples(8000, 2);
+    const QString partPath16 =
+        writePart("part0.wav", makeWave(1, 16, samples16));
+
+    QVERIFY(PartCompressor::compressFile(partPath16));
+    QVERIFY(!QFile::exists(partPath16));
+    QVERIFY(!QFile::exists(partsDir.filePath("part0.flac.tmp")));
+    QVERIFY(decodeSamples(partsDir.filePath("part0.flac"), "s16le") ==
+            samples16);
+
+    const QByteArray samples24 = makeSamples(8000, 3);
+    const QString partPath24 =
+        writePart("part1.wav", makeWave(1, 24, samples24));
+
+    QVERIFY(PartCompressor::compressFile(partPath24));
+    QVERIFY(!QFile::exists(partPath24));
+    QVERIFY(decodeSamples(partsDir.filePath("part1.flac"), "s24le") ==
+            samples24);
+}
+
+// FLAC cannot hold float samples exactly, so the compressed copy never
+// decodes to the same ones and the original stays as it was.
+void PartCompressorTests::testUnverifiedPartIsKept() {
+    const QByteArray wave = makeWave(3, 32, makeSamples(8000, 4));
+    const QString partPath = writePart("part2.wav", wave);
+
+    QVERIFY(!PartCompressor::compressFile(partPath));
+    QVERIFY(!QFile::exists(partsDir.filePath("part2.flac")));
+    QVERIFY(!QFile::exists(partsDir.filePath("part2.flac.tmp")));
+
+    QFile partFile(partPath);
+    QVERIFY(partFile.open(QIODevice::ReadOnly));
+    QVERIFY(partFile.readAll() == wave);
+}
+
+void PartCompressorTests::testUnify() {
+    const QStringList partPaths = {
+        writePart("part3.wav", makeWave(1, 16, makeSamples(4000, 2))),
+        writePart("part4.wav", makeWave(1, 16, makeSamples(4000, 2)))};
+
+    PartCompressor partCompressor;
+    QFuture<bool> unified = partCompressor.unify(partPaths);
+    unified.waitForFinished();
+
+    QVERIFY(unified.result());
+    QVERIFY(QFile::exists(partsDir.filePath("part3.flac")));
+    QVERIFY(QFile::exists(partsDir.filePath("part4.flac")));
+    QVERIFY(!QFile::exists(partPaths[0]));
+    QVERIFY(!QFile::exists(partPaths[1]));
+}
+
+QTEST_GUILESS_MAIN(PartCompressorTests)
+
+#include "tst_partcompressortests.moc"
@@ -0,0 +1,18 @@
+QT += testlib concurrent
+QT -= gui
+
+CONFIG += qt console warn_on depend_includepath testcase
+CONFIG -= app_bundle
+
+TEMPLATE = app
+
+SOURCES +=  tst_partprobertests.cpp \
+        ../../app/utilities/partprober.cpp \
+        ../../app/utilities/waveheader.cpp \
+        ../../app/utilities/recordedpartstracker.cpp
+HEADERS += ../../app/utilities/partprober.h \
+        ../../app/utilities/waveheader.h \
+        ../../app/utilities/recordedpartstracker.h
+INCLUDEPATH += \
+    ../../app \
+    ../../app/utilities
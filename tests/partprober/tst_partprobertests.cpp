@@ -0,0 +1,249 @@
+#include "partprober.h"
+#include "waveheader.h"
+#include <QDataStream>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QtEndian>
+#include <QtTest>
+
+class PartProberTests : public QObject {
+    Q_OBJECT
+
+public:
+    PartProberTests();
+    ~PartProberTests();
+
+private slots:
+    void testProbeWave();
+    void testProbeWaveUnsetSize();
+    void testProbeWaveExtensible();
+    void testProbeWaveSkipsChunks();
+    void testProbeFloatWave();
+    void testProbeFlac();
+    void testProbeUnknown();
+    void testProbePacked();
+
+private:
+    QTemporaryDir partsDir;
+
+    static WaveHeader makeHeader(quint16, quint16, quint32, quint16);
+    static QByteArray makeWave(WaveHeader, int, bool = true);
+    static QByteArray makeExtensible(WaveHeader, int);
+    static QByteArray addListChunk(QByteArray);
+    static QByteArray makeFlac(quint32, int, int, quint64);
+    QString writePart(const QString &, const QByteArray &);
+};
+
+PartProberTests::PartProberTests() {}
+
+PartProberTests::~PartProberTests() {}
+
+WaveHeader PartProberTests::makeHeader(quint16 formatTag,
+                                       quint16 channelCount,
+                                       quint32 sampleRate,
+                                       quint16 bitsPerSample) {
+    WaveHeader header;
+    header.formatTag = formatTag;
+    header.channelCount = channelCount;
+    header.sampleRate = sampleRate;
+    header.blockAlign = static_cast<quint16>(channelCount * bitsPerSample / 8);
+    header.byteRate = sampleRate * header.blockAlign;
+    header.bitsPerSample = bitsPerSample;
+
+    return header;
+}
+
+// A WAV file with the given number of bytes of samples, whose data size is
+// left at zero when it is not to be set, as an interrupted recorder leaves it.
+QByteArray PartProberTests::makeWave(WaveHeader header, int dataSize,
+                                     bool isSizeSet) {
+    header.dataSize = isSizeSet ? dataSize : 0;
+    return header.write() + QByteArray(dataSize, '\0');
+}
+
+// A WAV file whose format chunk is WAVE_FORMAT_EXTENSIBLE, which keeps the
+// real format tag in its sub-format.
+QByteArray PartProberTests::makeExtensible(WaveHeader header, int dataSize) {
+    const quint16 subFormat = header.formatTag;
+    header.formatTag = 0xFFFE;
+    QByteArray wave = makeWave(header, dataSize);
+
+    QByteArray extension;
+    QDataStream extensionOutput(&extension, QIODevice::WriteOnly);
+    extensionOutput.setByteOrder(QDataStream::LittleEndian);
+    extensionOutput << quint16(22) << header.bitsPerSample << quint32(0)
+                    << subFormat;
+    extensionOutput.writeRawData("\x00\x00\x00\x00\x10\x00\x80\x00\x00\xAA"
+                                 "\x00\x38\x9B\x71",
+                                 14);
+
+    wave.insert(36, extension);
+    qToLittleEndian<quint32>(16 + extension.size(), wave.data() + 16);
+    return wave;
+}
+
+// Puts an odd sized chunk, padded to an even length, before the format.
+QByteArray PartProberTests::addListChunk(QByteArray wave) {
+    return wave.insert(12, QByteArray("LIST\x03\x00\x00\x00"
+                                      "abc\0",
+                                      12));
+}
+
+// The marker and stream info block a FLAC file starts with, without any
+// frames after them.
+QByteArray PartProberTests::makeFlac(quint32 sampleRate, int channelCount,
+                                     int bitsPerSample, quint64 numSamples) {
+    QByteArray flac("fLaC");
+    flac.append("\x80\x00\x00\x22", 4);
+
+    // Block sizes and frame sizes, which the prober does not read.
+    flac.append(QByteArray(10, '\x10'));
+
+    flac.append(static_cast<char>(sampleRate >> 12));
+    flac.append(static_cast<char>(sampleRate >> 4));
+    flac.append(static_cast<char>(((sampleRate & 0xF) << 4) |
+                                  ((channelCount - 1) << 1) |
+                                  ((bitsPerSample - 1) >> 4)));
+    flac.append(static_cast<char>((((bitsPerSample - 1) & 0xF) << 4) |
+                                  ((numSamples >> 32) & 0xF)));
+    for (int shift = 24; shift >= 0; shift -= 8)
+        flac.append(static_cast<char>(numSamples >> shift));
+
+    // The checksum of the samples.
+    flac.append(QByteArray(16, '\0'));
+
+    return flac;
+}
+
+QString PartProberTests::writePart(const QString &fileName,
+                                   const QByteArray &contents) {
+    const QString partPath = partsDir.filePath(fileName);
+    QFile partFile(partPath);
+    if (!partFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return QString();
+
+    partFile.write(contents);
+    return partPath;
+}
+
+// Two seconds of 16-bit mono.
+void PartProberTests::testProbeWave() {
+    const QByteArray wave = makeWave(makeHeader(1, 1, 8000, 16), 32000);
+    const auto info = PartProber::probeFile(writePart("part0.wav", wave));
+
+    QVERIFY(info.fileName == "part0.wav");
+    QVERIFY(info.byteSize == wave.size());
+    QVERIFY(info.codec == "pcm_s16le");
+    QVERIFY(info.sampleRate == 8000);
+    QVERIFY(info.channelCount == 1);
+    QVERIFY(info.durationMs == 2000);
+    QVERIFY(info.isProbed());
+}
+
+// The samples are taken to run to the end of the file.
+void PartProberTests::testProbeWaveUnsetSize() {
+    const WaveHeader header = makeHeader(1, 2, 8000, 16);
+    const auto info = PartProber::probeFile(
+        writePart("part1.wav", makeWave(header, 48000, false)));
+
+    QVERIFY(info.codec == "pcm_s16le");
+    QVERIFY(info.channelCount == 2);
+    QVERIFY(info.durationMs == 1500);
+
+    // A size past the end of the file is cut to what is there.
+    QByteArray truncated = makeWave(header, 48000);
+    truncated.chop(16000);
+    const auto truncatedInfo =
+        PartProber::probeFile(writePart("part2.wav", truncated));
+    QVERIFY(truncatedInfo.durationMs == 1000);
+}
+
+void PartProberTests::testProbeWaveExtensible() {
+    const WaveHeader header = makeHeader(1, 1, 48000, 24);
+    const auto info = PartProber::probeFile(writePart(
+        "part3.wav", makeExtensible(header, 48000 * 3)));
+
+    QVERIFY(info.codec == "pcm_s24le");
+    QVERIFY(info.sampleRate == 48000);
+    QVERIFY(info.durationMs == 1000);
+}
+
+void PartProberTests::testProbeWaveSkipsChunks() {
+    const WaveHeader header = makeHeader(1, 1, 8000, 16);
+    const auto info = PartProber::probeFile(
+        writePart("part4.wav", addListChunk(makeWave(header, 8000))));
+
+    QVERIFY(info.codec == "pcm_s16le");
+    QVERIFY(info.durationMs == 500);
+}
+
+void PartProberTests::testProbeFloatWave() {
+    const WaveHeader header = makeHeader(3, 1, 8000, 32);
+    const auto info = PartProber::probeFile(
+        writePart("part5.wav", makeWave(header, 32000)));
+
+    QVERIFY(info.codec == "pcm_f32le");
+    QVERIFY(info.durationMs == 1000);
+}
+
+// Two seconds of 16-bit stereo.
+void PartProberTests::testProbeFlac() {
+    const auto info = PartProber::probeFile(
+        writePart("part7.flac", makeFlac(44100, 2, 16, 88200)));
+
+    QVERIFY(info.codec == "flac");
+    QVERIFY(info.sampleRate == 44100);
+    QVERIFY(info.channelCount == 2);
+    QVERIFY(info.durationMs == 2000);
+
+    // The sample count takes more than 32 bits at high rates.
+    const auto longInfo = PartProber::probeFile(writePart(
+        "part8.flac", makeFlac(192000, 1, 24, 192000ULL * 60 * 60 * 7)));
+    QVERIFY(longInfo.sampleRate == 192000);
+    QVERIFY(longInfo.channelCount == 1);
+    QVERIFY(longInfo.durationMs == 7LL * 60 * 60 * 1000);
+
+    // Stream info has to be the first block.
+    QByteArray otherBlock = makeFlac(44100, 2, 16, 88200);
+    otherBlock[4] = '\x81';
+    const auto otherInfo =
+        PartProber::probeFile(writePart("part9.flac", otherBlock));
+    QVERIFY(otherInfo.codec == "flac");
+    QVERIFY(otherInfo.durationMs == 0);
+}
+
+// Containers that cannot be looked into are named by their extension, and
+// keep the duration the recorder gave them.
+void PartProberTests::testProbeUnknown() {
+    const auto info = PartProber::probeFile(
+        writePart("part6.ogg", QByteArray("OggS") + QByteArray(100, '\0')));
+
+    QVERIFY(info.codec == "ogg");
+    QVERIFY(info.durationMs == 0);
+    QVERIFY(info.sampleRate == 0);
+
+    QVERIFY(!PartProber::probeFile(partsDir.filePath("missing.wav"))
+                 .isProbed());
+}
+
+// A take stored in a pack is read from its own range, and its size is the
+// take's rather than the pack's.
+void PartProberTests::testProbePacked() {
+    const QByteArray wave = makeWave(makeHeader(1, 1, 8000, 16), 16000);
+    const QByteArray padding(100, 'x');
+    const QString packPath =
+        writePart("parts.pack", padding + wave + padding);
+
+    const auto info =
+        PartProber::probePacked(packPath, padding.size(), wave.size());
+    QVERIFY(info.codec == "pcm_s16le");
+    QVERIFY(info.byteSize == wave.size());
+    QVERIFY(info.durationMs == 1000);
+
+    const auto wrongInfo = PartProber::probePacked(packPath, 0, wave.size());
+    QVERIFY(wrongInfo.codec == "unknown");
+}
+
+QTEST_APPLESS_MAIN(PartProberTests)
+
+#include "tst_partprobertests.moc"
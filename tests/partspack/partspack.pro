@@ -0,0 +1,14 @@
+QT += testlib
+QT -= gui
+
+CONFIG += qt console warn_on depend_includepath testcase
+CONFIG -= app_bundle
+
+TEMPLATE = app
+
+SOURCES +=  tst_partspacktests.cpp \
+        ../../app/utilities/partspack.cpp
+HEADERS += ../../app/utilities/partspack.h
+INCLUDEPATH += \
+    ../../app \
+    ../../app/utilities
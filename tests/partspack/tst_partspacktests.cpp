@@ -0,0 +1,212 @@
+#include "partspack.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <QtEndian>
+#include <QtTest>
+
+class PartsPackTests : public QObject {
+    Q_OBJECT
+
+public:
+    PartsPackTests();
+    ~PartsPackTests();
+
+private slots:
+    void init();
+
+    void testAppendAndRead();
+    void testReplacePart();
+    void testRemovePart();
+    void testRestorePart();
+    void testReopen();
+    void testRebuildMissingIndex();
+    void testRecoverTornAppend();
+    void testRefuseHugePart();
+    void testRebuildSkipsHugePart();
+    void testCompact();
+
+private:
+    QTemporaryDir packDir;
+    QString packPath;
+
+    QByteArray firstTake = QByteArray("first take of a paragraph");
+    QByteArray secondTake = QByteArray("a second, longer take of a paragraph");
+};
+
+PartsPackTests::PartsPackTests() {}
+
+PartsPackTests::~PartsPackTests() {}
+
+void PartsPackTests::init() {
+    packPath = packDir.filePath("book.ndpack");
+    QFile::remove(packPath);
+    QFile::remove(packPath + ".idx");
+}
+
+void PartsPackTests::testAppendAndRead() {
+    PartsPack pack;
+    QVERIFY(pack.open(packPath));
+    QVERIFY(pack.appendPart(0, firstTake));
+    QVERIFY(pack.appendPart(5000, secondTake));
+
+    QVERIFY(pack.contains(0));
+    QVERIFY(!pack.contains(1));
+    QVERIFY(pack.readPart(0) == firstTake);
+    QVERIFY(pack.readPart(5000) == secondTake);
+    QVERIFY(pack.getParts().size() == 2);
+}
+
+void PartsPackTests::testReplacePart() {
+    PartsPack pack;
+    QVERIFY(pack.open(packPath));
+    QVERIFY(pack.appendPart(3, firstTake));
+    QVERIFY(pack.appendPart(3, secondTake));
+
+    QVERIFY(pack.readPart(3) == secondTake);
+    QVERIFY(pack.getParts().size() == 1);
+    QVERIFY(pack.getDeadBytes() > 0);
+}
+
+void PartsPackTests::testRemovePart() {
+    PartsPack pack;
+    QVERIFY(pack.open(packPath));
+    QVERIFY(pack.appendPart(3, firstTake));
+    QVERIFY(pack.removePart(3));
+
+    QVERIFY(!pack.contains(3));
+    QVERIFY(pack.readPart(3).isEmpty());
+}
+
+// Appends that are undone leave the parts with the takes they had before.
+void PartsPackTests::testRestorePart() {
+    PartsPack pack;
+    QVERIFY(pack.open(packPath));
+    QVERIFY(pack.appendPart(3, firstTake));
+    const qint64 offset = pack.getPartOffset(3);
+    const qint64 liveBytes = pack.getLiveBytes();
+
+    QVERIFY(pack.appendPart(3, secondTake));
+    QVERIFY(pack.appendPart(4, secondTake));
+    QVERIFY(pack.restorePart(3, offset, firstTake.size()));
+    QVERIFY(pack.restorePart(4, 0, 0));
+
+    QVERIFY(pack.readPart(3) == firstTake);
+    QVERIFY(!pack.contains(4));
+    QVERIFY(pack.getLiveBytes() == liveBytes);
+
+    // A take past the end of the pack was never in it.
+    QVERIFY(!pack.restorePart(3, QFileInfo(packPath).size(), 1));
+    QVERIFY(pack.readPart(3) == firstTake);
+}
+
+void PartsPackTests::testReopen() {
+    {
+        PartsPack pack;
+        QVERIFY(pack.open(packPath));
+        QVERIFY(pack.appendPart(1, firstTake));
+        QVERIFY(pack.appendPart(2, secondTake));
+    }
+
+    PartsPack pack;
+    QVERIFY(pack.open(packPath));
+    QVERIFY(pack.readPart(1) == firstTake);
+    QVERIFY(pack.readPart(2) == secondTake);
+}
+
+void PartsPackTests::testRebuildMissingIndex() {
+    {
+        PartsPack pack;
+        QVERIFY(pack.open(packPath));
+        QVERIFY(pack.appendPart(1, firstTake));
+        QVERIFY(pack.appendPart(2, secondTake));
+        QVERIFY(pack.removePart(1));
+    }
+    QVERIFY(QFile::remove(packPath + ".idx"));
+
+    PartsPack pack;
+    QVERIFY(pack.open(packPath));
+    QVERIFY(!pack.contains(1));
+    QVERIFY(pack.readPart(2) == secondTake);
+}
+
+void PartsPackTests::testRecoverTornAppend() {
+    qint64 completeSize = 0;
+    {
+        PartsPack pack;
+        QVERIFY(pack.open(packPath));
+        QVERIFY(pack.appendPart(1, firstTake));
+        completeSize = QFileInfo(packPath).size();
+    }
+
+    QFile packFile(packPath);
+    QVERIFY(packFile.open(QIODevice::Append));
+    packFile.write("NDPR half a record");
+    packFile.close();
+
+    PartsPack pack;
+    QVERIFY(pack.open(packPath));
+    QVERIFY(pack.readPart(1) == firstTake);
+    QVERIFY(QFileInfo(packPath).size() == completeSize);
+}
+
+void PartsPackTests::testRefuseHugePart() {
+    PartsPack pack;
+    QVERIFY(pack.open(packPath));
+    QVERIFY(pack.appendPart(1, firstTake));
+    const qint64 packSize = QFileInfo(packPath).size();
+    const qint64 indexSize = QFileInfo(packPath + ".idx").size();
+
+    QVERIFY(!pack.appendPart(PartsPack::maxParts, secondTake));
+    QVERIFY(!pack.appendPart(0x80000000u, secondTake));
+    QVERIFY(!pack.contains(PartsPack::maxParts));
+    QVERIFY(QFileInfo(packPath).size() == packSize);
+    QVERIFY(QFileInfo(packPath + ".idx").size() == indexSize);
+    QVERIFY(pack.readPart(1) == firstTake);
+}
+
+// A record whose header names a part no take could have is passed over.
+void PartsPackTests::testRebuildSkipsHugePart() {
+    {
+        PartsPack pack;
+        QVERIFY(pack.open(packPath));
+        QVERIFY(pack.appendPart(1, firstTake));
+    }
+    QVERIFY(QFile::remove(packPath + ".idx"));
+
+    QByteArray record(16, '\0');
+    qToLittleEndian<quint32>(0x4e445052, record.data());
+    qToLittleEndian<quint32>(0x80000000u, record.data() + 4);
+    qToLittleEndian<qint64>(secondTake.size(), record.data() + 8);
+    QFile packFile(packPath);
+    QVERIFY(packFile.open(QIODevice::Append));
+    packFile.write(record + secondTake);
+    packFile.close();
+
+    PartsPack pack;
+    QVERIFY(pack.open(packPath));
+    QVERIFY(pack.readPart(1) == firstTake);
+    QVERIFY(!pack.contains(0x80000000u));
+    QVERIFY(QFileInfo(packPath + ".idx").size() < 1024 * 1024);
+}
+
+void PartsPackTests::testCompact() {
+    PartsPack pack;
+    QVERIFY(pack.open(packPath));
+    QVERIFY(pack.appendPart(1, firstTake));
+    QVERIFY(pack.appendPart(1, secondTake));
+    QVERIFY(pack.appendPart(2, firstTake));
+
+    QVERIFY(pack.compact());
+    QVERIFY(pack.getDeadBytes() == 0);
+    QVERIFY(pack.readPart(1) == secondTake);
+    QVERIFY(pack.readPart(2) == firstTake);
+
+    pack.close();
+    QVERIFY(pack.open(packPath));
+    QVERIFY(pack.readPart(1) == secondTake);
+}
+
+QTEST_APPLESS_MAIN(PartsPackTests)
+
+#include "tst_partspacktests.moc"
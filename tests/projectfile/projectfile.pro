@@ -0,0 +1,14 @@
+QT += testlib
+QT -= gui
+
+CONFIG += qt console warn_on depend_includepath testcase
+CONFIG -= app_bundle
+
+TEMPLATE = app
+
+SOURCES +=  tst_projectfiletests.cpp \
+        ../../app/utilities/projectfile.cpp
+HEADERS += ../../app/utilities/projectfile.h
+INCLUDEPATH += \
+    ../../app \
+    ../../app/utilities
@@ -0,0 +1,111 @@
+#include "projectfile.h"
+#include <QFile>
+#include <QTemporaryDir>
+#include <QtTest>
+
+class ProjectFileTests : public QObject {
+    Q_OBJECT
+
+public:
+    ProjectFileTests();
+    ~ProjectFileTests();
+
+private slots:
+    void testSaveAndLoad();
+    void testLoadOlderProject();
+    void testLoadMissingProject();
+    void testLoadNewerProject();
+
+    void testGetBookName();
+    void testGetPartPath();
+
+private:
+    QTemporaryDir projectDir;
+};
+
+ProjectFileTests::ProjectFileTests() {}
+
+ProjectFileTests::~ProjectFileTests() {}
+
+void ProjectFileTests::testSaveAndLoad() {
+    QString projectPath = projectDir.filePath("book.ndp");
+
+    ProjectFile project;
+    project.prgNumTotal = 3;
+    project.prgStarts = {0, 120, Q_INT64_C(5000000000)};
+    project.prgNum = 1;
+    project.textFilePath = "/books/book.txt";
+    project.audioExtension = ".wav";
+    project.wordCounts = {20, 25, 4};
+    project.isPackStorage = true;
+    ChapterList::Chapter secondChapter;
+    secondChapter.firstPrg = 2;
+    secondChapter.title = "Chapter Two: The = Sign";
+    project.chapters = {ChapterList::Chapter(), secondChapter};
+    project.chapterPatternsKey = "0123456789abcdef";
+    QVERIFY(project.save(projectPath));
+
+    ProjectFile loadedProject;
+    QVERIFY(loadedProject.load(projectPath));
+    QVERIFY(loadedProject.prgNumTotal == 3);
+    QVERIFY(loadedProject.prgStarts == project.prgStarts);
+    QVERIFY(loadedProject.prgNum == 1);
+    QVERIFY(loadedProject.textFilePath == project.textFilePath);
+    QVERIFY(loadedProject.audioExtension == ".wav");
+    QVERIFY(loadedProject.wordCounts == project.wordCounts);
+    QVERIFY(loadedProject.isPackStorage);
+    QVERIFY(loadedProject.chapters == project.chapters);
+    QVERIFY(loadedProject.chapterPatternsKey == project.chapterPatternsKey);
+}
+
+void ProjectFileTests::testLoadOlderProject() {
+    QString projectPath = projectDir.filePath("older.ndp");
+    QFile projectFile(projectPath);
+    QVERIFY(projectFile.open(QIODevice::WriteOnly | QIODevice::Text));
+    projectFile.write("2\n0,\n0\n/books/older.txt\n.wav\n");
+    projectFile.close();
+
+    ProjectFile project;
+    QVERIFY(project.load(projectPath));
+    QVERIFY(project.prgNumTotal == 2);
+    QVERIFY(project.prgStarts.size() == 1);
+    QVERIFY(project.wordCounts.isEmpty());
+    QVERIFY(!project.isPackStorage);
+    QVERIFY(project.chapters.isEmpty());
+    QVERIFY(project.chapterPatternsKey.isEmpty());
+}
+
+void ProjectFileTests::testLoadMissingProject() {
+    ProjectFile project;
+    QVERIFY(!project.load(projectDir.filePath("missing.ndp")));
+}
+
+void ProjectFileTests::testLoadNewerProject() {
+    QString projectPath = projectDir.filePath("newer.ndp");
+    QFile projectFile(projectPath);
+    QVERIFY(projectFile.open(QIODevice::WriteOnly | QIODevice::Text));
+    projectFile.write("2\n0,\n0\n/books/newer.txt\n.wav\n\nfiles\n\n\n" +
+                      QByteArray::number(ProjectFile::formatVersion + 1) +
+                      "\n");
+    projectFile.close();
+
+    ProjectFile project;
+    QVERIFY(!project.load(projectPath));
+}
+
+void ProjectFileTests::testGetBookName() {
+    QVERIFY(ProjectFile::getBookName("/books/war.and.peace.txt") ==
+            "war.and.peace");
+    QVERIFY(ProjectFile::getBookName("/books/notes").isEmpty());
+}
+
+void ProjectFileTests::testGetPartPath() {
+    QVERIFY(ProjectFile::getPartPath("/rec", 4, "", ".wav") ==
+            "/rec/part4.wav");
+    QVERIFY(ProjectFile::getPartPath("/rec", 4, "part4.flac", ".wav") ==
+            "/rec/part4.flac");
+}
+
+QTEST_APPLESS_MAIN(ProjectFileTests)
+
+#include "tst_projectfiletests.moc"
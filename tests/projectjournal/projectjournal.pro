@@ -0,0 +1,16 @@
+QT += testlib
+QT -= gui
+
+CONFIG += qt console warn_on depend_includepath testcase
+CONFIG -= app_bundle
+
+TEMPLATE = app
+
+SOURCES +=  tst_projectjournaltests.cpp \
+        ../../app/utilities/projectfile.cpp \
+        ../../app/utilities/projectjournal.cpp
+HEADERS += ../../app/utilities/projectfile.h \
+        ../../app/utilities/projectjournal.h
+INCLUDEPATH += \
+    ../../app \
+    ../../app/utilities
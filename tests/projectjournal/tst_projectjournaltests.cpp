@@ -0,0 +1,157 @@
+#include "projectjournal.h"
+#include <QFile>
+#include <QTemporaryDir>
+#include <QtTest>
+
+class ProjectJournalTests : public QObject {
+    Q_OBJECT
+
+public:
+    ProjectJournalTests();
+    ~ProjectJournalTests();
+
+private slots:
+    void testReplay();
+    void testReplayTwice();
+    void testReplayCutOffRecord();
+    void testReplayMissingParagraph();
+    void testReplayMissingJournal();
+    void testRestart();
+    void testOpenAppends();
+
+private:
+    QTemporaryDir journalDir;
+
+    ProjectFile makeProject();
+};
+
+ProjectJournalTests::ProjectJournalTests() {}
+
+ProjectJournalTests::~ProjectJournalTests() {}
+
+void ProjectJournalTests::testReplay() {
+    const QString journalPath = journalDir.filePath("replay.ndj");
+
+    ProjectJournal journal;
+    QVERIFY(journal.restart(journalPath));
+    QVERIFY(journal.appendParagraphStart(2, 300));
+    QVERIFY(journal.appendPosition(2));
+    QVERIFY(journal.appendTake(2, ".ogg"));
+    QVERIFY(journal.appendParagraphStart(1, 150));
+    QVERIFY(journal.getNumRecords() == 4);
+
+    // Records reach the file as they are made, before the journal is closed.
+    ProjectFile project = makeProject();
+    QVERIFY(ProjectJournal::replay(journalPath, project) == 4);
+    QVERIFY(project.prgStarts == QVector<qint64>({0, 150, 300}));
+    QVERIFY(project.prgNum == 2);
+    QVERIFY(project.audioExtension == ".ogg");
+}
+
+void ProjectJournalTests::testReplayTwice() {
+    const QString journalPath = journalDir.filePath("twice.ndj");
+
+    ProjectJournal journal;
+    QVERIFY(journal.restart(journalPath));
+    QVERIFY(journal.appendParagraphStart(2, 300));
+    QVERIFY(journal.appendParagraphStart(3, 420));
+    QVERIFY(journal.appendPosition(3));
+    journal.close();
+
+    ProjectFile project = makeProject();
+    QVERIFY(ProjectJournal::replay(journalPath, project) == 3);
+
+    // As when the program stops after saving in full, but before the journal
+    // was started over.
+    ProjectFile replayedProject = project;
+    QVERIFY(ProjectJournal::replay(journalPath, replayedProject) == 3);
+    QVERIFY(replayedProject.prgStarts == project.prgStarts);
+    QVERIFY(replayedProject.prgNum == project.prgNum);
+}
+
+void ProjectJournalTests::testReplayCutOffRecord() {
+    const QString journalPath = journalDir.filePath("cutoff.ndj");
+
+    QFile journalFile(journalPath);
+    QVERIFY(journalFile.open(QIODevice::WriteOnly));
+    journalFile.write("S 2 300\nP 2\nP 1");
+    journalFile.close();
+
+    ProjectFile project = makeProject();
+    project.prgNum = 2;
+    QVERIFY(ProjectJournal::replay(journalPath, project) == 2);
+    QVERIFY(project.prgNum == 2);
+}
+
+void ProjectJournalTests::testReplayMissingParagraph() {
+    const QString journalPath = journalDir.filePath("missing.ndj");
+
+    QFile journalFile(journalPath);
+    QVERIFY(journalFile.open(QIODevice::WriteOnly));
+    journalFile.write("P 1\nS 5 900\nP 5\n");
+    journalFile.close();
+
+    ProjectFile project = makeProject();
+    QVERIFY(ProjectJournal::replay(journalPath, project) == 1);
+    QVERIFY(project.prgStarts.size() == 2);
+    QVERIFY(project.prgNum == 1);
+}
+
+void ProjectJournalTests::testReplayMissingJournal() {
+    ProjectFile project = makeProject();
+    QVERIFY(ProjectJournal::replay(journalDir.filePath("none.ndj"), project) ==
+            0);
+    QVERIFY(project.prgNum == 0);
+}
+
+void ProjectJournalTests::testRestart() {
+    const QString journalPath = journalDir.filePath("restart.ndj");
+
+    ProjectJournal journal;
+    QVERIFY(journal.restart(journalPath));
+    QVERIFY(journal.appendPosition(1));
+    QVERIFY(journal.restart(journalPath));
+    QVERIFY(journal.getNumRecords() == 0);
+    QVERIFY(journal.appendPosition(0));
+
+    ProjectFile project = makeProject();
+    project.prgNum = 1;
+    QVERIFY(ProjectJournal::replay(journalPath, project) == 1);
+    QVERIFY(project.prgNum == 0);
+
+    journal.close();
+    QVERIFY(!journal.isOpen());
+    QVERIFY(!journal.appendPosition(1));
+}
+
+// Opening a journal carries on after the records already in it.
+void ProjectJournalTests::testOpenAppends() {
+    const QString journalPath = journalDir.filePath("append.ndj");
+
+    ProjectJournal journal;
+    QVERIFY(journal.restart(journalPath));
+    QVERIFY(journal.appendPosition(1));
+    QVERIFY(journal.open(journalPath));
+    QVERIFY(journal.getNumRecords() == 0);
+    QVERIFY(journal.appendPosition(0));
+    journal.close();
+
+    ProjectFile project = makeProject();
+    project.prgNum = 2;
+    QVERIFY(ProjectJournal::replay(journalPath, project) == 2);
+    QVERIFY(project.prgNum == 0);
+}
+
+// A project whose first two paragraphs have been read.
+ProjectFile ProjectJournalTests::makeProject() {
+    ProjectFile project;
+    project.prgNumTotal = 10;
+    project.prgStarts = {0, 150};
+    project.audioExtension = ".wav";
+
+    return project;
+}
+
+QTEST_APPLESS_MAIN(ProjectJournalTests)
+
+#include "tst_projectjournaltests.moc"
@@ -0,0 +1,14 @@
+QT += testlib
+QT -= gui
+
+CONFIG += qt console warn_on depend_includepath testcase
+CONFIG -= app_bundle
+
+TEMPLATE = app
+
+SOURCES +=  tst_recordedpartstrackertests.cpp \
+        ../../app/utilities/recordedpartstracker.cpp
+HEADERS += ../../app/utilities/recordedpartstracker.h
+INCLUDEPATH += \
+    ../../app \
+    ../../app/utilities
@@ -0,0 +1,198 @@
+#include "recordedpartstracker.h"
+#include <QFile>
+#include <QTemporaryDir>
+#include <QtTest>
+
+class RecordedPartsTrackerTests : public QObject {
+    Q_OBJECT
+
+public:
+    RecordedPartsTrackerTests();
+    ~RecordedPartsTrackerTests();
+
+private slots:
+    void testMarkRecorded();
+    void testMarkUnrecorded();
+    void testMerge();
+    void testDenseParts();
+
+    void testNextUnrecorded();
+    void testNextUnrecordedAcrossGroups();
+    void testNextUnrecordedAllRecorded();
+    void testProgressPercentage();
+
+    void testGetPartNumber();
+    void testScanDirectory();
+    void testScanDirectoryDuplicatePart();
+    void testSaveAndLoad();
+};
+
+RecordedPartsTrackerTests::RecordedPartsTrackerTests() {}
+
+RecordedPartsTrackerTests::~RecordedPartsTrackerTests() {}
+
+void RecordedPartsTrackerTests::testMarkRecorded() {
+    RecordedPartsTracker tracker;
+    tracker.markRecorded(3, 1024, 2000);
+
+    QVERIFY(tracker.isRecorded(3));
+    QVERIFY(!tracker.isRecorded(2));
+    QVERIFY(tracker.getNumRecorded() == 1);
+    QVERIFY(tracker.getPartInfo(3).byteSize == 1024);
+    QVERIFY(tracker.getPartInfo(3).durationMs == 2000);
+}
+
+void RecordedPartsTrackerTests::testMarkUnrecorded() {
+    RecordedPartsTracker tracker;
+    tracker.markRecorded(3);
+    tracker.markRecorded(3);
+    tracker.markUnrecorded(3);
+
+    QVERIFY(!tracker.isRecorded(3));
+    QVERIFY(tracker.getNumRecorded() == 0);
+}
+
+void RecordedPartsTrackerTests::testMerge() {
+    RecordedPartsTracker tracker;
+    tracker.markRecorded(1, 1024, 2000);
+    tracker.markRecorded(2, 2048, 3000);
+
+    RecordedPartsTracker otherTracker;
+    otherTracker.markRecorded(2, 2048);
+    otherTracker.markRecorded(5, 4096, 5000);
+    RecordedPartsTracker::PartInfo probedInfo;
+    probedInfo.byteSize = 2048;
+    probedInfo.durationMs = 3100;
+    probedInfo.codec = "pcm_s16le";
+    QVERIFY(otherTracker.setPartInfo(2, probedInfo));
+
+    tracker.merge(otherTracker);
+    QVERIFY(tracker.getNumRecorded() == 3);
+    QVERIFY(tracker.isRecorded(1));
+    QVERIFY(tracker.getPartInfo(2).durationMs == 3100);
+    QVERIFY(tracker.getPartInfo(5).byteSize == 4096);
+}
+
+void RecordedPartsTrackerTests::testDenseParts() {
+    RecordedPartsTracker tracker;
+    for (uint part = 0; part < 10000; part++)
+        tracker.markRecorded(part);
+    for (uint part = 0; part < 10000; part += 2)
+        tracker.markUnrecorded(part);
+
+    QVERIFY(tracker.getNumRecorded() == 5000);
+    QVERIFY(tracker.isRecorded(9999));
+    QVERIFY(!tracker.isRecorded(9998));
+    QVERIFY(tracker.getNextUnrecorded(1, 10000) == 2);
+}
+
+void RecordedPartsTrackerTests::testNextUnrecorded() {
+    RecordedPartsTracker tracker;
+    tracker.markRecorded(0);
+    tracker.markRecorded(1);
+    tracker.markRecorded(2);
+    tracker.markRecorded(4);
+
+    QVERIFY(tracker.getFirstUnrecorded(10) == 3);
+    QVERIFY(tracker.getNextUnrecorded(4, 10) == 5);
+}
+
+void RecordedPartsTrackerTests::testNextUnrecordedAcrossGroups() {
+    RecordedPartsTracker tracker;
+    for (uint part = 0; part < 65540; part++)
+        tracker.markRecorded(part);
+
+    QVERIFY(tracker.getFirstUnrecorded(70000) == 65540);
+}
+
+void RecordedPartsTrackerTests::testNextUnrecordedAllRecorded() {
+    RecordedPartsTracker tracker;
+    for (uint part = 0; part < 5; part++)
+        tracker.markRecorded(part);
+
+    QVERIFY(tracker.getFirstUnrecorded(5) == -1);
+}
+
+void RecordedPartsTrackerTests::testProgressPercentage() {
+    RecordedPartsTracker tracker;
+    tracker.markRecorded(0);
+
+    QVERIFY(tracker.getProgressPercentage(4) == 25);
+    QVERIFY(tracker.getProgressPercentage(0) == 0);
+}
+
+void RecordedPartsTrackerTests::testGetPartNumber() {
+    QVERIFY(RecordedPartsTracker::getPartNumber("part12.wav") == 12);
+    QVERIFY(RecordedPartsTracker::getPartNumber("part7") == 7);
+    QVERIFY(RecordedPartsTracker::getPartNumber("parts-list.txt") == -1);
+    QVERIFY(RecordedPartsTracker::getPartNumber("book.ndp") == -1);
+}
+
+void RecordedPartsTrackerTests::testScanDirectory() {
+    QTemporaryDir recordingDir;
+    QVERIFY(recordingDir.isValid());
+
+    for (const QString &fileName : {"part0.wav", "part2.wav", "parts-list.txt"}) {
+        QFile partFile(recordingDir.filePath(fileName));
+        QVERIFY(partFile.open(QIODevice::WriteOnly));
+        partFile.write("data");
+    }
+
+    RecordedPartsTracker tracker;
+    tracker.markRecorded(5);
+    tracker.scanDirectory(recordingDir.path());
+
+    QVERIFY(tracker.isRecorded(0));
+    QVERIFY(tracker.isRecorded(2));
+    QVERIFY(!tracker.isRecorded(5));
+    QVERIFY(tracker.getNumRecorded() == 2);
+    QVERIFY(tracker.getPartInfo(2).byteSize == 4);
+}
+
+void RecordedPartsTrackerTests::testScanDirectoryDuplicatePart() {
+    QTemporaryDir recordingDir;
+    QVERIFY(recordingDir.isValid());
+
+    QFile originalFile(recordingDir.filePath("part1.wav"));
+    QVERIFY(originalFile.open(QIODevice::WriteOnly));
+    originalFile.write("original data");
+    originalFile.close();
+
+    QFile compressedFile(recordingDir.filePath("part1.flac"));
+    QVERIFY(compressedFile.open(QIODevice::WriteOnly));
+    compressedFile.write("data");
+    compressedFile.close();
+
+    RecordedPartsTracker tracker;
+    tracker.scanDirectory(recordingDir.path());
+
+    QVERIFY(tracker.getNumRecorded() == 1);
+    QVERIFY(tracker.getPartInfo(1).fileName == "part1.wav");
+
+    QVERIFY(originalFile.remove());
+    tracker.scanDirectory(recordingDir.path());
+    QVERIFY(tracker.getPartInfo(1).fileName == "part1.flac");
+}
+
+void RecordedPartsTrackerTests::testSaveAndLoad() {
+    QTemporaryDir projectDir;
+    QVERIFY(projectDir.isValid());
+    QString trackerPath = projectDir.filePath("book.ndr");
+
+    RecordedPartsTracker tracker;
+    for (uint part = 0; part < 6000; part++)
+        tracker.markRecorded(part);
+    tracker.markRecorded(70000, 512, 1500);
+    QVERIFY(tracker.saveToFile(trackerPath));
+
+    RecordedPartsTracker loadedTracker;
+    QVERIFY(loadedTracker.loadFromFile(trackerPath));
+    QVERIFY(loadedTracker.getNumRecorded() == 6001);
+    QVERIFY(loadedTracker.isRecorded(5999));
+    QVERIFY(!loadedTracker.isRecorded(6000));
+    QVERIFY(loadedTracker.getPartInfo(70000).durationMs == 1500);
+}
+
+QTEST_APPLESS_MAIN(RecordedPartsTrackerTests)
+
+#include "tst_recordedpartstrackertests.moc"
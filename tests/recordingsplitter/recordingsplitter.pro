@@ -0,0 +1,16 @@
+QT += testlib
+QT -= gui
+
+CONFIG += qt console warn_on depend_includepath testcase
+CONFIG -= app_bundle
+
+TEMPLATE = app
+
+SOURCES +=  tst_recordingsplittertests.cpp \
+        ../../app/utilities/recordingsplitter.cpp \
+        ../../app/utilities/waveheader.cpp
+HEADERS += ../../app/utilities/recordingsplitter.h \
+        ../../app/utilities/waveheader.h
+INCLUDEPATH += \
+    ../../app \
+    ../../app/utilities
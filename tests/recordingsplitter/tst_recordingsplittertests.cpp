@@ -0,0 +1,165 @@
+#include "recordingsplitter.h"
+#include "waveheader.h"
+#include <QDataStream>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <QtMath>
+#include <QtTest>
+
+class RecordingSplitterTests : public QObject {
+    Q_OBJECT
+
+public:
+    RecordingSplitterTests();
+    ~RecordingSplitterTests();
+
+private slots:
+    void initTestCase();
+
+    void testOpenNonWave();
+    void testDetectSilences();
+    void testProposeSplits();
+    void testProposeSplitsTooFewPauses();
+    void testWriteParts();
+
+private:
+    QTemporaryDir recordingDir;
+    QString recordingPath;
+
+    static const int sampleRate = 8000;
+
+    // Speech is stood in for by a tone, and pauses by digital silence.
+    void appendTone(QDataStream &, double);
+    void appendSilence(QDataStream &, double);
+};
+
+RecordingSplitterTests::RecordingSplitterTests() {}
+
+RecordingSplitterTests::~RecordingSplitterTests() {}
+
+// Three paragraphs of equal length, where the middle one has a short pause
+// between its two sentences: 2s, 1s pause, 1s, 0.3s pause, 1s, 1s pause, 2s.
+void RecordingSplitterTests::initTestCase() {
+    QByteArray samples;
+    QDataStream sampleOutput(&samples, QIODevice::WriteOnly);
+    sampleOutput.setByteOrder(QDataStream::LittleEndian);
+    appendTone(sampleOutput, 2);
+    appendSilence(sampleOutput, 1);
+    appendTone(sampleOutput, 1);
+    appendSilence(sampleOutput, 0.3);
+    appendTone(sampleOutput, 1);
+    appendSilence(sampleOutput, 1);
+    appendTone(sampleOutput, 2);
+
+    WaveHeader header;
+    header.formatTag = 1;
+    header.channelCount = 1;
+    header.sampleRate = sampleRate;
+    header.byteRate = sampleRate * 2;
+    header.blockAlign = 2;
+    header.bitsPerSample = 16;
+    header.dataSize = samples.size();
+
+    recordingPath = recordingDir.filePath("chapter.wav");
+    QFile recordingFile(recordingPath);
+    QVERIFY(recordingFile.open(QIODevice::WriteOnly));
+    recordingFile.write(header.write() + samples);
+}
+
+void RecordingSplitterTests::testOpenNonWave() {
+    QString textPath = recordingDir.filePath("chapter.txt");
+    QFile textFile(textPath);
+    QVERIFY(textFile.open(QIODevice::WriteOnly));
+    textFile.write("Not a recording at all.");
+    textFile.close();
+
+    RecordingSplitter splitter(textPath);
+    QVERIFY(!splitter.open());
+    QVERIFY(!splitter.getErrorString().isEmpty());
+}
+
+void RecordingSplitterTests::testDetectSilences() {
+    RecordingSplitter splitter(recordingPath);
+    QVERIFY(splitter.open());
+    QVERIFY(splitter.getDurationMs() == 8300);
+    QVERIFY(splitter.detectSilences());
+
+    auto silences = splitter.getSilences();
+    QVERIFY(silences.size() == 3);
+    QVERIFY(qAbs(silences[0].startFrame - 2 * sampleRate) <= sampleRate / 50);
+    QVERIFY(qAbs(silences[2].endFrame - 6.3 * sampleRate) <= sampleRate / 50);
+
+    QVERIFY(splitter.detectSilences(500));
+    QVERIFY(splitter.getSilences().size() == 2);
+}
+
+void RecordingSplitterTests::testProposeSplits() {
+    RecordingSplitter splitter(recordingPath);
+    QVERIFY(splitter.open());
+    QVERIFY(splitter.detectSilences());
+
+    // The short pause sits closer to where an even split is expected, but
+    // the long pauses are the paragraph breaks.
+    auto splitFrames = splitter.proposeSplits({10, 10, 10});
+    QVERIFY(splitFrames.size() == 2);
+    QVERIFY(qAbs(splitFrames[0] - 2.5 * sampleRate) <= sampleRate / 50);
+    QVERIFY(qAbs(splitFrames[1] - 5.8 * sampleRate) <= sampleRate / 50);
+
+    // Without word counts paragraphs are taken to be the same length.
+    QVERIFY(splitter.proposeSplits({0, 0, 0}) == splitFrames);
+}
+
+void RecordingSplitterTests::testProposeSplitsTooFewPauses() {
+    RecordingSplitter splitter(recordingPath);
+    QVERIFY(splitter.open());
+    QVERIFY(splitter.detectSilences());
+
+    QVERIFY(splitter.proposeSplits({1, 1, 1, 1}).size() == 3);
+    QVERIFY(splitter.proposeSplits({1, 1, 1, 1, 1}).isEmpty());
+}
+
+void RecordingSplitterTests::testWriteParts() {
+    RecordingSplitter splitter(recordingPath);
+    QVERIFY(splitter.open());
+    QVERIFY(splitter.detectSilences());
+
+    auto splitFrames = splitter.proposeSplits({10, 10, 10});
+    QStringList partPaths = {recordingDir.filePath("part0.wav"),
+                             recordingDir.filePath("part1.wav"),
+                             recordingDir.filePath("part2.wav")};
+    QVERIFY(splitter.writeParts(splitFrames, partPaths));
+
+    qint64 numFrames = 0;
+    for (const QString &partPath : partPaths) {
+        RecordingSplitter part(partPath);
+        QVERIFY(part.open());
+        QVERIFY(QFileInfo(partPath).size() == 44 + part.getNumFrames() * 2);
+        numFrames += part.getNumFrames();
+    }
+
+    QVERIFY(numFrames == splitter.getNumFrames());
+
+    RecordingSplitter firstPart(partPaths[0]);
+    QVERIFY(firstPart.open());
+    QVERIFY(firstPart.getNumFrames() == splitFrames[0]);
+}
+
+void RecordingSplitterTests::appendTone(QDataStream &sampleOutput,
+                                        double seconds) {
+    const int numFrames = static_cast<int>(seconds * sampleRate);
+    for (int frame = 0; frame < numFrames; frame++)
+        sampleOutput << qint16(16000 *
+                               qSin(2 * M_PI * 220 * frame / sampleRate));
+}
+
+void RecordingSplitterTests::appendSilence(QDataStream &sampleOutput,
+                                           double seconds) {
+    const int numFrames = static_cast<int>(seconds * sampleRate);
+    for (int frame = 0; frame < numFrames; frame++)
+        sampleOutput << qint16(0);
+}
+
+QTEST_APPLESS_MAIN(RecordingSplitterTests)
+
+#include "tst_recordingsplittertests.moc"
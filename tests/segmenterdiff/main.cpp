@@ -0,0 +1,194 @@
+#include "segmenterharness.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QTextStream>
+
+// Exit codes, so the tool can gate a change in a script.
+enum ExitCode { Agreed = 0, Disagreed = 1, Failed = 2 };
+
+int main(int argc, char *argv[]) {
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("segmenterdiff");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        "Splits a text into sentences with every engine given, reports where "
+        "each disagrees with the reference and how fast each was.\n\n"
+        "Engines:\n"
+        "  reader     ParagraphReader, which the program narrates with.\n"
+        "  retriever  ParagraphRetriever, through QTextBoundaryFinder.\n"
+        "  nltk       paragraphretriever.py, through NLTK's punkt. Its time "
+        "includes starting Python.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("text", "The text file to split.");
+
+    QCommandLineOption enginesOption(
+        "engines", "The engines to run, separated by commas.", "engines",
+        "reader,retriever,nltk");
+    QCommandLineOption referenceOption(
+        "reference", "The engine the others are compared with.", "engine",
+        SegmenterHarness::readerEngine);
+    QCommandLineOption goldenOption(
+        "golden", "Compare the engines with this golden file instead.",
+        "file");
+    QCommandLineOption writeGoldenOption(
+        "write-golden", "Write the reference's boundaries to this file.",
+        "file");
+    QCommandLineOption contextOption(
+        "context", "How many characters to show around a disagreement.",
+        "characters", "30");
+    QCommandLineOption maxReportsOption(
+        "max-reports", "How many disagreements to show for each engine.",
+        "count", "10");
+    QCommandLineOption pythonOption("python", "The Python to run nltk with.",
+                                    "program", "python3");
+    QCommandLineOption scriptOption(
+        "nltk-script", "Where paragraphretriever.py is.", "file",
+        SEGMENTER_NLTK_SCRIPT);
+    parser.addOptions({enginesOption, referenceOption, goldenOption,
+                       writeGoldenOption, contextOption, maxReportsOption,
+                       pythonOption, scriptOption});
+
+    parser.process(a);
+
+    const QStringList arguments = parser.positionalArguments();
+    if (arguments.size() != 1)
+        parser.showHelp(Failed);
+
+    QTextStream output(stdout);
+    QTextStream errorOutput(stderr);
+
+    const QString textPath = arguments[0];
+    const QString text = SegmenterHarness::readText(textPath);
+    if (text.isEmpty()) {
+        errorOutput << "Could not read any text from " << textPath << '\n';
+        return Failed;
+    }
+
+    const double textMb = QFileInfo(textPath).size() / (1024.0 * 1024.0);
+    output << textPath << ": " << text.size() << " characters, "
+           << QString::number(textMb, 'f', 2) << " MB\n";
+
+    QStringList engines =
+        parser.value(enginesOption).split(',', QString::SkipEmptyParts);
+    const QString reference = parser.value(referenceOption);
+    if (parser.isSet(writeGoldenOption) && !engines.contains(reference))
+        engines.prepend(reference);
+
+    QVector<std::pair<QString, QVector<int>>> runs;
+    for (const QString &engine : engines) {
+        QElapsedTimer timer;
+        timer.start();
+
+        QVector<int> boundaries;
+        QString error;
+        if (engine == SegmenterHarness::readerEngine) {
+            boundaries = SegmenterHarness::runReader(textPath);
+        } else if (engine == SegmenterHarness::retrieverEngine) {
+            boundaries = SegmenterHarness::runRetriever(text);
+        } else if (engine == SegmenterHarness::nltkEngine) {
+            if (!SegmenterHarness::runNltk(textPath, parser.value(pythonOption),
+                                           parser.value(scriptOption),
+                                           boundaries, error)) {
+                output << engine << ": skipped, " << error << '\n';
+                continue;
+            }
+        } else {
+            errorOutput << "Unknown engine " << engine << '\n';
+            return Failed;
+        }
+
+        const qint64 elapsedMs = qMax<qint64>(timer.elapsed(), 1);
+        boundaries = SegmenterHarness::normalize(boundaries, text);
+        runs.append(std::make_pair(engine, boundaries));
+
+        output << engine << ": " << boundaries.size() + 1 << " sentences in "
+               << elapsedMs << " ms, "
+               << QString::number(textMb * 1000 / elapsedMs, 'f', 2)
+               << " MB/s\n";
+    }
+
+    // The reference's boundaries, from a golden file or from its own run.
+    QString referenceName = reference;
+    QVector<int> referenceBoundaries;
+    bool hasReference = false;
+    if (parser.isSet(goldenOption)) {
+        QString error;
+        if (!SegmenterHarness::readGolden(parser.value(goldenOption), text,
+                                          referenceBoundaries, referenceName,
+                                          error)) {
+            errorOutput << error << '\n';
+            return Failed;
+        }
+        referenceName = "golden " + referenceName;
+        hasReference = true;
+    } else {
+        for (auto &run : runs) {
+            if (run.first == reference) {
+                referenceBoundaries = run.second;
+                hasReference = true;
+            }
+        }
+    }
+
+    if (!hasReference) {
+        errorOutput << "The reference " << reference << " did not run\n";
+        return Failed;
+    }
+
+    if (parser.isSet(writeGoldenOption)) {
+        if (!SegmenterHarness::writeGolden(parser.value(writeGoldenOption),
+                                           text, reference,
+                                           referenceBoundaries)) {
+            errorOutput << "Could not write "
+                        << parser.value(writeGoldenOption) << '\n';
+            return Failed;
+        }
+        output << "Wrote " << referenceBoundaries.size() << " boundaries to "
+               << parser.value(writeGoldenOption) << '\n';
+    }
+
+    const int contextLength = parser.value(contextOption).toInt();
+    const int maxReports = parser.value(maxReportsOption).toInt();
+    int exitCode = Agreed;
+
+    for (auto &run : runs) {
+        if (run.first == reference && !parser.isSet(goldenOption))
+            continue;
+
+        const auto disagreements =
+            SegmenterHarness::compare(referenceBoundaries, run.second);
+        int numOnlyInReference = 0;
+        for (auto &disagreement : disagreements) {
+            if (disagreement.isInReference)
+                numOnlyInReference++;
+        }
+
+        output << '\n'
+               << run.first << " against " << referenceName << ": "
+               << run.second.size() - disagreements.size() +
+                      numOnlyInReference
+               << " shared, " << disagreements.size() - numOnlyInReference
+               << " only in " << run.first << ", " << numOnlyInReference
+               << " only in " << referenceName << '\n';
+
+        for (int i = 0; i < disagreements.size() && i < maxReports; i++) {
+            const auto &disagreement = disagreements[i];
+            output << "  " << disagreement.position << " only in "
+                   << (disagreement.isInReference ? referenceName : run.first)
+                   << ": "
+                   << SegmenterHarness::getContext(
+                          text, disagreement.position, contextLength)
+                   << '\n';
+        }
+
+        if (!disagreements.isEmpty())
+            exitCode = Disagreed;
+    }
+
+    output << flush;
+    errorOutput << flush;
+    return exitCode;
+}
@@ -0,0 +1,27 @@
+QT -= gui
+
+# Built with the tests, but left out of `make check` since it is run by hand
+# against corpora, and needs NLTK for one of its engines. The segmenterharness
+# test checks ParagraphReader against the golden file kept here.
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+TARGET = segmenterdiff
+TEMPLATE = app
+
+DEFINES += SEGMENTER_NLTK_SCRIPT=\\\"$$PWD/../../app/utilities/paragraphretriever.py\\\"
+
+SOURCES += main.cpp \
+        segmenterharness.cpp \
+        ../../app/utilities/paragraphreader.cpp \
+        ../../app/utilities/paragraphcounter.cpp \
+        ../../app/utilities/chapterlist.cpp \
+        ../../app/utilities/paragraphretriever.cpp
+HEADERS += segmenterharness.h \
+        ../../app/utilities/paragraphreader.h \
+        ../../app/utilities/paragraphcounter.h \
+        ../../app/utilities/chapterlist.h \
+        ../../app/utilities/paragraphretriever.h
+INCLUDEPATH += \
+    ../../app \
+    ../../app/utilities
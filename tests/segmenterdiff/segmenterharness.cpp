@@ -0,0 +1,245 @@
+#include "segmenterharness.h"
+#include "paragraphreader.h"
+#include "paragraphretriever.h"
+
+#include <QCryptographicHash>
+#include <QFile>
+#include <QProcess>
+#include <QProcessEnvironment>
+#include <QTextStream>
+
+const QString SegmenterHarness::readerEngine = "reader";
+const QString SegmenterHarness::retrieverEngine = "retriever";
+const QString SegmenterHarness::nltkEngine = "nltk";
+
+QString SegmenterHarness::readText(const QString &textPath) {
+    QFile textFile(textPath);
+    if (!textFile.open(QIODevice::ReadOnly | QIODevice::Text))
+        return QString();
+
+    QTextStream textInput(&textFile);
+    textInput.setCodec("UTF-8");
+
+    return textInput.readAll();
+}
+
+// Every character read ends up in one sentence or the next, so where each
+// sentence ends is the length of the sentences read so far.
+QVector<int> SegmenterHarness::runReader(const QString &textPath) {
+    QVector<int> boundaries;
+
+    QFile textFile(textPath);
+    if (!textFile.open(QIODevice::ReadOnly | QIODevice::Text))
+        return boundaries;
+
+    QTextStream textInput(&textFile);
+    textInput.setCodec("UTF-8");
+    ParagraphReader reader(textInput);
+
+    qint64 location = 0;
+    int textPos = 0;
+    QString sentence = reader.readSentence(location);
+    while (!sentence.isEmpty()) {
+        textPos += sentence.size();
+        boundaries.append(textPos);
+
+        sentence = reader.readSentence(location);
+    }
+
+    return boundaries;
+}
+
+QVector<int> SegmenterHarness::runRetriever(const QString &text) {
+    QVector<int> boundaries;
+    ParagraphRetriever retriever(text, 4);
+
+    int textPos = 0;
+    while (textPos < text.size()) {
+        const QString sentence = retriever.getNextSentence();
+        if (sentence.isEmpty())
+            break;
+
+        textPos += sentence.size();
+        boundaries.append(textPos);
+    }
+
+    return boundaries;
+}
+
+// Asks paragraphretriever.py where its sentences start. NLTK has to be
+// installed for the Python found, and its punkt data is fetched on the way.
+bool SegmenterHarness::runNltk(const QString &textPath, const QString &python,
+                               const QString &scriptPath,
+                               QVector<int> &boundaries, QString &error) {
+    QProcess retriever;
+    QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+    environment.insert("PYTHONUTF8", "1");
+    retriever.setProcessEnvironment(environment);
+
+    retriever.start(python, QStringList{scriptPath, textPath});
+    if (!retriever.waitForStarted(-1)) {
+        error = "Could not start " + python;
+        return false;
+    }
+
+    retriever.write("getsentencestarts\nexit\n");
+    retriever.closeWriteChannel();
+
+    if (!retriever.waitForFinished(-1) ||
+        retriever.exitStatus() != QProcess::NormalExit ||
+        retriever.exitCode() != 0) {
+        error = QString::fromUtf8(retriever.readAllStandardError()).trimmed();
+        if (error.isEmpty())
+            error = scriptPath + " did not finish";
+        return false;
+    }
+
+    boundaries.clear();
+    const QByteArray output = retriever.readAllStandardOutput();
+    for (const QByteArray &line : output.split('\n')) {
+        if (line.trimmed().isEmpty())
+            continue;
+
+        bool isNumber = false;
+        const int boundary = line.trimmed().toInt(&isNumber);
+        if (!isNumber) {
+            error = "Unexpected output from " + scriptPath + ": " +
+                    QString::fromUtf8(line);
+            return false;
+        }
+
+        boundaries.append(boundary);
+    }
+
+    return true;
+}
+
+// Moves every boundary to the start of the sentence after it, and leaves out
+// the start of the first sentence and the end of the last.
+QVector<int> SegmenterHarness::normalize(const QVector<int> &boundaries,
+                                         const QString &text) {
+    int firstStart = 0;
+    while (firstStart < text.size() && text[firstStart].isSpace())
+        firstStart++;
+
+    QVector<int> normalized;
+    for (int boundary : boundaries) {
+        while (boundary < text.size() && text[boundary].isSpace())
+            boundary++;
+
+        if (boundary <= firstStart || boundary >= text.size())
+            continue;
+        if (!normalized.isEmpty() && normalized.last() >= boundary)
+            continue;
+
+        normalized.append(boundary);
+    }
+
+    return normalized;
+}
+
+// Both lists have to be normalized first.
+QVector<SegmenterHarness::Disagreement>
+SegmenterHarness::compare(const QVector<int> &reference,
+                          const QVector<int> &boundaries) {
+    QVector<Disagreement> disagreements;
+
+    int referenceIndex = 0;
+    int boundaryIndex = 0;
+    while (referenceIndex < reference.size() ||
+           boundaryIndex < boundaries.size()) {
+        Disagreement disagreement;
+
+        if (boundaryIndex == boundaries.size() ||
+            (referenceIndex < reference.size() &&
+             reference[referenceIndex] < boundaries[boundaryIndex])) {
+            disagreement.position = reference[referenceIndex++];
+            disagreement.isInReference = true;
+        } else if (referenceIndex == reference.size() ||
+                   boundaries[boundaryIndex] < reference[referenceIndex]) {
+            disagreement.position = boundaries[boundaryIndex++];
+        } else {
+            referenceIndex++;
+            boundaryIndex++;
+            continue;
+        }
+
+        disagreements.append(disagreement);
+    }
+
+    return disagreements;
+}
+
+// The text around a boundary on one line, with the boundary marked by '|'.
+QString SegmenterHarness::getContext(const QString &text, int position,
+                                     int contextLength) {
+    const int contextStart = qMax(0, position - contextLength);
+    QString context = text.mid(contextStart, position - contextStart) + "|" +
+                      text.mid(position, contextLength);
+
+    return context.replace('\n', "\\n").replace('\t', "\\t");
+}
+
+QByteArray SegmenterHarness::getChecksum(const QString &text) {
+    return QCryptographicHash::hash(text.toUtf8(), QCryptographicHash::Sha1)
+        .toHex();
+}
+
+// A golden file names the text it belongs to by checksum, and the engine that
+// found its boundaries, followed by one boundary per line.
+bool SegmenterHarness::writeGolden(const QString &goldenPath,
+                                   const QString &text, const QString &engine,
+                                   const QVector<int> &boundaries) {
+    QFile goldenFile(goldenPath);
+    if (!goldenFile.open(QIODevice::WriteOnly | QIODevice::Text |
+                         QIODevice::Truncate))
+        return false;
+
+    QTextStream goldenOutput(&goldenFile);
+    goldenOutput << "text " << getChecksum(text) << '\n';
+    goldenOutput << "engine " << engine << '\n';
+    for (int boundary : boundaries)
+        goldenOutput << boundary << '\n';
+
+    goldenOutput.flush();
+    return goldenOutput.status() == QTextStream::Ok;
+}
+
+bool SegmenterHarness::readGolden(const QString &goldenPath,
+                                  const QString &text,
+                                  QVector<int> &boundaries, QString &engine,
+                                  QString &error) {
+    QFile goldenFile(goldenPath);
+    if (!goldenFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        error = "Could not open " + goldenPath;
+        return false;
+    }
+
+    const QList<QByteArray> lines = goldenFile.readAll().split('\n');
+    if (lines.size() < 2 || !lines[0].startsWith("text ") ||
+        !lines[1].startsWith("engine ")) {
+        error = goldenPath + " is not a golden boundary file";
+        return false;
+    }
+
+    if (lines[0].mid(5).trimmed() != getChecksum(text)) {
+        error = goldenPath + " was written for a different text";
+        return false;
+    }
+    engine = QString::fromUtf8(lines[1].mid(7).trimmed());
+
+    boundaries.clear();
+    for (int line = 2; line < lines.size(); line++) {
+        if (lines[line].trimmed().isEmpty())
+            continue;
+
+        bool isNumber = false;
+        boundaries.append(lines[line].trimmed().toInt(&isNumber));
+        if (!isNumber) {
+            error = goldenPath + " has a boundary that is not a number";
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,49 @@
+#ifndef SEGMENTERHARNESS_H
+#define SEGMENTERHARNESS_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+// Runs each way the program has of splitting a text into sentences over the
+// same text, so they can be compared with each other or with a golden file
+// one of them wrote before.
+//
+// Boundaries are where a sentence other than the first starts, counted in
+// UTF-16 characters into the text as read with its line endings made '\n'.
+// Every engine places the whitespace between sentences differently, so a
+// boundary is moved past any whitespace before it is compared.
+class SegmenterHarness {
+public:
+    // The program's own reading, through ParagraphReader.
+    static const QString readerEngine;
+    // QTextBoundaryFinder, through ParagraphRetriever.
+    static const QString retrieverEngine;
+    // NLTK's punkt tokenizer, through paragraphretriever.py.
+    static const QString nltkEngine;
+
+    // A boundary only one of two engines found.
+    struct Disagreement {
+        int position = 0;
+        bool isInReference = false;
+    };
+
+    static QString readText(const QString &);
+    static QVector<int> runReader(const QString &);
+    static QVector<int> runRetriever(const QString &);
+    static bool runNltk(const QString &, const QString &, const QString &,
+                        QVector<int> &, QString &);
+    static QVector<int> normalize(const QVector<int> &, const QString &);
+
+    static QVector<Disagreement> compare(const QVector<int> &,
+                                         const QVector<int> &);
+    static QString getContext(const QString &, int, int);
+
+    static QByteArray getChecksum(const QString &);
+    static bool writeGolden(const QString &, const QString &, const QString &,
+                            const QVector<int> &);
+    static bool readGolden(const QString &, const QString &, QVector<int> &,
+                           QString &, QString &);
+};
+
+#endif // SEGMENTERHARNESS_H
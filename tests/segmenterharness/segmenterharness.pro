@@ -0,0 +1,23 @@
+QT += testlib
+QT -= gui
+
+CONFIG += qt console warn_on depend_includepath testcase
+CONFIG -= app_bundle
+
+TEMPLATE = app
+
+SOURCES +=  tst_segmenterharnesstests.cpp \
+        ../segmenterdiff/segmenterharness.cpp \
+        ../../app/utilities/paragraphreader.cpp \
+        ../../app/utilities/paragraphcounter.cpp \
+        ../../app/utilities/chapterlist.cpp \
+        ../../app/utilities/paragraphretriever.cpp
+HEADERS += ../segmenterdiff/segmenterharness.h \
+        ../../app/utilities/paragraphreader.h \
+        ../../app/utilities/paragraphcounter.h \
+        ../../app/utilities/chapterlist.h \
+        ../../app/utilities/paragraphretriever.h
+INCLUDEPATH += \
+    ../segmenterdiff \
+    ../../app \
+    ../../app/utilities
@@ -0,0 +1,133 @@
+#include "segmenterharness.h"
+#include <QTemporaryDir>
+#include <QtTest>
+
+class SegmenterHarnessTests : public QObject {
+    Q_OBJECT
+
+public:
+    SegmenterHarnessTests();
+    ~SegmenterHarnessTests();
+
+private slots:
+    void testReaderMatchesGolden();
+    void testReaderAndRetrieverDisagree();
+
+    void testNormalize();
+    void testCompare();
+    void testGetContext();
+
+    void testGoldenRoundTrip();
+    void testGoldenOfOtherText();
+
+private:
+    QTemporaryDir goldenDir;
+};
+
+SegmenterHarnessTests::SegmenterHarnessTests() {}
+
+SegmenterHarnessTests::~SegmenterHarnessTests() {}
+
+// Any engine that replaces ParagraphReader has to split the sample the same
+// way, quirks included, before the program can narrate with it.
+void SegmenterHarnessTests::testReaderMatchesGolden() {
+    const QString textPath = QFINDTESTDATA("../segmenterdiff/sample.txt");
+    const QString goldenPath =
+        QFINDTESTDATA("../segmenterdiff/sample-reader.golden");
+    QVERIFY(!textPath.isEmpty() && !goldenPath.isEmpty());
+
+    const QString text = SegmenterHarness::readText(textPath);
+    QVector<int> goldenBoundaries;
+    QString engine;
+    QString error;
+    QVERIFY2(SegmenterHarness::readGolden(goldenPath, text, goldenBoundaries,
+                                          engine, error),
+             qPrintable(error));
+    QVERIFY(engine == SegmenterHarness::readerEngine);
+
+    const QVector<int> boundaries = SegmenterHarness::normalize(
+        SegmenterHarness::runReader(textPath), text);
+    const auto disagreements =
+        SegmenterHarness::compare(goldenBoundaries, boundaries);
+    QVERIFY2(disagreements.isEmpty(),
+             qPrintable(QString("First disagreement: %1")
+                            .arg(SegmenterHarness::getContext(
+                                text, disagreements.value(0).position, 20))));
+}
+
+void SegmenterHarnessTests::testReaderAndRetrieverDisagree() {
+    const QString textPath = QFINDTESTDATA("../segmenterdiff/sample.txt");
+    const QString text = SegmenterHarness::readText(textPath);
+
+    // Only the reader ends a sentence in "3.30", a character past the point.
+    const QVector<int> readerBoundaries = SegmenterHarness::normalize(
+        SegmenterHarness::runReader(textPath), text);
+    const QVector<int> retrieverBoundaries = SegmenterHarness::normalize(
+        SegmenterHarness::runRetriever(text), text);
+    const int inTime = text.indexOf("3.30") + 3;
+
+    QVERIFY(readerBoundaries.contains(inTime));
+    QVERIFY(!retrieverBoundaries.contains(inTime));
+    QVERIFY(!SegmenterHarness::compare(readerBoundaries, retrieverBoundaries)
+                 .isEmpty());
+}
+
+void SegmenterHarnessTests::testNormalize() {
+    const QString text = "  One.  Two.\nThree.  ";
+
+    // Ends of sentences, wherever their engine put the whitespace.
+    const QVector<int> boundaries = {1, 7, 8, 12, 20};
+    QVERIFY(SegmenterHarness::normalize(boundaries, text) ==
+            QVector<int>({8, 13}));
+}
+
+void SegmenterHarnessTests::testCompare() {
+    const auto disagreements =
+        SegmenterHarness::compare({10, 20, 30}, {10, 25, 30, 40});
+
+    QVERIFY(disagreements.size() == 3);
+    QVERIFY(disagreements[0].position == 20);
+    QVERIFY(disagreements[0].isInReference);
+    QVERIFY(disagreements[1].position == 25);
+    QVERIFY(!disagreements[1].isInReference);
+    QVERIFY(disagreements[2].position == 40);
+    QVERIFY(!disagreements[2].isInReference);
+}
+
+void SegmenterHarnessTests::testGetContext() {
+    QVERIFY(SegmenterHarness::getContext("One.\nTwo.", 5, 3) == "e.\\n|Two");
+    QVERIFY(SegmenterHarness::getContext("One. Two.", 0, 3) == "|One");
+}
+
+void SegmenterHarnessTests::testGoldenRoundTrip() {
+    const QString goldenPath = goldenDir.filePath("roundtrip.golden");
+    const QString text = "One. Two. Three.";
+
+    QVERIFY(SegmenterHarness::writeGolden(
+        goldenPath, text, SegmenterHarness::retrieverEngine, {5, 10}));
+
+    QVector<int> boundaries;
+    QString engine;
+    QString error;
+    QVERIFY(SegmenterHarness::readGolden(goldenPath, text, boundaries, engine,
+                                         error));
+    QVERIFY(boundaries == QVector<int>({5, 10}));
+    QVERIFY(engine == SegmenterHarness::retrieverEngine);
+}
+
+void SegmenterHarnessTests::testGoldenOfOtherText() {
+    const QString goldenPath = goldenDir.filePath("other.golden");
+    QVERIFY(SegmenterHarness::writeGolden(
+        goldenPath, "One. Two.", SegmenterHarness::readerEngine, {5}));
+
+    QVector<int> boundaries;
+    QString engine;
+    QString error;
+    QVERIFY(!SegmenterHarness::readGolden(goldenPath, "One. Two!", boundaries,
+                                          engine, error));
+    QVERIFY(!error.isEmpty());
+}
+
+QTEST_APPLESS_MAIN(SegmenterHarnessTests)
+
+#include "tst_segmenterharnesstests.moc"
@@ -0,0 +1,16 @@
+QT += testlib multimedia
+QT -= gui
+
+CONFIG += qt console warn_on depend_includepath testcase
+CONFIG -= app_bundle
+
+TEMPLATE = app
+
+SOURCES +=  tst_takebuffertests.cpp \
+        ../../app/utilities/takebuffer.cpp \
+        ../../app/utilities/waveheader.cpp
+HEADERS += ../../app/utilities/takebuffer.h \
+        ../../app/utilities/waveheader.h
+INCLUDEPATH += \
+    ../../app \
+    ../../app/utilities
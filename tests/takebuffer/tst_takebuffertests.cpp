@@ -0,0 +1,159 @@
+#include "takebuffer.h"
+#include "waveheader.h"
+#include <QAudioBuffer>
+#include <QAudioFormat>
+#include <QtTest>
+
+class TakeBufferTests : public QObject {
+    Q_OBJECT
+
+public:
+    TakeBufferTests();
+    ~TakeBufferTests();
+
+private slots:
+    void testTakeIsPlayable();
+    void testOnlyForItsLocation();
+    void testNotAvailableUntilFinished();
+    void testDiscardOversizedTake();
+    void testDiscardChangedFormat();
+    void testClear();
+
+private:
+    static QAudioFormat getFormat();
+    static QAudioBuffer makeBuffer(int, char);
+};
+
+TakeBufferTests::TakeBufferTests() {}
+
+TakeBufferTests::~TakeBufferTests() {}
+
+// 16-bit mono, as most microphones record.
+QAudioFormat TakeBufferTests::getFormat() {
+    QAudioFormat format;
+    format.setSampleRate(8000);
+    format.setChannelCount(1);
+    format.setSampleSize(16);
+    format.setSampleType(QAudioFormat::SignedInt);
+    format.setByteOrder(QAudioFormat::LittleEndian);
+    format.setCodec("audio/pcm");
+
+    return format;
+}
+
+QAudioBuffer TakeBufferTests::makeBuffer(int numBytes, char value) {
+    return QAudioBuffer(QByteArray(numBytes, value), getFormat());
+}
+
+// The take comes back as a WAV file holding every sample appended, in order.
+void TakeBufferTests::testTakeIsPlayable() {
+    const QUrl location = QUrl::fromLocalFile("/tmp/part0.wav");
+    TakeBuffer take;
+    take.start(location);
+    take.append(makeBuffer(1000, 1));
+    take.append(makeBuffer(600, 2));
+    take.finish();
+
+    QVERIFY(take.isAvailableFor(location));
+    QIODevice *device = take.device();
+    QVERIFY(device != nullptr);
+
+    WaveHeader header;
+    header.formatTag = 1;
+    header.channelCount = 1;
+    header.sampleRate = 8000;
+    header.byteRate = 16000;
+    header.blockAlign = 2;
+    header.bitsPerSample = 16;
+    header.dataSize = 1600;
+
+    const QByteArray wave = device->readAll();
+    QVERIFY(wave.size() == 44 + 1600);
+    QVERIFY(wave.left(44) == header.write());
+
+    QVERIFY(wave.mid(44, 1000) == QByteArray(1000, 1));
+    QVERIFY(wave.mid(1044) == QByteArray(600, 2));
+
+    // Each time the player asks, it reads from the start again.
+    QVERIFY(take.device()->readAll() == wave);
+}
+
+void TakeBufferTests::testOnlyForItsLocation() {
+    TakeBuffer take;
+    take.start(QUrl::fromLocalFile("/tmp/part0.wav"));
+    take.append(makeBuffer(100, 1));
+    take.finish();
+
+    QVERIFY(!take.isAvailableFor(QUrl::fromLocalFile("/tmp/part1.wav")));
+}
+
+void TakeBufferTests::testNotAvailableUntilFinished() {
+    const QUrl location = QUrl::fromLocalFile("/tmp/part0.wav");
+    TakeBuffer take;
+    take.start(location);
+    take.append(makeBuffer(100, 1));
+
+    QVERIFY(!take.isAvailableFor(location));
+    QVERIFY(take.device() == nullptr);
+
+    // A take without any audio is left to be played from disk.
+    TakeBuffer emptyTake;
+    emptyTake.start(location);
+    emptyTake.finish();
+    QVERIFY(!emptyTake.isAvailableFor(location));
+}
+
+// A take past the limit is dropped rather than cut short, and frees what it
+// held.
+void TakeBufferTests::testDiscardOversizedTake() {
+    const QUrl location = QUrl::fromLocalFile("/tmp/part0.wav");
+    TakeBuffer take(44 + 1000);
+    take.start(location);
+    take.append(makeBuffer(600, 1));
+    QVERIFY(take.getMemoryUsage() >= 644);
+
+    take.append(makeBuffer(600, 2));
+    take.append(makeBuffer(100, 3));
+    take.finish();
+
+    QVERIFY(!take.isAvailableFor(location));
+    QVERIFY(take.device() == nullptr);
+    QVERIFY(take.getMemoryUsage() <= 44);
+
+    // Exactly at the limit still fits.
+    take.start(location);
+    take.append(makeBuffer(1000, 1));
+    take.finish();
+    QVERIFY(take.isAvailableFor(location));
+    QVERIFY(take.device()->size() == 44 + 1000);
+}
+
+void TakeBufferTests::testDiscardChangedFormat() {
+    const QUrl location = QUrl::fromLocalFile("/tmp/part0.wav");
+    QAudioFormat stereo = getFormat();
+    stereo.setChannelCount(2);
+
+    TakeBuffer take;
+    take.start(location);
+    take.append(makeBuffer(100, 1));
+    take.append(QAudioBuffer(QByteArray(100, 2), stereo));
+    take.finish();
+
+    QVERIFY(!take.isAvailableFor(location));
+}
+
+void TakeBufferTests::testClear() {
+    const QUrl location = QUrl::fromLocalFile("/tmp/part0.wav");
+    TakeBuffer take;
+    take.start(location);
+    take.append(makeBuffer(100, 1));
+    take.finish();
+    take.clear();
+
+    QVERIFY(!take.isAvailableFor(location));
+    QVERIFY(take.getMemoryUsage() == 0);
+}
+
+QTEST_APPLESS_MAIN(TakeBufferTests)
+
+#include "tst_takebuffertests.moc"
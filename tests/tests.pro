@@ -1,14 +1,22 @@
-QT += testlib
-QT -= gui
+TEMPLATE = subdirs
 
-CONFIG += qt console warn_on depend_includepath testcase
-CONFIG -= app_bundle
-
-TEMPLATE = app
-
-SOURCES +=  tst_paragraphretrievertests.cpp \
-        ../app/utilities/paragraphretriever.cpp
-HEADERS += ../app/utilities/paragraphretriever.h
-INCLUDEPATH += \
-    ../app \
-    ../app/utilities
+SUBDIRS = paragraphretriever \
+    recordedpartstracker \
+    partspack \
+    recordingsplitter \
+    projectfile \
+    chapterlist \
+    projectjournal \
+    textbenchmarks \
+    segmenterdiff \
+    segmenterharness \
+    tracer \
+    diagnosticsreport \
+    audiocapabilities \
+    importedtext \
+    noisereducer \
+    paragraphclaims \
+    takebuffer \
+    partprober \
+    partcompressor \
+    narrationstats
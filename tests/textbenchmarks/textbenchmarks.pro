@@ -0,0 +1,24 @@
+QT += testlib
+QT -= gui
+
+# Built with the tests, but left out of `make check` since large corpora take
+# minutes. Run it on its own, as the top of the source file describes.
+CONFIG += qt console warn_on depend_includepath
+CONFIG -= app_bundle
+
+TEMPLATE = app
+
+SOURCES +=  tst_textbenchmarks.cpp \
+        ../../app/utilities/chapterlist.cpp \
+        ../../app/utilities/paragraphcounter.cpp \
+        ../../app/utilities/paragraphreader.cpp \
+        ../../app/utilities/paragraphretriever.cpp \
+        ../../app/utilities/projectfile.cpp
+HEADERS += ../../app/utilities/chapterlist.h \
+        ../../app/utilities/paragraphcounter.h \
+        ../../app/utilities/paragraphreader.h \
+        ../../app/utilities/paragraphretriever.h \
+        ../../app/utilities/projectfile.h
+INCLUDEPATH += \
+    ../../app \
+    ../../app/utilities
@@ -0,0 +1,469 @@
+#include "chapterlist.h"
+#include "paragraphcounter.h"
+#include "paragraphreader.h"
+#include "paragraphretriever.h"
+#include "projectfile.h"
+#include <QFile>
+#include <QHash>
+#include <QRandomGenerator>
+#include <QTemporaryDir>
+#include <QtTest>
+#include <functional>
+
+// Measures how both ways of reading a text hold up as books grow: the
+// ParagraphRetriever, which keeps the whole text in memory, and the file
+// path the program narrates from, which counts paragraphs with
+// ParagraphCounter and reads them with ParagraphReader. Saving and loading
+// a project of the same size are measured too.
+//
+// Corpora are generated once per run. Their sizes default to 1 and 16 MB;
+// set ND_BENCHMARK_SIZES to a comma separated list of megabytes, such as
+// 1,64,512,2048, for larger ones. QtTest writes results that other tools
+// can read when asked, for example:
+//   ./tst_textbenchmarks -o results.xml,xml
+//   ./tst_textbenchmarks -csv
+class TextBenchmarks : public QObject {
+    Q_OBJECT
+
+public:
+    TextBenchmarks();
+    ~TextBenchmarks();
+
+private slots:
+    void initTestCase();
+
+    void benchmarkRetrieverOpen_data();
+    void benchmarkRetrieverOpen();
+    void benchmarkRetrieverRandomParagraph_data();
+    void benchmarkRetrieverRandomParagraph();
+    void benchmarkRetrieverPeakMemory_data();
+    void benchmarkRetrieverPeakMemory();
+
+    void benchmarkFileOpen_data();
+    void benchmarkFileOpen();
+    void benchmarkFileRandomParagraph_data();
+    void benchmarkFileRandomParagraph();
+    void benchmarkFilePeakMemory_data();
+    void benchmarkFilePeakMemory();
+
+    void benchmarkProjectSave_data();
+    void benchmarkProjectSave();
+    void benchmarkProjectLoad_data();
+    void benchmarkProjectLoad();
+
+private:
+    enum Corpus { Ascii, Unicode, Dialogue };
+
+    // The retriever holds the whole text as UTF-16, and a QString cannot
+    // hold a gigabyte of characters.
+    static const int retrieverSizeLimitMb = 512;
+    static const int numSampledParagraphs = 1000;
+
+    QTemporaryDir corpusDir;
+    QVector<int> corpusSizesMb;
+    QHash<QString, QString> corpusPaths;
+
+    void addCorpusRows();
+    QString getCorpusPath(int, int);
+    static void writeCorpus(const QString &, Corpus, qint64);
+    static QString generateSentence(Corpus, QRandomGenerator &);
+
+    static QVector<qint64> findParagraphStarts(const QString &);
+    static QVector<int> sampleParagraphs(int);
+    static ProjectFile makeProject(const QString &);
+    static void measurePeakMemory(const std::function<void()> &);
+};
+
+TextBenchmarks::TextBenchmarks() {}
+
+TextBenchmarks::~TextBenchmarks() {}
+
+void TextBenchmarks::initTestCase() {
+    QVERIFY(corpusDir.isValid());
+
+    const QString sizes = qEnvironmentVariable("ND_BENCHMARK_SIZES", "1,16");
+    for (const QString &size : sizes.split(',', QString::SkipEmptyParts)) {
+        bool isNumber = false;
+        int sizeMb = size.trimmed().toInt(&isNumber);
+        if (isNumber && sizeMb > 0)
+            corpusSizesMb.append(qMin(sizeMb, 2048));
+    }
+
+    QVERIFY2(!corpusSizesMb.isEmpty(), "ND_BENCHMARK_SIZES has no sizes.");
+}
+
+void TextBenchmarks::benchmarkRetrieverOpen_data() { addCorpusRows(); }
+
+// Reading the text into memory and finding every sentence in it.
+void TextBenchmarks::benchmarkRetrieverOpen() {
+    QFETCH(int, corpus);
+    QFETCH(int, sizeMb);
+    if (sizeMb > retrieverSizeLimitMb)
+        QSKIP("The text is too large for ParagraphRetriever.");
+
+    const QString corpusPath = getCorpusPath(corpus, sizeMb);
+    QBENCHMARK {
+        QFile textFile(corpusPath);
+        QVERIFY(textFile.open(QIODevice::ReadOnly | QIODevice::Text));
+        ParagraphRetriever retriever(&textFile, 4);
+        QVERIFY(retriever.getNumParagraphs() > 0);
+    }
+}
+
+void TextBenchmarks::benchmarkRetrieverRandomParagraph_data() {
+    addCorpusRows();
+}
+
+// The retriever only finds paragraphs in order, so every one is read once
+// before paragraphs are asked for out of order.
+void TextBenchmarks::benchmarkRetrieverRandomParagraph() {
+    QFETCH(int, corpus);
+    QFETCH(int, sizeMb);
+    if (sizeMb > retrieverSizeLimitMb)
+        QSKIP("The text is too large for ParagraphRetriever.");
+
+    QFile textFile(getCorpusPath(corpus, sizeMb));
+    QVERIFY(textFile.open(QIODevice::ReadOnly | QIODevice::Text));
+    ParagraphRetriever retriever(&textFile, 4);
+
+    const int numPrgs = static_cast<int>(retriever.getNumParagraphs());
+    for (int prg = 0; prg < numPrgs; prg++)
+        retriever.getParagraph(prg);
+
+    const QVector<int> sampledPrgs = sampleParagraphs(numPrgs);
+    int nextSample = 0;
+    QBENCHMARK {
+        retriever.getParagraph(sampledPrgs[nextSample]);
+        nextSample = (nextSample + 1) % sampledPrgs.size();
+    }
+}
+
+void TextBenchmarks::benchmarkRetrieverPeakMemory_data() { addCorpusRows(); }
+
+void TextBenchmarks::benchmarkRetrieverPeakMemory() {
+    QFETCH(int, corpus);
+    QFETCH(int, sizeMb);
+    if (sizeMb > retrieverSizeLimitMb)
+        QSKIP("The text is too large for ParagraphRetriever.");
+
+    const QString corpusPath = getCorpusPath(corpus, sizeMb);
+    measurePeakMemory([corpusPath]() {
+        QFile textFile(corpusPath);
+        if (!textFile.open(QIODevice::ReadOnly | QIODevice::Text))
+            return;
+
+        ParagraphRetriever retriever(&textFile, 4);
+        retriever.getNumParagraphs();
+    });
+}
+
+void TextBenchmarks::benchmarkFileOpen_data() { addCorpusRows(); }
+
+// What the program does when a text without a project is opened: counting
+// its paragraphs, words and chapters in one pass.
+void TextBenchmarks::benchmarkFileOpen() {
+    QFETCH(int, corpus);
+    QFETCH(int, sizeMb);
+
+    const QString corpusPath = getCorpusPath(corpus, sizeMb);
+    const auto headingPatterns =
+        ChapterList::compilePatterns(ChapterList::getDefaultPatterns());
+    QBENCHMARK {
+        QFile textFile(corpusPath);
+        QVERIFY(textFile.open(QIODevice::ReadOnly | QIODevice::Text));
+        QTextStream textInput(&textFile);
+        textInput.setCodec("UTF-8");
+
+        auto counts = ParagraphCounter::countText(textInput, headingPatterns);
+        QVERIFY(counts.numPrgs > 0);
+    }
+}
+
+void TextBenchmarks::benchmarkFileRandomParagraph_data() { addCorpusRows(); }
+
+// Paragraphs are read from where a project remembers they start, which the
+// program learns by reading through the text once.
+void TextBenchmarks::benchmarkFileRandomParagraph() {
+    QFETCH(int, corpus);
+    QFETCH(int, sizeMb);
+
+    const QString corpusPath = getCorpusPath(corpus, sizeMb);
+    const QVector<qint64> prgStarts = findParagraphStarts(corpusPath);
+    QVERIFY(!prgStarts.isEmpty());
+
+    QFile textFile(corpusPath);
+    QVERIFY(textFile.open(QIODevice::ReadOnly | QIODevice::Text));
+    QTextStream textInput(&textFile);
+    textInput.setCodec("UTF-8");
+    ParagraphReader reader(textInput);
+
+    const QVector<int> sampledPrgs = sampleParagraphs(prgStarts.size());
+    int nextSample = 0;
+    QBENCHMARK {
+        qint64 location = prgStarts[sampledPrgs[nextSample]];
+        reader.readParagraph(location);
+        nextSample = (nextSample + 1) % sampledPrgs.size();
+    }
+}
+
+void TextBenchmarks::benchmarkFilePeakMemory_data() { addCorpusRows(); }
+
+void TextBenchmarks::benchmarkFilePeakMemory() {
+    QFETCH(int, corpus);
+    QFETCH(int, sizeMb);
+
+    const QString corpusPath = getCorpusPath(corpus, sizeMb);
+    measurePeakMemory([corpusPath]() {
+        QFile textFile(corpusPath);
+        if (!textFile.open(QIODevice::ReadOnly | QIODevice::Text))
+            return;
+
+        QTextStream textInput(&textFile);
+        textInput.setCodec("UTF-8");
+        ParagraphCounter::countText(
+            textInput,
+            ChapterList::compilePatterns(ChapterList::getDefaultPatterns()));
+    });
+}
+
+void TextBenchmarks::benchmarkProjectSave_data() { addCorpusRows(); }
+
+void TextBenchmarks::benchmarkProjectSave() {
+    QFETCH(int, corpus);
+    QFETCH(int, sizeMb);
+
+    const ProjectFile project = makeProject(getCorpusPath(corpus, sizeMb));
+    const QString projectPath = corpusDir.filePath("save.ndp");
+    QBENCHMARK { QVERIFY(project.save(projectPath)); }
+}
+
+void TextBenchmarks::benchmarkProjectLoad_data() { addCorpusRows(); }
+
+void TextBenchmarks::benchmarkProjectLoad() {
+    QFETCH(int, corpus);
+    QFETCH(int, sizeMb);
+
+    const ProjectFile project = makeProject(getCorpusPath(corpus, sizeMb));
+    const QString projectPath = corpusDir.filePath("load.ndp");
+    QVERIFY(project.save(projectPath));
+
+    QBENCHMARK {
+        ProjectFile loadedProject;
+        QVERIFY(loadedProject.load(projectPath));
+        QVERIFY(loadedProject.prgStarts.size() == project.prgStarts.size());
+    }
+}
+
+void TextBenchmarks::addCorpusRows() {
+    QTest::addColumn<int>("corpus");
+    QTest::addColumn<int>("sizeMb");
+
+    const QVector<std::pair<Corpus, const char *>> corpora = {
+        {Ascii, "ascii"}, {Unicode, "unicode"}, {Dialogue, "dialogue"}};
+    for (int sizeMb : corpusSizesMb) {
+        for (auto &corpus : corpora) {
+            const QByteArray rowName = QByteArray(corpus.second) + "-" +
+                                       QByteArray::number(sizeMb) + "MB";
+            QTest::newRow(rowName.constData())
+                << static_cast<int>(corpus.first) << sizeMb;
+        }
+    }
+}
+
+// Corpora are written the first time a benchmark needs them, and shared by
+// the rest.
+QString TextBenchmarks::getCorpusPath(int corpus, int sizeMb) {
+    const QString corpusName =
+        QString("corpus-%1-%2MB.txt").arg(corpus).arg(sizeMb);
+    if (corpusPaths.contains(corpusName))
+        return corpusPaths[corpusName];
+
+    const QString corpusPath = corpusDir.filePath(corpusName);
+    writeCorpus(corpusPath, static_cast<Corpus>(corpus),
+                static_cast<qint64>(sizeMb) * 1024 * 1024);
+    corpusPaths[corpusName] = corpusPath;
+
+    return corpusPath;
+}
+
+// Writes sentences in paragraphs of a few each until the file is as large as
+// asked. The same corpus is written every time.
+void TextBenchmarks::writeCorpus(const QString &corpusPath, Corpus corpus,
+                                 qint64 corpusSize) {
+    QFile corpusFile(corpusPath);
+    if (!corpusFile.open(QIODevice::WriteOnly | QIODevice::Text))
+        return;
+
+    QTextStream corpusOutput(&corpusFile);
+    corpusOutput.setCodec("UTF-8");
+    QRandomGenerator generator(static_cast<quint32>(corpus) + 1);
+
+    int chapter = 1;
+    while (corpusFile.size() < corpusSize) {
+        QString chunk = QString("Chapter %1\n\n").arg(chapter++);
+        while (chunk.size() < 64 * 1024) {
+            const int numSentences = generator.bounded(3, 7);
+            for (int sentence = 0; sentence < numSentences; sentence++)
+                chunk += generateSentence(corpus, generator);
+            chunk += "\n\n";
+        }
+
+        corpusOutput << chunk;
+        corpusOutput.flush();
+    }
+}
+
+QString TextBenchmarks::generateSentence(Corpus corpus,
+                                         QRandomGenerator &generator) {
+    static const QStringList asciiWords = {
+        "the",   "narrator", "read",    "a",     "long",  "chapter",
+        "about", "river",    "and",     "light", "voice", "slowly",
+        "house", "morning",  "quiet",   "every", "door",  "window",
+        "she",   "he",       "thought", "of",    "it",    "again"};
+    static const QStringList unicodeWords = {
+        "Привет", "мир",   "世界",    "こんにちは", "ありがとう",
+        "naïve",  "café",  "λόγος",   "Ελληνικά",   "שלום",
+        "مرحبا",  "🙂",    "📖",      "étoile",     "Straße",
+        "한국어", "दुनिया", "Ünïcödé", "ﬁnal",       "ÆØÅ"};
+    static const QStringList endings = {". ", ". ", ". ", "! ", "? ", "... "};
+    static const QStringList speakers = {"she said", "he asked",
+                                         "they whispered", "I answered"};
+
+    const QStringList &words = corpus == Unicode ? unicodeWords : asciiWords;
+    const int numWords = generator.bounded(5, 16);
+
+    QString sentence;
+    for (int word = 0; word < numWords; word++) {
+        if (word > 0)
+            sentence += ' ';
+        sentence += words[generator.bounded(words.size())];
+    }
+    sentence[0] = sentence[0].toUpper();
+
+    // Some scripts end sentences with marks the narrator does not split on.
+    if (corpus == Unicode && generator.bounded(4) == 0)
+        return sentence + "。";
+
+    const QString ending = endings[generator.bounded(endings.size())];
+    if (corpus != Dialogue || generator.bounded(3) == 0)
+        return sentence + ending;
+
+    const QString speaker = speakers[generator.bounded(speakers.size())];
+    switch (generator.bounded(3)) {
+    case 0:
+        return "\"" + sentence + ",\" " + speaker + ". ";
+    case 1:
+        return "“" + sentence + ending.trimmed() + "” ";
+    default:
+        return "'" + sentence + ending.trimmed() + "' " + speaker + ". ";
+    }
+}
+
+// Reads through the text the way the program does when the narrator moves
+// forward, noting where each paragraph starts.
+QVector<qint64> TextBenchmarks::findParagraphStarts(const QString &textPath) {
+    QVector<qint64> prgStarts;
+
+    QFile textFile(textPath);
+    if (!textFile.open(QIODevice::ReadOnly | QIODevice::Text))
+        return prgStarts;
+
+    QTextStream textInput(&textFile);
+    textInput.setCodec("UTF-8");
+    ParagraphReader reader(textInput);
+
+    qint64 location = 0;
+    while (true) {
+        textInput.seek(location);
+        if (textInput.atEnd())
+            break;
+
+        prgStarts.append(location);
+        reader.readParagraph(location);
+    }
+
+    return prgStarts;
+}
+
+// The same paragraphs are asked for on every run.
+QVector<int> TextBenchmarks::sampleParagraphs(int numPrgs) {
+    QRandomGenerator generator(numPrgs);
+
+    QVector<int> sampledPrgs;
+    for (int sample = 0; sample < numSampledParagraphs; sample++)
+        sampledPrgs.append(generator.bounded(qMax(numPrgs, 1)));
+
+    return sampledPrgs;
+}
+
+// A project that has been read all the way through. Paragraph starts are
+// spread evenly over the text, since only how many there are and how long
+// they are to write matters here.
+ProjectFile TextBenchmarks::makeProject(const QString &textPath) {
+    ProjectFile project;
+    project.textFilePath = textPath;
+    project.audioExtension = ".wav";
+
+    QFile textFile(textPath);
+    if (!textFile.open(QIODevice::ReadOnly | QIODevice::Text))
+        return project;
+
+    QTextStream textInput(&textFile);
+    textInput.setCodec("UTF-8");
+    auto counts = ParagraphCounter::countText(
+        textInput,
+        ChapterList::compilePatterns(ChapterList::getDefaultPatterns()));
+
+    project.prgNumTotal = counts.numPrgs;
+    project.wordCounts = counts.wordCounts;
+    project.chapters = counts.chapters;
+
+    const qint64 averagePrgSize = textFile.size() / qMax(counts.numPrgs, 1u);
+    for (uint prg = 0; prg < counts.numPrgs; prg++)
+        project.prgStarts.append(prg * averagePrgSize);
+    project.prgNum = static_cast<int>(counts.numPrgs) / 2;
+
+    return project;
+}
+
+#ifdef Q_OS_LINUX
+static qint64 readMemoryStatusKb(const QByteArray &field) {
+    QFile statusFile("/proc/self/status");
+    if (!statusFile.open(QIODevice::ReadOnly | QIODevice::Text))
+        return -1;
+
+    for (const QByteArray &line : statusFile.readAll().split('\n')) {
+        if (line.startsWith(field))
+            return line.mid(field.size()).trimmed().split(' ')[0].toLongLong();
+    }
+
+    return -1;
+}
+#endif
+
+// Reports how far what the process holds in memory rose while running, in
+// bytes. Only Linux can start measuring its peak over from the present.
+void TextBenchmarks::measurePeakMemory(const std::function<void()> &run) {
+#ifdef Q_OS_LINUX
+    QFile clearRefsFile("/proc/self/clear_refs");
+    if (!clearRefsFile.open(QIODevice::WriteOnly) ||
+        clearRefsFile.write("5") != 1) {
+        QSKIP("The peak memory of the process cannot be reset.");
+    }
+    clearRefsFile.close();
+
+    const qint64 baselineKb = readMemoryStatusKb("VmRSS:");
+    run();
+    const qint64 peakKb = readMemoryStatusKb("VmHWM:");
+
+    QTest::setBenchmarkResult(qMax<qint64>(0, peakKb - baselineKb) * 1024.0,
+                              QTest::BytesAllocated);
+#else
+    Q_UNUSED(run)
+    QSKIP("Peak memory is only measured on Linux.");
+#endif
+}
+
+QTEST_APPLESS_MAIN(TextBenchmarks)
+
+#include "tst_textbenchmarks.moc"
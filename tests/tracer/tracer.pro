@@ -0,0 +1,14 @@
+QT += testlib
+QT -= gui
+
+CONFIG += qt console warn_on depend_includepath testcase
+CONFIG -= app_bundle
+
+TEMPLATE = app
+
+SOURCES +=  tst_tracertests.cpp \
+        ../../app/utilities/tracer.cpp
+HEADERS += ../../app/utilities/tracer.h
+INCLUDEPATH += \
+    ../../app \
+    ../../app/utilities
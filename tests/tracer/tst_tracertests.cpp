@@ -0,0 +1,156 @@
+#include "tracer.h"
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+#include <QtTest>
+#include <thread>
+#include <vector>
+
+class TracerTests : public QObject {
+    Q_OBJECT
+
+public:
+    TracerTests();
+    ~TracerTests();
+
+private slots:
+    void init();
+    void cleanupTestCase();
+
+    void testDisabled();
+    void testScope();
+    void testBeginEnd();
+    void testThreads();
+    void testChromeTrace();
+    void testTraceAgain();
+
+private:
+    QTemporaryDir traceDir;
+};
+
+TracerTests::TracerTests() {}
+
+TracerTests::~TracerTests() {}
+
+// Turning tracing on again leaves out the events of the tests before.
+void TracerTests::init() {
+    Tracer::setEnabled(false);
+    Tracer::setEnabled(true);
+}
+
+void TracerTests::cleanupTestCase() { Tracer::setEnabled(false); }
+
+void TracerTests::testDisabled() {
+    Tracer::setEnabled(false);
+    { TraceScope traceScope("disabled"); }
+
+    qint64 startNs = Tracer::begin();
+    QVERIFY(startNs == -1);
+    Tracer::end("disabled", startNs);
+
+    QVERIFY(Tracer::getNumEvents() == 0);
+}
+
+void TracerTests::testScope() {
+    { TraceScope traceScope("scope"); }
+    QVERIFY(Tracer::getNumEvents() == 1);
+}
+
+void TracerTests::testBeginEnd() {
+    qint64 startNs = Tracer::begin();
+    QVERIFY(startNs >= 0);
+
+    Tracer::end("begin end", startNs);
+    QVERIFY(startNs == -1);
+
+    // Only the first end of an event records it.
+    Tracer::end("begin end", startNs);
+    QVERIFY(Tracer::getNumEvents() == 1);
+}
+
+void TracerTests::testThreads() {
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < 4; thread++) {
+        threads.emplace_back([]() {
+            for (int event = 0; event < 100; event++) {
+                TraceScope traceScope("thread");
+            }
+        });
+    }
+
+    for (auto &thread : threads)
+        thread.join();
+
+    QVERIFY(Tracer::getNumEvents() == 400);
+}
+
+void TracerTests::testChromeTrace() {
+    { TraceScope traceScope("export"); }
+
+    const QString tracePath = traceDir.filePath("trace.json");
+    QVERIFY(Tracer::writeChromeTrace(tracePath));
+
+    QFile traceFile(tracePath);
+    QVERIFY(traceFile.open(QIODevice::ReadOnly));
+    QJsonParseError parseError;
+    const QJsonDocument trace =
+        QJsonDocument::fromJson(traceFile.readAll(), &parseError);
+    QVERIFY2(parseError.error == QJsonParseError::NoError,
+             qPrintable(parseError.errorString()));
+
+    int numExported = 0;
+    bool hasThreadName = false;
+    for (const QJsonValue &value : trace.object()["traceEvents"].toArray()) {
+        const QJsonObject event = value.toObject();
+        if (event["name"].toString() == "thread_name")
+            hasThreadName = true;
+
+        if (event["name"].toString() == "export") {
+            numExported++;
+            QVERIFY(event["ph"].toString() == "X");
+            QVERIFY(event["ts"].toDouble() >= 0);
+            QVERIFY(event["dur"].toDouble() >= 0);
+        }
+    }
+
+    QVERIFY(numExported == 1);
+    QVERIFY(hasThreadName);
+}
+
+// A trace has room for as many events as the first, however many that one
+// dropped.
+void TracerTests::testTraceAgain() {
+    for (int event = 0; event < Tracer::eventsPerThread + 10; event++) {
+        const qint64 startNs = Tracer::now();
+        Tracer::record("full", startNs, Tracer::now());
+    }
+    QVERIFY(Tracer::getNumEvents() == Tracer::eventsPerThread);
+
+    Tracer::setEnabled(false);
+    Tracer::setEnabled(true);
+    { TraceScope traceScope("again"); }
+    QVERIFY(Tracer::getNumEvents() == 1);
+
+    const QString tracePath = traceDir.filePath("again.json");
+    QVERIFY(Tracer::writeChromeTrace(tracePath));
+
+    QFile traceFile(tracePath);
+    QVERIFY(traceFile.open(QIODevice::ReadOnly));
+    const QJsonObject trace =
+        QJsonDocument::fromJson(traceFile.readAll()).object();
+    QVERIFY(trace["otherData"].toObject()["droppedEvents"].toInt() == 0);
+
+    int numAgain = 0;
+    for (const QJsonValue &value : trace["traceEvents"].toArray()) {
+        const QString name = value.toObject()["name"].toString();
+        QVERIFY(name != "full");
+        if (name == "again")
+            numAgain++;
+    }
+    QVERIFY(numAgain == 1);
+}
+
+QTEST_APPLESS_MAIN(TracerTests)
+
+#include "tst_tracertests.moc"